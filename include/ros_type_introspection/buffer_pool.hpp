@@ -0,0 +1,263 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright 2016 Davide Faconti
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of Willow Garage, Inc. nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+********************************************************************/
+
+#ifndef ROS_INTROSPECTION_BUFFER_POOL_H
+#define ROS_INTROSPECTION_BUFFER_POOL_H
+
+#include <stdint.h>
+#include <cstring>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <boost/noncopyable.hpp>
+#include "ros_type_introspection/string.hpp"
+
+namespace RosIntrospection{
+
+/**
+ * @brief The BufferPool recycles the memory used to store serialized messages.
+ *
+ * Buffers are grouped in size classes (powers of two, from 256 bytes to max_buffer_size,
+ * at most 128 Mbytes and never more than max_cached_bytes). A released buffer is kept in the free list of its class, up to a
+ * maximum number per class and a maximum number of bytes in the whole pool, and it is
+ * returned by the next call to acquire() of the same class.
+ * Buffers larger than the biggest class are never cached.
+ *
+ * All the methods are thread-safe.
+ */
+class BufferPool: boost::noncopyable{
+public:
+
+  struct Statistics{
+    /// acquire() served by a cached buffer.
+    uint64_t hits;
+    /// acquire() that required a new allocation.
+    uint64_t misses;
+    /// released buffers stored for later use.
+    uint64_t recycled;
+    /// released buffers freed because the free list was full or too large.
+    uint64_t discarded;
+
+    double hitRate() const {
+      return (hits + misses) == 0 ? 0.0 : double(hits) / double(hits + misses);
+    }
+  };
+
+  explicit BufferPool(size_t max_cached_per_class = 32,
+                      size_t max_cached_bytes = 64*1024*1024,
+                      size_t max_buffer_size = MAX_CLASS_SIZE);
+
+  ~BufferPool();
+
+  /// The pool used by ShapeShifter. It is never destroyed.
+  static BufferPool& global();
+
+  /// Get a buffer of at least size bytes. Its actual capacity is stored in capacity.
+  uint8_t* acquire(size_t size, size_t* capacity);
+
+  /// Give back a buffer obtained with acquire().
+  void release(uint8_t* buffer, size_t capacity);
+
+  Statistics statistics() const;
+
+  void resetStatistics();
+
+  /// Free all the cached buffers.
+  void clear();
+
+  /// Total size of the buffers in the free lists.
+  size_t cachedBytes() const { return _cached_bytes; }
+
+  static const size_t MIN_CLASS_SIZE = 256;
+  static const size_t MAX_CLASS_SIZE = MIN_CLASS_SIZE << 19;
+
+private:
+
+  static const int    NUM_CLASSES = 20;
+
+  struct SizeClass{
+    std::mutex mutex;
+    std::vector<uint8_t*> free_list;
+  };
+
+  int sizeClass(size_t size) const;
+
+  size_t    _max_cached_per_class;
+  size_t    _max_cached_bytes;
+  int       _num_classes;
+  SizeClass _classes[NUM_CLASSES];
+
+  std::atomic<size_t>   _cached_bytes;
+
+  std::atomic<uint64_t> _hits;
+  std::atomic<uint64_t> _misses;
+  std::atomic<uint64_t> _recycled;
+  std::atomic<uint64_t> _discarded;
+};
+
+/**
+ * @brief Memory block obtained from a BufferPool and given back to it when destroyed.
+ * Its interface is a small subset of std::vector<uint8_t>.
+ */
+class PooledBuffer{
+public:
+
+  explicit PooledBuffer(BufferPool* pool = &BufferPool::global()):
+    _pool(pool), _data(nullptr), _size(0), _capacity(0) {}
+
+  PooledBuffer(const PooledBuffer& other);
+
+  PooledBuffer(PooledBuffer&& other);
+
+  PooledBuffer& operator=(PooledBuffer other);
+
+  ~PooledBuffer();
+
+  /// Old content is preserved, like std::vector::resize.
+  void resize(size_t new_size);
+
+  /// Set the size to zero. The memory is not released.
+  void clear() { _size = 0; }
+
+  uint8_t* data() { return _data; }
+  const uint8_t* data() const { return _data; }
+
+  size_t size() const { return _size; }
+  size_t capacity() const { return _capacity; }
+
+  friend void swap(PooledBuffer& a, PooledBuffer& b);
+
+private:
+  BufferPool* _pool;
+  uint8_t*    _data;
+  size_t      _size;
+  size_t      _capacity;
+};
+
+/**
+ * @brief Monotonic memory resource for the long strings of a message (see ROSTypeFlat::string_memory).
+ *
+ * allocate() takes the memory from a list of blocks and deallocate() does nothing.
+ * release() makes all the memory available again in O(1), keeping the blocks: the strings
+ * allocated before must not be read anymore (but they can still be destroyed).
+ *
+ * It is not thread-safe.
+ */
+class StringArena: public ssoX::memory_resource, boost::noncopyable{
+public:
+
+  explicit StringArena(size_t block_size = 4096);
+
+  ~StringArena();
+
+  void* allocate(size_t bytes) override;
+
+  void deallocate(void*, size_t) override {}
+
+  /// Reuse all the memory from the first block.
+  void release();
+
+  /// Total size of the blocks.
+  size_t capacity() const { return _capacity; }
+
+private:
+  struct Block{
+    uint8_t* data;
+    size_t   size;
+  };
+  std::vector<Block> _blocks;
+  size_t _current;
+  size_t _offset;
+  size_t _block_size;
+  size_t _capacity;
+};
+
+//----------------------- Implementation ----------------------------------------------
+
+inline PooledBuffer::PooledBuffer(const PooledBuffer &other):
+  PooledBuffer( other._pool )
+{
+  resize( other._size );
+  if( _size > 0 ) {
+    memcpy( _data, other._data, _size );
+  }
+}
+
+inline PooledBuffer::PooledBuffer(PooledBuffer &&other):
+  PooledBuffer( other._pool )
+{
+  swap( *this, other );
+}
+
+inline PooledBuffer &PooledBuffer::operator=(PooledBuffer other)
+{
+  swap( *this, other );
+  return *this;
+}
+
+inline PooledBuffer::~PooledBuffer()
+{
+  if( _data ) {
+    _pool->release( _data, _capacity );
+  }
+}
+
+inline void PooledBuffer::resize(size_t new_size)
+{
+  if( new_size > _capacity )
+  {
+    size_t new_capacity = 0;
+    uint8_t* new_data = _pool->acquire( new_size, &new_capacity );
+    if( _data )
+    {
+      memcpy( new_data, _data, _size );
+      _pool->release( _data, _capacity );
+    }
+    _data = new_data;
+    _capacity = new_capacity;
+  }
+  _size = new_size;
+}
+
+inline void swap(PooledBuffer &a, PooledBuffer &b)
+{
+  std::swap( a._pool, b._pool );
+  std::swap( a._data, b._data );
+  std::swap( a._size, b._size );
+  std::swap( a._capacity, b._capacity );
+}
+
+} //end namespace
+
+#endif // ROS_INTROSPECTION_BUFFER_POOL_H
@@ -53,6 +53,7 @@ template <typename T> BuiltinType getType()
 }
 
 template <> inline BuiltinType getType<bool>()  {  return BOOL; }
+template <> inline BuiltinType getType<char>()  {  return CHAR; }
 
 template <> inline BuiltinType getType<int8_t>()  {  return INT8; }
 template <> inline BuiltinType getType<int16_t>() {  return INT16; }
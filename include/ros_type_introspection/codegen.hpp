@@ -0,0 +1,65 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright 2016 Davide Faconti
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of Willow Garage, Inc. nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+********************************************************************/
+
+
+#ifndef ROS_INTROSPECTION_CODEGEN_H
+#define ROS_INTROSPECTION_CODEGEN_H
+
+#include <ostream>
+#include "ros_type_introspection/parser.hpp"
+
+namespace RosIntrospection{
+
+/**
+ * @brief Write a C++ header with a decoder specialized for the given type, that is equivalent
+ * to buildRosFlatType. It is used by the tool ros_introspection_codegen.
+ *
+ * In the generated code every field is read at an offset known at compile time (relative
+ * to the last array or string), nested messages and small arrays with a fixed size are unrolled,
+ * and the nodes of the tree are addressed by position.
+ *
+ * Including the header registers the decoder in DecoderRegistry::global(); after that,
+ * buildRosFlatType(const MessageSchema&, ...) uses it for the schemas with the same MD5 and name.
+ *
+ * Throws std::runtime_error if the type list is not complete or the type has more than
+ * 7 nested arrays.
+ */
+void generateDecoder(const ROSTypeList& type_list,
+                     const ROSType& type,
+                     const std::string& md5sum,
+                     std::ostream& output);
+
+} //end namespace
+
+#endif // ROS_INTROSPECTION_CODEGEN_H
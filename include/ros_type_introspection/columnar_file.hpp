@@ -0,0 +1,173 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright 2016 Davide Faconti
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of Willow Garage, Inc. nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+********************************************************************/
+
+#ifndef ROS_INTROSPECTION_COLUMNAR_FILE_H
+#define ROS_INTROSPECTION_COLUMNAR_FILE_H
+
+#include <unordered_map>
+#include <boost/noncopyable.hpp>
+#include <boost/utility/string_ref.hpp>
+#include "ros_type_introspection/renamer.hpp"
+
+namespace RosIntrospection{
+
+/**
+ * @brief The ColumnarFileWriter collects the flattened values of many messages and
+ * stores them into a compact binary file, with one column for each key.
+ *
+ * The keys are either the names of the StringTreeLeaf(s) of a ROSTypeFlat or the
+ * names produced by applyNameTransform. Each column has its own timestamps,
+ * because a key might be missing in some of the messages.
+ *
+ * The layout of the file is (little endian, every block aligned to 8 bytes):
+ *
+ *  - file header: magic number, version and number of columns.
+ *  - dictionary: for each column, its name, its BuiltinType, the number of samples
+ *    and the offsets of its data blocks.
+ *  - data: for each column, the timestamps (float64) followed by the values,
+ *    stored with the native width of the BuiltinType.
+ *
+ * Use ColumnarFileReader to load it back.
+ */
+class ColumnarFileWriter{
+public:
+
+  ColumnarFileWriter() {}
+
+  /// Append the values of a single message, usually the output of applyNameTransform.
+  void append(double timestamp, const RenamedValues& values);
+
+  /// Append the values of a single message, using the names of the leaves as keys.
+  /// The elements of ROSTypeFlat::numeric_arrays are stored as FLOAT64, the type of array_values.
+  void append(double timestamp, const ROSTypeFlat& flat_container);
+
+  /// Number of columns (distinct keys) collected so far.
+  size_t columnCount() const { return _columns.size(); }
+
+  /// Write the content into a file. Throws std::runtime_error if it fails.
+  void save(const std::string& filename) const;
+
+  /// Remove all the columns.
+  void clear();
+
+private:
+
+  struct Column{
+    std::string name;
+    BuiltinType type;
+    std::vector<double>  timestamps;
+    std::vector<uint8_t> values;
+  };
+
+  void appendValue(double timestamp, const std::string& key, const VarNumber& value);
+
+  std::vector<Column> _columns;
+  std::unordered_map<std::string, size_t> _column_index;
+  std::string _key_buffer;
+};
+
+/**
+ * @brief A column of a file opened with ColumnarFileReader.
+ * The data is not copied; the pointers refer to the memory mapped file and they are
+ * valid as long as the reader exists.
+ */
+class ColumnView{
+public:
+
+  /// Name of the column (the key used by ColumnarFileWriter).
+  boost::string_ref name() const { return _name; }
+
+  BuiltinType type() const { return _type; }
+
+  /// Number of samples.
+  size_t size() const { return _size; }
+
+  /// Array of size() timestamps.
+  const double* timestamps() const { return _timestamps; }
+
+  /// Array of size() values. T must match type(), otherwise TypeException is thrown.
+  template <typename T> const T* values() const;
+
+  /// Value of a single sample, whatever its type is.
+  VarNumber value(size_t index) const;
+
+  friend class ColumnarFileReader;
+
+private:
+  boost::string_ref _name;
+  BuiltinType       _type;
+  size_t            _size;
+  const double*     _timestamps;
+  const uint8_t*    _values;
+};
+
+/**
+ * @brief The ColumnarFileReader memory-maps a file created by ColumnarFileWriter.
+ * Only the dictionary is read when the file is opened; the columns are accessed
+ * directly from the mapped memory.
+ */
+class ColumnarFileReader: boost::noncopyable{
+public:
+
+  /// Throws std::runtime_error if the file can't be opened or it is not valid.
+  ColumnarFileReader(const std::string& filename);
+
+  ~ColumnarFileReader();
+
+  const std::vector<ColumnView>& columns() const { return _columns; }
+
+  /// Find a column by name. Returns nullptr if it doesn't exist.
+  const ColumnView* column(const boost::string_ref& name) const;
+
+private:
+  const uint8_t* _data;
+  size_t         _file_size;
+  std::vector<ColumnView> _columns;
+};
+
+//----------------------- Implementation ----------------------------------------------
+
+template <typename T> inline
+const T* ColumnView::values() const
+{
+  if( getType<T>() != _type )
+  {
+    throw TypeException("ColumnView::values -> wrong type");
+  }
+  return reinterpret_cast<const T*>( _values );
+}
+
+} //end namespace
+
+#endif // ROS_INTROSPECTION_COLUMNAR_FILE_H
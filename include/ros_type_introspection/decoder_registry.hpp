@@ -0,0 +1,140 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright 2016 Davide Faconti
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of Willow Garage, Inc. nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+********************************************************************/
+
+
+#ifndef ROS_INTROSPECTION_DECODER_REGISTRY_H
+#define ROS_INTROSPECTION_DECODER_REGISTRY_H
+
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <unordered_map>
+#include <boost/noncopyable.hpp>
+#include "ros_type_introspection/deserializer.hpp"
+
+namespace RosIntrospection{
+
+/**
+ * @brief Decoder created by ros_introspection_codegen for a specific type (see codegen.hpp).
+ * It has the same behavior of buildRosFlatType; the type list is the one of the schema
+ * and it is used only to build the tree.
+ */
+typedef void (*GeneratedDecoder)(const ROSTypeList& type_list,
+                                 SString prefix,
+                                 uint8_t* buffer_ptr,
+                                 ROSTypeFlat* flat_container_output,
+                                 const uint32_t max_array_size);
+
+/**
+ * @brief Thread-safe list of the generated decoders, identified by MD5 and name of the type.
+ *
+ * buildRosFlatType(const MessageSchema&, ...) uses a registered decoder, if available,
+ * instead of the generic one.
+ */
+class DecoderRegistry: boost::noncopyable{
+public:
+
+  DecoderRegistry(): _size(0) {}
+
+  /// The instance used by buildRosFlatType. The generated headers register their decoder here.
+  static DecoderRegistry& global();
+
+  /// Add a decoder. If there is already one for the same type, it is replaced.
+  void add(const std::string& md5sum, const std::string& datatype, GeneratedDecoder decoder);
+
+  /// Return nullptr if there is no decoder for this type.
+  GeneratedDecoder find(const std::string& md5sum, const std::string& datatype) const;
+
+  void remove(const std::string& md5sum, const std::string& datatype);
+
+  size_t size() const { return _size.load(std::memory_order_relaxed); }
+
+private:
+  mutable std::mutex _mutex;
+  // the MD5 doesn't include the name of the type (see SchemaCache)
+  std::unordered_map<std::string, std::vector<std::pair<std::string,GeneratedDecoder>>> _decoders;
+  std::atomic<size_t> _size;
+};
+
+/// Static object used by the generated headers to register their decoder.
+struct DecoderRegistration{
+  DecoderRegistration(const char* md5sum, const char* datatype, GeneratedDecoder decoder)
+  {
+    DecoderRegistry::global().add( md5sum, datatype, decoder );
+  }
+};
+
+/// Helpers of the generated code.
+namespace GeneratedCode{
+
+template <typename T> inline T load(const uint8_t* ptr)
+{
+  T value;
+  memcpy( &value, ptr, sizeof(T) );
+  return value;
+}
+
+inline ros::Time loadTime(const uint8_t* ptr)
+{
+  ros::Time time;
+  time.sec  = load<uint32_t>( ptr );
+  time.nsec = load<uint32_t>( ptr + 4 );
+  return time;
+}
+
+inline StringTreeLeaf leaf(const StringTreeLeaf& parent, StringTreeNode* node)
+{
+  StringTreeLeaf output = parent;
+  output.node_ptr = node;
+  return output;
+}
+
+inline const uint8_t* storeString(const uint8_t* ptr, const StringTreeLeaf& leaf, ROSTypeFlat* flat_container)
+{
+  const uint32_t size = load<uint32_t>( ptr );
+  flat_container->name.emplace_back( leaf, SString( reinterpret_cast<const char*>(ptr + 4), size,
+                                                       flat_container->string_memory ) );
+  return ptr + 4 + size;
+}
+
+inline const uint8_t* skipString(const uint8_t* ptr)
+{
+  return ptr + 4 + load<uint32_t>( ptr );
+}
+
+} // end namespace GeneratedCode
+
+} //end namespace
+
+#endif // ROS_INTROSPECTION_DECODER_REGISTRY_H
@@ -40,6 +40,7 @@
 #include "ros_type_introspection/parser.hpp"
 #include "ros_type_introspection/stringtree.hpp"
 #include "ros_type_introspection/variant.hpp"
+#include "ros_type_introspection/statistics.hpp"
 
 
 namespace RosIntrospection{
@@ -84,6 +85,29 @@ struct StringTreeLeaf{
   std::string toStdString() { std::string out; toStr(out); return out; }
 };
 
+/**
+ * @brief Array of numbers stored in a single step by buildRosFlatType, when
+ * ROSTypeFlat::bulk_numeric_arrays is enabled.
+ */
+struct NumericArray{
+  /// Leaf of the first element of the array.
+  StringTreeLeaf leaf;
+  BuiltinType type;
+  /// Position of the first element in ROSTypeFlat::array_values.
+  uint32_t first;
+  uint32_t size;
+  /// Serialized elements, inside the buffer passed to buildRosFlatType (valid as long as the buffer is).
+  const uint8_t* data;
+
+  /// Leaf of the i-th element.
+  StringTreeLeaf leafAt(uint32_t index) const
+  {
+    StringTreeLeaf output = leaf;
+    output.index_array[ output.array_size-1 ] = static_cast<uint16_t>(index);
+    return output;
+  }
+};
+
 typedef struct{
   /// Tree that the StringTreeLeaf(s) refer to.
   StringTree tree;
@@ -99,6 +123,36 @@ typedef struct{
   // Not used yet
   std::vector< std::pair<StringTreeLeaf, std::vector<uint8_t>>> blob;
 
+  /// If true, the arrays of numbers (but not time or duration) are stored in numeric_arrays
+  /// and array_values instead of value. Note that applyNameTransform ignores them.
+  bool bulk_numeric_arrays = false;
+
+  /// If not null, the strings of name that don't fit in SString's internal buffer are allocated
+  /// here instead of the heap; for instance a StringArena released before each message.
+  ssoX::memory_resource* string_memory = nullptr;
+
+  /// Arrays of numbers, if bulk_numeric_arrays is true.
+  std::vector<NumericArray> numeric_arrays;
+
+  /// Elements of all the numeric_arrays, converted to double.
+  std::vector<double> array_values;
+
+  /// Number of arrays that were not stored because they have more than max_array_size elements.
+  uint32_t skipped_arrays = 0;
+
+  /// Type and ROSTypeList::id() of the type list used to build the tree. If buildRosFlatType is
+  /// called again with the same ones (and the same prefix), the tree is reused instead of being
+  /// created from scratch. Lists that were never indexed (id 0) don't reuse the tree.
+  SString tree_type;
+  uint64_t tree_type_list_id = 0;
+
+  /// True if the tree contains all the nodes of tree_type (see buildFlatTree), including
+  /// the ones of empty or skipped arrays.
+  bool tree_complete = false;
+
+  /// Counters of tree_type in DecodeStatistics::global(). Set only if the statistics are enabled.
+  TypeCounters* statistics = nullptr;
+
 }ROSTypeFlat;
 
 
@@ -124,8 +178,11 @@ typedef struct{
  * @param type        The main type that correspond to this serialized data.
  * @param prefix      prefix to add to the name (actually, the root of StringTree).
  * @param buffer_ptr  Pointer to the first element of the serialized data.
- * @param flat_container_output  output. It is recommended to reuse the same object if possible to reduce the amount of memory allocation.
- * @param max_array_size all the vectors that contains more elements than max_array_size will be discarted.
+ * @param flat_container_output  output. It is recommended to reuse the same object if possible to reduce the amount of memory allocation;
+ *                               once it has been "warmed up", decoding messages of the same type doesn't allocate any memory
+ *                               (unless a string exceeds the capacity of the small string optimization).
+ * @param max_array_size all the vectors that contains more elements than max_array_size will be discarted
+ *                       (see ROSTypeFlat::skipped_arrays and TypeStatistics::skipped_arrays).
  */
 void buildRosFlatType(const ROSTypeList& type_map,
                       ROSType type,
@@ -134,6 +191,31 @@ void buildRosFlatType(const ROSTypeList& type_map,
                       ROSTypeFlat* flat_container_output,
                       const uint32_t max_array_size );
 
+/**
+ * @brief Store an array of numbers in ROSTypeFlat::numeric_arrays (see bulk_numeric_arrays).
+ *
+ * @param leaf    leaf of the first element.
+ * @param type    a type accepted by details::isBulkConvertible.
+ * @return pointer to the end of the array.
+ */
+const uint8_t* appendNumericArray(const StringTreeLeaf& leaf,
+                                  BuiltinType type,
+                                  uint32_t size,
+                                  const uint8_t* buffer_ptr,
+                                  ROSTypeFlat* flat_container_output);
+
+/**
+ * @brief Create in ROSTypeFlat::tree all the nodes of the type, unless they are already there.
+ * Used by the generated decoders (see codegen.hpp), that refer to the nodes by their position.
+ *
+ * The values and names in flat_container_output must be cleared by the caller, because they
+ * might refer to the old tree.
+ */
+void buildFlatTree(const ROSTypeList& type_map,
+                   const ROSType& type,
+                   SString prefix,
+                   ROSTypeFlat* flat_container_output);
+
 
 inline std::ostream& operator<<(std::ostream &os, const StringTreeLeaf& leaf )
 {
@@ -166,8 +248,8 @@ inline int print_number(char* buffer, uint16_t value)
     }
     else if (value < 100) {
         value *= 2;
-        buffer[0] = DIGITS[ value+1 ];
-        buffer[1] = DIGITS[ value ];
+        buffer[0] = DIGITS[ value ];
+        buffer[1] = DIGITS[ value+1 ];
         return 2;
     }
     else{
@@ -0,0 +1,148 @@
+#ifndef ROS_INTROSPECTION_BULK_CONVERSION_H
+#define ROS_INTROSPECTION_BULK_CONVERSION_H
+
+#include <stdint.h>
+#include <cstring>
+#include <ros_type_introspection/builtin_types.hpp>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+/*
+ * Conversion of arrays of serialized numbers to double, used by buildRosFlatType when
+ * ROSTypeFlat::bulk_numeric_arrays is enabled.
+ *
+ * SSE2 (always available on x86-64) is used for float32, int16, uint16 and int32,
+ * AVX when it is enabled by the compiler flags (for instance -mavx2 or -march=native).
+ * The other types, the tail of the arrays and the other architectures use a scalar loop.
+ */
+
+namespace RosIntrospection
+{
+
+namespace details{
+
+/// Types supported by convertToDouble.
+inline bool isBulkConvertible(BuiltinType type)
+{
+  return type <= FLOAT64;
+}
+
+template <typename T>
+inline void convertToDoubleScalar(const uint8_t* src, size_t count, double* dst)
+{
+  for (size_t i=0; i<count; i++)
+  {
+    T value;
+    memcpy( &value, src + i*sizeof(T), sizeof(T) );
+    dst[i] = static_cast<double>(value);
+  }
+}
+
+inline void convertFloat32ToDouble(const uint8_t* src, size_t count, double* dst)
+{
+  size_t i = 0;
+#if defined(__AVX__)
+  for (; i + 4 <= count; i += 4)
+  {
+    const __m128 values = _mm_loadu_ps( reinterpret_cast<const float*>(src + i*4) );
+    _mm256_storeu_pd( dst + i, _mm256_cvtps_pd(values) );
+  }
+#elif defined(__SSE2__)
+  for (; i + 4 <= count; i += 4)
+  {
+    const __m128 values = _mm_loadu_ps( reinterpret_cast<const float*>(src + i*4) );
+    _mm_storeu_pd( dst + i,     _mm_cvtps_pd(values) );
+    _mm_storeu_pd( dst + i + 2, _mm_cvtps_pd( _mm_movehl_ps(values, values) ) );
+  }
+#endif
+  convertToDoubleScalar<float>( src + i*4, count - i, dst + i );
+}
+
+#if defined(__SSE2__)
+// convert four int32 to double
+inline void storeInt32AsDouble(__m128i values, double* dst)
+{
+#if defined(__AVX__)
+  _mm256_storeu_pd( dst, _mm256_cvtepi32_pd(values) );
+#else
+  _mm_storeu_pd( dst,     _mm_cvtepi32_pd(values) );
+  _mm_storeu_pd( dst + 2, _mm_cvtepi32_pd( _mm_shuffle_epi32(values, 0xEE) ) );
+#endif
+}
+#endif
+
+inline void convertInt32ToDouble(const uint8_t* src, size_t count, double* dst)
+{
+  size_t i = 0;
+#if defined(__SSE2__)
+  for (; i + 4 <= count; i += 4)
+  {
+    storeInt32AsDouble( _mm_loadu_si128( reinterpret_cast<const __m128i*>(src + i*4) ), dst + i );
+  }
+#endif
+  convertToDoubleScalar<int32_t>( src + i*4, count - i, dst + i );
+}
+
+template <bool IS_SIGNED>
+inline void convert16ToDouble(const uint8_t* src, size_t count, double* dst)
+{
+  size_t i = 0;
+#if defined(__SSE2__)
+  for (; i + 8 <= count; i += 8)
+  {
+    const __m128i values = _mm_loadu_si128( reinterpret_cast<const __m128i*>(src + i*2) );
+    __m128i low, high;
+    if( IS_SIGNED )
+    {
+      // duplicate each value in the upper half, then shift back to extend the sign
+      low  = _mm_srai_epi32( _mm_unpacklo_epi16(values, values), 16 );
+      high = _mm_srai_epi32( _mm_unpackhi_epi16(values, values), 16 );
+    }
+    else{
+      low  = _mm_unpacklo_epi16( values, _mm_setzero_si128() );
+      high = _mm_unpackhi_epi16( values, _mm_setzero_si128() );
+    }
+    storeInt32AsDouble( low,  dst + i );
+    storeInt32AsDouble( high, dst + i + 4 );
+  }
+#endif
+  if( IS_SIGNED ) {
+    convertToDoubleScalar<int16_t>( src + i*2, count - i, dst + i );
+  }
+  else{
+    convertToDoubleScalar<uint16_t>( src + i*2, count - i, dst + i );
+  }
+}
+
+/**
+ * @brief Convert count serialized numbers of the given type to double.
+ * Only the types accepted by isBulkConvertible are supported; the others are ignored.
+ */
+inline void convertToDouble(BuiltinType type, const uint8_t* src, size_t count, double* dst)
+{
+  switch( type )
+  {
+  case BOOL:    convertToDoubleScalar<bool>( src, count, dst ); break;
+  case BYTE:
+  case INT8:    convertToDoubleScalar<int8_t>( src, count, dst ); break;
+  case CHAR:
+  case UINT8:   convertToDoubleScalar<uint8_t>( src, count, dst ); break;
+  case UINT16:  convert16ToDouble<false>( src, count, dst ); break;
+  case UINT32:  convertToDoubleScalar<uint32_t>( src, count, dst ); break;
+  case UINT64:  convertToDoubleScalar<uint64_t>( src, count, dst ); break;
+  case INT16:   convert16ToDouble<true>( src, count, dst ); break;
+  case INT32:   convertInt32ToDouble( src, count, dst ); break;
+  case INT64:   convertToDoubleScalar<int64_t>( src, count, dst ); break;
+  case FLOAT32: convertFloat32ToDouble( src, count, dst ); break;
+  case FLOAT64: memcpy( dst, src, count * sizeof(double) ); break;
+  default: break;
+  }
+}
+
+} //end namespace details
+
+} //end namespace
+
+#endif // ROS_INTROSPECTION_BULK_CONVERSION_H
@@ -115,48 +115,48 @@ struct integer_to_floating_conversion
         && std::is_floating_point<To>::value >
 {};
 
-template <typename From, typename To>
-inline void checkUpperLimit(const From& from)
-{
-    if ((sizeof(To) < sizeof(From)) &&
-        (from > static_cast<From>(std::numeric_limits<To>::max()))) {
-        throw RangeException("Value too large.");
-    }
-    else if (static_cast<To>(from) > std::numeric_limits<To>::max()) {
-        throw RangeException("Value too large.");
-    }
-}
-
-template <typename From, typename To>
-inline void checkUpperLimitFloat(const From& from)
+/// Outcome of try_convert_impl. convert_impl turns the errors into a RangeException.
+enum ConversionResult{
+  CONVERSION_OK = 0,
+  VALUE_TOO_LARGE,
+  VALUE_TOO_SMALL,
+  VALUE_NEGATIVE,
+  VALUE_TRUNCATED,
+  VALUE_NOT_A_NUMBER
+};
+
+[[noreturn]] inline void throwConversionError(ConversionResult result)
 {
-  if (from > std::numeric_limits<To>::max()){
-    throw RangeException("Value too large.");
+  switch( result )
+  {
+  case VALUE_TOO_LARGE:    throw RangeException("Value too large.");
+  case VALUE_TOO_SMALL:    throw RangeException("Value too small.");
+  case VALUE_NEGATIVE:     throw RangeException("Value is negative and can't be converted to signed");
+  case VALUE_TRUNCATED:    throw RangeException("Floating point truncated");
+  case VALUE_NOT_A_NUMBER: throw RangeException("NaN can't be converted to an integer");
+  default:                 throw RangeException("Conversion failed");
   }
 }
 
+// "from" must not be negative.
 template <typename From, typename To>
-inline void checkLowerLimitFloat(const From& from)
+inline bool exceedsUpperLimit(const From& from)
 {
-    if (from < -std::numeric_limits<To>::max()){
-        throw RangeException("Value too small.");
-    }
+  return static_cast<uint64_t>(from) > static_cast<uint64_t>(std::numeric_limits<To>::max());
 }
 
+// 2^N, where N is the number of value bits of the integer To. It is the smallest
+// floating point value that doesn't fit in To, and it is always represented exactly.
 template <typename From, typename To>
-inline void checkLowerLimit(const From& from)
+inline From floatUpperBound()
 {
-  if (from < std::numeric_limits<To>::min()){
-    throw RangeException("Value too small.");
-  }
+  return static_cast<From>( std::numeric_limits<To>::max() / 2 + 1 ) * From(2);
 }
 
 template <typename From, typename To>
-inline void checkTruncation(const From& from)
+inline bool isTruncated(const From& from)
 {
-  if( from != static_cast<From>(static_cast<To>( from))){
-    throw RangeException("Floating point truncated");
-  }
+  return from != static_cast<From>(static_cast<To>( from));
 }
 
 
@@ -164,126 +164,167 @@ inline void checkTruncation(const From& from)
 
 template<typename SRC,typename DST,
          typename details::EnableIf< details::is_safe_integer_conversion<SRC, DST>>* = nullptr >
-inline void convert_impl( const SRC& from, DST& target )
+inline ConversionResult try_convert_impl( const SRC& from, DST& target )
 {
-    //std::cout << "is_safe_integer_conversion" << std::endl;
     target = static_cast<DST>( from);
+    return CONVERSION_OK;
 }
 
 template<typename SRC,typename DST,
          typename details::EnableIf< details::float_conversion<SRC, DST>>* = nullptr >
-inline void convert_impl( const SRC& from, DST& target )
+inline ConversionResult try_convert_impl( const SRC& from, DST& target )
 {
-    //std::cout << "float_conversion" << std::endl;
-    checkTruncation<SRC,DST>(from);
+    // NaN is valid in any floating point type
+    if( from == from && (from > std::numeric_limits<DST>::max() ||
+                         from < -std::numeric_limits<DST>::max() ||
+                         isTruncated<SRC,DST>(from)) )
+    {
+      return VALUE_TRUNCATED;
+    }
     target = static_cast<DST>( from );
+    return CONVERSION_OK;
 }
 
-
 template<typename SRC,typename DST,
          typename details::EnableIf< details::unsigned_to_smaller_conversion<SRC, DST>>* = nullptr  >
-inline void convert_impl( const SRC& from, DST& target )
+inline ConversionResult try_convert_impl( const SRC& from, DST& target )
 {
-    //std::cout << "unsigned_to_smaller_conversion" << std::endl;
-
-    checkUpperLimit<SRC,DST>(from);
+    if( exceedsUpperLimit<SRC,DST>(from) ) return VALUE_TOO_LARGE;
     target = static_cast<DST>( from);
+    return CONVERSION_OK;
 }
 
 template<typename SRC,typename DST,
          typename details::EnableIf< details::signed_to_smaller_conversion<SRC, DST>>* = nullptr  >
-inline void convert_impl( const SRC& from, DST& target )
+inline ConversionResult try_convert_impl( const SRC& from, DST& target )
 {
-    //std::cout << "signed_to_smaller_conversion" << std::endl;
-    checkLowerLimit<SRC,DST>(from);
-    checkUpperLimit<SRC,DST>(from);
+    if( from < std::numeric_limits<DST>::min() ) return VALUE_TOO_SMALL;
+    if( from > std::numeric_limits<DST>::max() ) return VALUE_TOO_LARGE;
     target = static_cast<DST>( from);
+    return CONVERSION_OK;
 }
 
-
 template<typename SRC,typename DST,
          typename details::EnableIf< details::signed_to_smaller_unsigned_conversion<SRC, DST>>* = nullptr  >
-inline void convert_impl( const SRC& from, DST& target )
+inline ConversionResult try_convert_impl( const SRC& from, DST& target )
 {
-    //std::cout << "signed_to_smaller_unsigned_conversion" << std::endl;
-    if (from < 0 )
-        throw RangeException("Value is negative and can't be converted to signed");
-
-    checkUpperLimit<SRC,DST>(from);
-
+    if( from < 0 ) return VALUE_NEGATIVE;
+    if( exceedsUpperLimit<SRC,DST>(from) ) return VALUE_TOO_LARGE;
     target = static_cast<DST>( from);
+    return CONVERSION_OK;
 }
 
-
 template<typename SRC,typename DST,
          typename details::EnableIf< details::signed_to_larger_unsigned_conversion<SRC, DST>>* = nullptr   >
-inline void convert_impl( const SRC& from, DST& target )
+inline ConversionResult try_convert_impl( const SRC& from, DST& target )
 {
-    //std::cout << "signed_to_larger_unsigned_conversion" << std::endl;
-
-    if ( from < 0 )
-        throw RangeException("Value is negative and can't be converted to signed");
-
+    if( from < 0 ) return VALUE_NEGATIVE;
     target = static_cast<DST>( from);
+    return CONVERSION_OK;
 }
 
 template<typename SRC,typename DST,
          typename details::EnableIf< details::unsigned_to_larger_signed_conversion<SRC, DST>>* = nullptr   >
-inline void convert_impl( const SRC& from, DST& target )
+inline ConversionResult try_convert_impl( const SRC& from, DST& target )
 {
-    //std::cout << "unsigned_to_larger_signed_conversion" << std::endl;
     target = static_cast<DST>( from);
+    return CONVERSION_OK;
 }
 
 template<typename SRC,typename DST,
          typename details::EnableIf< details::unsigned_to_smaller_signed_conversion<SRC, DST>>* = nullptr   >
-inline void convert_impl( const SRC& from, DST& target )
+inline ConversionResult try_convert_impl( const SRC& from, DST& target )
 {
-    //std::cout << "unsigned_to_smaller_signed_conversion" << std::endl;
-
-    checkUpperLimit<SRC,DST>(from);
+    if( exceedsUpperLimit<SRC,DST>(from) ) return VALUE_TOO_LARGE;
     target = static_cast<DST>( from);
+    return CONVERSION_OK;
 }
 
 template<typename SRC,typename DST,
          typename details::EnableIf< details::floating_to_signed_conversion<SRC, DST>>* = nullptr   >
-inline void convert_impl( const SRC& from, DST& target )
+inline ConversionResult try_convert_impl( const SRC& from, DST& target )
 {
-    //std::cout << "floating_to_signed_conversion" << std::endl;
-
-    checkLowerLimitFloat<SRC,DST>(from);
-    checkLowerLimitFloat<SRC,DST>(from);
-
-    if( from != static_cast<SRC>(static_cast<DST>( from)))
-        throw RangeException("Floating point truncated");
-
+    if( from != from ) return VALUE_NOT_A_NUMBER;
+    if( from >= floatUpperBound<SRC,DST>() ) return VALUE_TOO_LARGE;
+    if( from < -floatUpperBound<SRC,DST>() ) return VALUE_TOO_SMALL;
+    if( isTruncated<SRC,DST>(from) ) return VALUE_TRUNCATED;
     target = static_cast<DST>( from);
+    return CONVERSION_OK;
 }
 
 template<typename SRC,typename DST,
          typename details::EnableIf< details::floating_to_unsigned_conversion<SRC, DST>>* = nullptr   >
-inline void convert_impl( const SRC& from, DST& target )
+inline ConversionResult try_convert_impl( const SRC& from, DST& target )
 {
-    //std::cout << "floating_to_unsigned_conversion" << std::endl;
-    if ( from < 0 )
-        throw RangeException("Value is negative and can't be converted to signed");
-
-    checkLowerLimitFloat<SRC,DST>(from);
-
-    if( from != static_cast<SRC>(static_cast<DST>( from)))
-        throw RangeException("Floating point truncated");
-
+    if( from != from ) return VALUE_NOT_A_NUMBER;
+    if( from < 0 ) return VALUE_NEGATIVE;
+    if( from >= floatUpperBound<SRC,DST>() ) return VALUE_TOO_LARGE;
+    if( isTruncated<SRC,DST>(from) ) return VALUE_TRUNCATED;
     target = static_cast<DST>( from);
+    return CONVERSION_OK;
 }
 
 template<typename SRC,typename DST,
          typename details::EnableIf< details::integer_to_floating_conversion<SRC, DST>>* = nullptr >
+inline ConversionResult try_convert_impl( const SRC& from, DST& target )
+{
+    if( isTruncated<SRC,DST>(from) ) return VALUE_TRUNCATED;
+    target = static_cast<DST>( from);
+    return CONVERSION_OK;
+}
+
+template<typename SRC,typename DST>
 inline void convert_impl( const SRC& from, DST& target )
 {
-    //std::cout << "floating_to_unsigned_conversion" << std::endl;
+    const ConversionResult result = try_convert_impl<SRC,DST>( from, target );
+    if( result != CONVERSION_OK ) throwConversionError( result );
+}
 
-    checkTruncation<SRC,DST>(from);
-    target = static_cast<DST>( from);
+//----------------------- Lossy conversion ----------------------------------------------
+// Never fails: integers saturate to the limits of DST, floating point values are rounded
+// (toward zero, if DST is an integer) and NaN becomes 0 when DST is an integer.
+
+template<typename SRC,typename DST,
+         typename details::EnableIf< std::integral_constant<bool,
+             is_integer<SRC>::value && is_integer<DST>::value>>* = nullptr >
+inline DST lossy_convert_impl( const SRC& from )
+{
+    if( std::is_signed<SRC>::value && from < SRC(0) )
+    {
+      if( !std::is_signed<DST>::value ) return DST(0);
+      if( static_cast<int64_t>(from) < static_cast<int64_t>(std::numeric_limits<DST>::min()) ){
+        return std::numeric_limits<DST>::min();
+      }
+      return static_cast<DST>( from );
+    }
+    if( exceedsUpperLimit<SRC,DST>(from) ) return std::numeric_limits<DST>::max();
+    return static_cast<DST>( from );
+}
+
+template<typename SRC,typename DST,
+         typename details::EnableIf< std::integral_constant<bool,
+             std::is_floating_point<SRC>::value && is_integer<DST>::value>>* = nullptr >
+inline DST lossy_convert_impl( const SRC& from )
+{
+    if( from != from ) return DST(0);
+    if( from >= floatUpperBound<SRC,DST>() ) return std::numeric_limits<DST>::max();
+    if( from <= static_cast<SRC>(std::numeric_limits<DST>::min()) ) return std::numeric_limits<DST>::min();
+    return static_cast<DST>( from );
+}
+
+template<typename SRC,typename DST,
+         typename details::EnableIf< std::integral_constant<bool,
+             std::is_floating_point<DST>::value>>* = nullptr >
+inline DST lossy_convert_impl( const SRC& from )
+{
+    // only a narrowing conversion of a finite value can exceed the range of DST
+    if( sizeof(DST) < sizeof(SRC) && std::is_floating_point<SRC>::value &&
+        from - from == 0 )
+    {
+      if( from > std::numeric_limits<DST>::max() )  return std::numeric_limits<DST>::max();
+      if( from < -std::numeric_limits<DST>::max() ) return -std::numeric_limits<DST>::max();
+    }
+    return static_cast<DST>( from );
 }
 
 } //end namespace details
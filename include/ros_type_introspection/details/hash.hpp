@@ -0,0 +1,121 @@
+#ifndef ROS_INTROSPECTION_HASH_H
+#define ROS_INTROSPECTION_HASH_H
+
+#include <stdint.h>
+#include <cstring>
+
+/*
+ * Fast, non cryptographic, hash of a sequence of bytes, used by std::hash<SString>,
+ * HashedString and StringPool. It follows the structure of wyhash (public domain):
+ * strings up to 16 bytes are read with (at most) four overlapping loads and mixed
+ * with a single 64x64->128 bits multiplication.
+ *
+ * The values are the same only on machines with the same endianness.
+ */
+
+namespace RosIntrospection
+{
+
+namespace details{
+
+const uint64_t HASH_P0 = 0xa0761d6478bd642full;
+const uint64_t HASH_P1 = 0xe7037ed1a0b428dbull;
+const uint64_t HASH_P2 = 0x8ebc6af09c88c6e3ull;
+const uint64_t HASH_P3 = 0x589965cc75374cc3ull;
+
+// 128 bits product of A and B; A is replaced by the lower half, B by the upper one.
+inline void hashMultiply(uint64_t* A, uint64_t* B)
+{
+#if defined(__SIZEOF_INT128__)
+  const __uint128_t r = static_cast<__uint128_t>(*A) * (*B);
+  *A = static_cast<uint64_t>(r);
+  *B = static_cast<uint64_t>(r >> 64);
+#else
+  const uint64_t ha = *A >> 32, hb = *B >> 32, la = static_cast<uint32_t>(*A), lb = static_cast<uint32_t>(*B);
+  const uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+  const uint64_t t = rl + (rm0 << 32);
+  uint64_t carry = t < rl;
+  const uint64_t lo = t + (rm1 << 32);
+  carry += lo < t;
+  *A = lo;
+  *B = rh + (rm0 >> 32) + (rm1 >> 32) + carry;
+#endif
+}
+
+inline uint64_t hashMix(uint64_t A, uint64_t B)
+{
+  hashMultiply( &A, &B );
+  return A ^ B;
+}
+
+inline uint64_t hashRead64(const uint8_t* p)
+{
+  uint64_t value;
+  memcpy( &value, p, 8 );
+  return value;
+}
+
+inline uint64_t hashRead32(const uint8_t* p)
+{
+  uint32_t value;
+  memcpy( &value, p, 4 );
+  return value;
+}
+
+inline uint64_t hashBytes(const void* data, size_t length, uint64_t seed = 0)
+{
+  const uint8_t* p = static_cast<const uint8_t*>(data);
+  seed ^= hashMix( seed ^ HASH_P0, HASH_P1 );
+
+  uint64_t a, b;
+  if( length <= 16 )
+  {
+    if( length >= 4 )
+    {
+      const size_t shift = (length >> 3) << 2;
+      a = (hashRead32(p) << 32) | hashRead32(p + shift);
+      b = (hashRead32(p + length - 4) << 32) | hashRead32(p + length - 4 - shift);
+    }
+    else if( length > 0 )
+    {
+      a = (uint64_t(p[0]) << 16) | (uint64_t(p[length >> 1]) << 8) | p[length - 1];
+      b = 0;
+    }
+    else{
+      a = b = 0;
+    }
+  }
+  else{
+    size_t i = length;
+    if( i > 48 )
+    {
+      uint64_t seed1 = seed, seed2 = seed;
+      do{
+        seed  = hashMix( hashRead64(p)      ^ HASH_P1, hashRead64(p + 8)  ^ seed );
+        seed1 = hashMix( hashRead64(p + 16) ^ HASH_P2, hashRead64(p + 24) ^ seed1 );
+        seed2 = hashMix( hashRead64(p + 32) ^ HASH_P3, hashRead64(p + 40) ^ seed2 );
+        p += 48;
+        i -= 48;
+      } while( i > 48 );
+      seed ^= seed1 ^ seed2;
+    }
+    while( i > 16 )
+    {
+      seed = hashMix( hashRead64(p) ^ HASH_P1, hashRead64(p + 8) ^ seed );
+      i -= 16;
+      p += 16;
+    }
+    a = hashRead64(p + i - 16);
+    b = hashRead64(p + i - 8);
+  }
+  a ^= HASH_P1;
+  b ^= seed;
+  hashMultiply( &a, &b );
+  return hashMix( a ^ HASH_P0 ^ length, b ^ HASH_P1 );
+}
+
+} //end namespace details
+
+} //end namespace
+
+#endif // ROS_INTROSPECTION_HASH_H
@@ -0,0 +1,137 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright 2016 Davide Faconti
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of Willow Garage, Inc. nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+********************************************************************/
+
+
+#ifndef ROS_INTROSPECTION_FIELD_LOCATOR_H
+#define ROS_INTROSPECTION_FIELD_LOCATOR_H
+
+#include <vector>
+#include <boost/utility/string_ref.hpp>
+#include "ros_type_introspection/parser.hpp"
+#include "ros_type_introspection/variant.hpp"
+
+namespace RosIntrospection{
+
+class MessageSchema;
+class SchemaLayout;
+
+/**
+ * @brief The FieldLocator finds a single field inside a serialized message, without
+ * deserializing the rest of it.
+ *
+ * The path of the field uses the same syntax of StringTreeLeaf::toStr, without the prefix,
+ * i.e. the names of the fields are separated by "/" and the index of an array is appended
+ * to its name with a dot. For example:
+ *
+ *      header/frame_id
+ *      status.2/level
+ *
+ * The path is resolved once, in the constructor. The fields that precede it are then skipped
+ * using their serialized size: fields with a fixed size are skipped in a single step,
+ * the others reading only the length of their arrays and strings.
+ *
+ * The FieldLocator doesn't refer to the ROSTypeList used to create it.
+ */
+class FieldLocator{
+public:
+
+  /// Throws std::runtime_error if the path is not valid or doesn't reach a builtin type
+  /// (or string). Arrays must be indexed.
+  FieldLocator(const ROSTypeList& type_list,
+               const ROSType& type,
+               const std::string& path);
+
+  FieldLocator(const MessageSchema& schema, const std::string& path);
+
+  const std::string& path() const { return _path; }
+
+  /// Type of the field.
+  const ROSType& type() const { return _type; }
+
+  /**
+   * @brief Find the field in the serialized message.
+   *
+   * @return pointer to the serialized field, or nullptr if the message has an array
+   *         with less elements than the index in the path.
+   *         Throws RangeException if the buffer is shorter than the message.
+   */
+  const uint8_t* locate(const uint8_t* buffer, size_t buffer_size) const;
+
+  /// Read the value of a field that is not a string. Return false if it is not present.
+  bool extract(const uint8_t* buffer, size_t buffer_size, VarNumber* value) const;
+
+  /// Read a string, without copying it. Return false if it is not present.
+  bool extract(const uint8_t* buffer, size_t buffer_size, boost::string_ref* value) const;
+
+private:
+
+  struct FieldLayout{
+    ROSType type;
+    /// index in _messages, or -1 if the type is builtin.
+    int message_index;
+    /// serialized size of an element of the array (or the field itself), -1 if variable.
+    int element_size;
+    /// serialized size of the whole field, -1 if variable.
+    int fixed_size;
+  };
+
+  struct Step{
+    /// fields with variable size that precede the field in the message, each one
+    /// with the size of the fixed size fields before it.
+    std::vector<std::pair<size_t,size_t>> variable_fields;
+    /// size of the fixed size fields between the last variable one and the field.
+    size_t fixed_offset;
+    /// index of the field in its message
+    size_t field;
+    /// index of the element if the field is an array, -1 otherwise
+    int array_index;
+  };
+
+  void init(const SchemaLayout& schema_layout);
+
+  void skipField(const FieldLayout& field, const uint8_t** ptr, const uint8_t* end) const;
+
+  void skipElement(const FieldLayout& field, const uint8_t** ptr, const uint8_t* end) const;
+
+  std::string _path;
+  ROSType _type;
+  std::vector<std::vector<FieldLayout>> _messages;
+  std::vector<Step> _steps;
+  // message that contains the field of each step
+  std::vector<int> _step_message;
+};
+
+} //end namespace
+
+#endif // ROS_INTROSPECTION_FIELD_LOCATOR_H
@@ -0,0 +1,202 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright 2016 Davide Faconti
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of Willow Garage, Inc. nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+********************************************************************/
+
+
+#ifndef ROS_INTROSPECTION_FIELD_PATCHER_H
+#define ROS_INTROSPECTION_FIELD_PATCHER_H
+
+#include <cstring>
+#include <type_traits>
+#include "ros_type_introspection/field_locator.hpp"
+#include "ros_type_introspection/shape_shifter.hpp"
+
+namespace RosIntrospection{
+
+/**
+ * @brief The FieldPatcher modifies a single field of a serialized message in place,
+ * for instance to change header/stamp or header/frame_id of a message that is relayed,
+ * whatever its type is.
+ *
+ * Fields with a fixed size are overwritten with a memcpy. Strings are replaced moving
+ * the rest of the message once, if the length changes.
+ *
+ * The path uses the syntax of FieldLocator.
+ */
+class FieldPatcher{
+public:
+
+  FieldPatcher(const ROSTypeList& type_list, const ROSType& type, const std::string& path):
+    _locator(type_list, type, path) {}
+
+  FieldPatcher(const MessageSchema& schema, const std::string& path):
+    _locator(schema, path) {}
+
+  const FieldLocator& locator() const { return _locator; }
+
+  /**
+   * @brief Overwrite a field that is not a string. T must be the type of the field
+   * (for instance ros::Time for "time"), otherwise TypeException is thrown.
+   * The aliases "byte" and "char" are written as int8_t and uint8_t (or char), like in roscpp.
+   *
+   * @return false if the field is not present (see FieldLocator::locate).
+   */
+  template <typename T>
+  bool write(uint8_t* buffer, size_t buffer_size, const T& value) const;
+
+  template <typename T>
+  bool write(ShapeShifter* msg, const T& value) const;
+
+  /**
+   * @brief Replace a string. The size of the buffer changes if the length of the string does.
+   *
+   * @param buffer  either std::vector<uint8_t> or PooledBuffer.
+   * @return false if the field is not present.
+   */
+  template <class Buffer>
+  bool writeString(Buffer* buffer, boost::string_ref value) const;
+
+  bool writeString(ShapeShifter* msg, boost::string_ref value) const;
+
+private:
+
+  // The subset of the interface of Buffer used by writeString.
+  struct ShapeShifterBuffer{
+    ShapeShifter* msg;
+    uint8_t* data()               { return msg->mutable_data(); }
+    size_t size() const           { return msg->size(); }
+    void resize(size_t new_size)  { msg->resize( new_size ); }
+  };
+
+  template <typename T> static bool isSameType(BuiltinType id);
+
+  FieldLocator _locator;
+};
+
+//----------------------- Implementation ----------------------------------------------
+
+template <typename T> inline
+bool FieldPatcher::isSameType(BuiltinType id)
+{
+  switch( id )
+  {
+  case BYTE: return getType<T>() == INT8;
+  case CHAR: return getType<T>() == UINT8 || getType<T>() == CHAR;
+  default:   return getType<T>() == id;
+  }
+}
+
+template <typename T> inline
+bool FieldPatcher::write(uint8_t *buffer, size_t buffer_size, const T &value) const
+{
+  const ROSType& type = _locator.type();
+  if( !isSameType<T>( type.typeID() ) || type.typeSize() != sizeof(T) )
+  {
+    throw TypeException( "FieldPatcher: wrong type for the field [" + _locator.path() +
+                         "] of type " + type.baseName().toStdString() );
+  }
+  uint8_t* field = const_cast<uint8_t*>( _locator.locate( buffer, buffer_size ) );
+  if( !field ) return false;
+
+  if( sizeof(T) > static_cast<size_t>( buffer + buffer_size - field ) )
+  {
+    throw RangeException("FieldPatcher: the buffer is shorter than the serialized message");
+  }
+  memcpy( field, &value, sizeof(T) );
+  return true;
+}
+
+template <typename T> inline
+bool FieldPatcher::write(ShapeShifter *msg, const T &value) const
+{
+  return write( msg->mutable_data(), msg->size(), value );
+}
+
+template <class Buffer> inline
+bool FieldPatcher::writeString(Buffer *buffer, boost::string_ref value) const
+{
+  if( _locator.type().typeID() != STRING )
+  {
+    throw TypeException( "FieldPatcher: the field [" + _locator.path() + "] is not a string" );
+  }
+  const size_t buffer_size = buffer->size();
+  const uint8_t* field = _locator.locate( buffer->data(), buffer_size );
+  if( !field ) return false;
+
+  const size_t offset = field - buffer->data();
+  if( buffer_size - offset < sizeof(uint32_t) )
+  {
+    throw RangeException("FieldPatcher: the buffer is shorter than the serialized message");
+  }
+  uint32_t old_length = 0;
+  memcpy( &old_length, field, sizeof(uint32_t) );
+  if( buffer_size - offset - sizeof(uint32_t) < old_length )
+  {
+    throw RangeException("FieldPatcher: the buffer is shorter than the serialized message");
+  }
+
+  const uint32_t new_length = static_cast<uint32_t>( value.size() );
+  const size_t old_end = offset + sizeof(uint32_t) + old_length;
+  const size_t new_end = offset + sizeof(uint32_t) + new_length;
+  const size_t tail = buffer_size - old_end;
+
+  if( new_length > old_length )
+  {
+    buffer->resize( buffer_size + (new_length - old_length) );
+    uint8_t* data = buffer->data();
+    memmove( data + new_end, data + old_end, tail );
+  }
+  else if( new_length < old_length )
+  {
+    uint8_t* data = buffer->data();
+    memmove( data + new_end, data + old_end, tail );
+    buffer->resize( buffer_size - (old_length - new_length) );
+  }
+
+  uint8_t* data = buffer->data();
+  memcpy( data + offset, &new_length, sizeof(uint32_t) );
+  if( new_length > 0 ) {
+    memcpy( data + offset + sizeof(uint32_t), value.data(), new_length );
+  }
+  return true;
+}
+
+inline bool FieldPatcher::writeString(ShapeShifter *msg, boost::string_ref value) const
+{
+  ShapeShifterBuffer buffer = { msg };
+  return writeString( &buffer, value );
+}
+
+} //end namespace
+
+#endif // ROS_INTROSPECTION_FIELD_PATCHER_H
@@ -0,0 +1,245 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright 2016 Davide Faconti
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of Willow Garage, Inc. nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+********************************************************************/
+
+
+#ifndef ROS_INTROSPECTION_INTERNED_STRING_H
+#define ROS_INTROSPECTION_INTERNED_STRING_H
+
+#include <deque>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <boost/noncopyable.hpp>
+#include "ros_type_introspection/string.hpp"
+
+namespace RosIntrospection{
+
+#if 1
+// Faster, but might need more testing
+typedef ssoX::basic_string<char> SString;
+#else
+// slightly slower but safer option. More convenient during debug
+typedef std::string SString;
+#endif
+
+class StringPool;
+
+/**
+ * @brief Immutable string that stores its hash, computed once in the constructor.
+ *
+ * Use it as the key of unordered containers when the same (long) strings are hashed
+ * many times; the comparison looks at the characters only if the hashes are equal.
+ */
+class HashedString{
+public:
+
+  HashedString(): _hash( hashString("", 0) ) {}
+
+  HashedString(const char* str, size_t size): _str(str, size), _hash( hashString( str, size ) ) {}
+
+  HashedString(const char* str): HashedString( str, strlen(str) ) {}
+
+  HashedString(const std::string& str): HashedString( str.data(), str.size() ) {}
+
+  HashedString(const ssoX::basic_string<char>& str): HashedString( str.data(), str.size() ) {}
+
+  const SString& str() const        { return _str; }
+
+  operator const SString&() const   { return _str; }
+
+  const char* data() const          { return _str.data(); }
+
+  size_t size() const               { return _str.size(); }
+
+  size_t hash() const               { return _hash; }
+
+  friend bool operator==(const HashedString& a, const HashedString& b)
+  {
+    return a._hash == b._hash && a._str == b._str;
+  }
+
+  friend bool operator!=(const HashedString& a, const HashedString& b) { return !(a == b); }
+
+private:
+  SString _str;
+  size_t  _hash;
+};
+
+namespace details{
+
+struct InternedEntry{
+  SString str;
+  size_t  hash;
+};
+
+} // end namespace details
+
+/**
+ * @brief Handle of a string stored in StringPool::global().
+ *
+ * Two InternedString(s) are equal if and only if they point to the same entry of the
+ * pool, therefore the comparison doesn't look at the characters. The pool is never
+ * emptied, so the handles (and str()) stay valid until the end of the program.
+ *
+ * Creating an InternedString requires a lookup in the pool: copy the existing ones
+ * instead, when possible.
+ */
+class InternedString{
+public:
+
+  /// Empty string.
+  InternedString();
+
+  InternedString(const char* str);
+
+  InternedString(const char* str, size_t size);
+
+  InternedString(const std::string& str);
+
+  InternedString(const ssoX::basic_string<char>& str);
+
+  const SString& str() const          { return _entry->str; }
+
+  operator const SString&() const     { return _entry->str; }
+
+  const char* data() const            { return _entry->str.data(); }
+
+  size_t size() const                 { return _entry->str.size(); }
+
+  bool empty() const                  { return _entry->str.size() == 0; }
+
+  /// Hash of the characters (see hashString), computed once by the pool.
+  size_t hash() const                 { return _entry->hash; }
+
+  std::string toStdString() const     { return std::string( data(), size() ); }
+
+  friend bool operator==(const InternedString& a, const InternedString& b) { return a._entry == b._entry; }
+  friend bool operator!=(const InternedString& a, const InternedString& b) { return a._entry != b._entry; }
+
+private:
+  friend class StringPool;
+  explicit InternedString(const details::InternedEntry* entry): _entry(entry) {}
+
+  const details::InternedEntry* _entry;
+};
+
+// comparisons with strings that are not interned look at the characters.
+
+inline bool operator==(const InternedString& a, const SString& b)
+{
+  return a.size() == b.size() && memcmp( a.data(), b.data(), a.size() ) == 0;
+}
+
+inline bool operator==(const SString& a, const InternedString& b) { return b == a; }
+inline bool operator!=(const InternedString& a, const SString& b) { return !(a == b); }
+inline bool operator!=(const SString& a, const InternedString& b) { return !(b == a); }
+
+inline bool operator==(const InternedString& a, const char* b) { return strcmp( a.data(), b ) == 0; }
+inline bool operator!=(const InternedString& a, const char* b) { return !(a == b); }
+
+inline std::ostream& operator<<(std::ostream& os, const InternedString& str)
+{
+  return os << str.data();
+}
+
+/**
+ * @brief Set of unique strings, shared by the whole program, used for the names of the
+ * fields of the messages (the nodes of StringTree and the patterns of SubstitutionRule).
+ *
+ * intern() is thread-safe: the strings are divided in shards, each one protected by its own
+ * mutex. Reading an InternedString never locks.
+ */
+class StringPool: boost::noncopyable{
+public:
+
+  /// Intentionally leaked, so that the InternedString(s) are valid during the static destruction too.
+  static StringPool& global();
+
+  /// Return the handle of the string, adding it to the pool if needed.
+  InternedString intern(const char* str, size_t size);
+
+  InternedString intern(const std::string& str) { return intern( str.data(), str.size() ); }
+
+  /// Number of strings in the pool.
+  size_t size() const;
+
+private:
+  StringPool();
+
+  friend class InternedString;
+
+  static const size_t NUM_SHARDS = 16;
+
+  struct Shard{
+    mutable std::mutex mutex;
+    std::deque<details::InternedEntry> entries;
+    std::unordered_multimap<size_t, const details::InternedEntry*> index;
+  };
+
+  Shard _shards[NUM_SHARDS];
+  const details::InternedEntry* _empty;
+};
+
+inline InternedString::InternedString():
+  _entry( StringPool::global()._empty ) {}
+
+inline InternedString::InternedString(const char* str):
+  InternedString( StringPool::global().intern( str, strlen(str) ) ) {}
+
+inline InternedString::InternedString(const char* str, size_t size):
+  InternedString( StringPool::global().intern( str, size ) ) {}
+
+inline InternedString::InternedString(const std::string& str):
+  InternedString( StringPool::global().intern( str.data(), str.size() ) ) {}
+
+inline InternedString::InternedString(const ssoX::basic_string<char>& str):
+  InternedString( StringPool::global().intern( str.data(), str.size() ) ) {}
+
+} //end namespace
+
+namespace std{
+
+template <> struct hash<RosIntrospection::HashedString>
+{
+  size_t operator()(const RosIntrospection::HashedString& str) const { return str.hash(); }
+};
+
+template <> struct hash<RosIntrospection::InternedString>
+{
+  size_t operator()(const RosIntrospection::InternedString& str) const { return str.hash(); }
+};
+
+} //end namespace std
+
+#endif // ROS_INTROSPECTION_INTERNED_STRING_H
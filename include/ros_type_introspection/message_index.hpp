@@ -0,0 +1,156 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright 2016 Davide Faconti
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of Willow Garage, Inc. nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+********************************************************************/
+
+
+#ifndef ROS_INTROSPECTION_MESSAGE_INDEX_H
+#define ROS_INTROSPECTION_MESSAGE_INDEX_H
+
+#include <unordered_map>
+#include <boost/utility/string_ref.hpp>
+#include "ros_type_introspection/parser.hpp"
+#include "ros_type_introspection/variant.hpp"
+
+namespace RosIntrospection{
+
+class MessageSchema;
+class SchemaLayout;
+
+/**
+ * @brief The MessageIndex records the position of every field of a serialized message,
+ * reading only the length of its arrays and strings. After that, any field can be read
+ * without parsing the message again.
+ *
+ * The paths use the syntax of FieldLocator, for instance "header/frame_id" or "status.2/level".
+ *
+ * The buffer is referenced, not copied: it must be valid as long as it is used by the index.
+ */
+class MessageIndex{
+public:
+
+  /// Throws std::runtime_error if the type list doesn't contain all the types needed.
+  MessageIndex(const ROSTypeList& type_list, const ROSType& type);
+
+  explicit MessageIndex(const MessageSchema& schema);
+
+  /// Index a message. Throws RangeException if the buffer is shorter than the message.
+  void build(const uint8_t* buffer, size_t buffer_size);
+
+  /**
+   * @brief Use the index with a different message, if all its arrays and strings have the same
+   * length of the indexed one (therefore all the fields are in the same position).
+   *
+   * @return false if the message is not compatible. In that case the index is not modified.
+   */
+  bool rebind(const uint8_t* buffer, size_t buffer_size);
+
+  /// Size of the indexed message.
+  size_t messageSize() const { return _message_size; }
+
+  /// Read a field (other than string). Return false if an array is shorter than the index in the path.
+  /// Throws std::runtime_error if the path is not valid.
+  bool getValue(const std::string& path, VarNumber* value) const;
+
+  /// Read a string, without copying it. Return false if an array is shorter than the index in the path.
+  bool getString(const std::string& path, boost::string_ref* value) const;
+
+  /// Number of elements of an array (the last element of the path). Return -1 if not present.
+  int getArraySize(const std::string& path) const;
+
+  /// Position of a field in the buffer, -1 if not present. For arrays it is the first element,
+  /// for strings their length.
+  long getOffset(const std::string& path) const;
+
+private:
+
+  static const uint32_t NONE = 0xFFFFFFFF;
+
+  struct FieldLayout{
+    SString name;
+    ROSType type;
+    /// index in _messages, or -1 if the type is builtin.
+    int message_index;
+    /// serialized size of an element of the array (or the field itself), -1 if variable.
+    int element_size;
+    /// offset from the start of the message, -1 if it follows a field with variable size.
+    int fixed_offset;
+  };
+
+  struct MessageLayout{
+    std::vector<FieldLayout> fields;
+    /// hashString() of the name -> index in fields
+    std::unordered_multimap<size_t, size_t> field_index;
+
+    /// Index in fields, -1 if there is no field with that name.
+    int fieldIndex(const boost::string_ref& name) const;
+  };
+
+  /// One for each field of each message in the buffer.
+  struct Entry{
+    /// start of the field (the length, for arrays with variable size).
+    uint32_t offset;
+    uint32_t count;
+    /// first Entry of the nested message, or the first element in _elements for
+    /// arrays of strings and messages. Messages with a fixed size have no Entry(s).
+    uint32_t child;
+  };
+
+  /// Result of the resolution of a path.
+  struct Position{
+    const FieldLayout* field;
+    long offset;      // -1 if not present
+    long count;       // number of elements if is_array, -1 if not present
+    bool is_array;    // the last field is an array, without index
+  };
+
+  void init(const SchemaLayout& schema_layout);
+
+  uint32_t indexMessage(int message_index, const uint8_t** ptr, const uint8_t* end);
+
+  uint32_t readLength(const uint8_t** ptr, const uint8_t* end);
+
+  Position resolve(const std::string& path) const;
+
+  std::vector<MessageLayout> _messages;
+
+  const uint8_t* _buffer;
+  size_t _message_size;
+  std::vector<Entry> _entries;
+  std::vector<uint32_t> _elements;
+  /// position and value of all the lengths of arrays and strings, to check rebind().
+  std::vector<std::pair<uint32_t,uint32_t>> _lengths;
+};
+
+} //end namespace
+
+#endif // ROS_INTROSPECTION_MESSAGE_INDEX_H
@@ -0,0 +1,220 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright 2016 Davide Faconti
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of Willow Garage, Inc. nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+********************************************************************/
+
+
+#ifndef ROS_INTROSPECTION_MESSAGE_VIEW_H
+#define ROS_INTROSPECTION_MESSAGE_VIEW_H
+
+#include <unordered_map>
+#include <boost/noncopyable.hpp>
+#include <boost/utility/string_ref.hpp>
+#include "ros_type_introspection/parser.hpp"
+#include "ros_type_introspection/variant.hpp"
+
+namespace RosIntrospection{
+
+class MessageSchema;
+class SchemaLayout;
+
+/**
+ * @brief The ViewLayout is the description of a message type used by MessageView.
+ * For each field it stores the offset from the start of its message, if all the fields
+ * that precede it have a fixed size.
+ *
+ * MessageSchema::viewLayout() creates it once for each schema.
+ */
+class ViewLayout: boost::noncopyable{
+public:
+
+  struct FieldLayout{
+    ROSType type;
+    /// index in messages(), or -1 if the type is builtin.
+    int message_index;
+    /// serialized size of an element of the array (or the field itself), -1 if variable.
+    int element_size;
+    /// serialized size of the whole field, -1 if variable.
+    int fixed_size;
+    /// offset from the start of the message, -1 if it follows a field with variable size.
+    int fixed_offset;
+    /// unique among all the fields of all the messages.
+    uint32_t id;
+  };
+
+  struct MessageLayout{
+    std::vector<FieldLayout> fields;
+    std::unordered_map<std::string, size_t> field_index;
+    /// -1 if variable
+    int fixed_size;
+  };
+
+  /// Throws std::runtime_error if the type list doesn't contain all the types needed.
+  ViewLayout(const ROSTypeList& type_list, const ROSType& type);
+
+  /// Copy the layout already computed, for example MessageSchema::layout().
+  explicit ViewLayout(const SchemaLayout& schema_layout);
+
+  /// The first one is the main type.
+  const std::vector<MessageLayout>& messages() const { return _messages; }
+
+private:
+
+  std::vector<MessageLayout> _messages;
+  uint32_t _field_count;
+};
+
+/**
+ * @brief The MessageView gives access to the fields of a serialized message, decoding only
+ * the ones that are used. For example:
+ *
+ *      MessageView view( schema, buffer, size );
+ *      double x = view["pose"]["position"]["x"].as<double>();
+ *      std::string frame = view["transforms"][0]["header"]["frame_id"].as<std::string>();
+ *
+ * The position of the fields that follow an array or a string are computed when they are
+ * needed and memoized, therefore reading many fields of the same message costs only once.
+ *
+ * The MessageView doesn't copy the buffer and the layout: both must be valid as long as the view
+ * (and its Field(s)) are used. It is not thread-safe, because of the memoization.
+ */
+class MessageView: boost::noncopyable{
+public:
+
+  /**
+   * @brief Reference to a field of the message, a whole array or one of its elements.
+   * It is a small value, that can be copied.
+   *
+   * Errors in the path throw std::runtime_error, a message shorter than expected or
+   * an index out of range throws RangeException and reading the wrong type throws TypeException.
+   */
+  class Field{
+  public:
+
+    /// Field of a nested message.
+    Field operator[](const std::string& name) const;
+
+    /// Element of an array.
+    Field operator[](size_t index) const;
+
+    /// Number of elements of an array.
+    size_t size() const;
+
+    bool isArray() const { return _field && _field->type.isArray() && !_is_element; }
+
+    bool isMessage() const { return messageIndex() >= 0 && !isArray(); }
+
+    /// Type of the field (for elements, the type of the array).
+    const ROSType& type() const;
+
+    /// Value of a builtin type, other than string.
+    VarNumber value() const;
+
+    /// Value of a string, without copying it.
+    boost::string_ref str() const;
+
+    /// Value converted with VarNumber::convert. It can be also std::string, boost::string_ref or ros::Time.
+    template <typename T> T as() const { return value().convert<T>(); }
+
+    /// Position in the buffer. For arrays with variable size, the position of their length.
+    size_t offset() const { return _offset; }
+
+  private:
+    friend class MessageView;
+
+    Field(const MessageView* view, const ViewLayout::FieldLayout* field, bool is_element, uint32_t offset):
+      _view(view), _field(field), _is_element(is_element), _offset(offset) {}
+
+    int messageIndex() const { return _field ? _field->message_index : 0; }
+
+    const MessageView* _view;
+    /// nullptr for the whole message
+    const ViewLayout::FieldLayout* _field;
+    bool _is_element;
+    uint32_t _offset;
+  };
+
+  MessageView(const MessageSchema& schema, const uint8_t* buffer, size_t buffer_size);
+
+  MessageView(const ViewLayout& layout, const uint8_t* buffer, size_t buffer_size);
+
+  /// The whole message.
+  Field root() const { return Field( this, nullptr, false, 0 ); }
+
+  Field operator[](const std::string& name) const { return root()[name]; }
+
+  const uint8_t* buffer() const { return _buffer; }
+
+  size_t bufferSize() const { return _buffer_size; }
+
+private:
+
+  uint32_t fieldOffset(int message_index, uint32_t message_offset, size_t field) const;
+
+  uint32_t fieldSize(const ViewLayout::FieldLayout& field, uint32_t offset) const;
+
+  uint32_t elementOffset(const ViewLayout::FieldLayout& field, uint32_t offset, uint32_t index) const;
+
+  uint32_t elementSize(const ViewLayout::FieldLayout& field, uint32_t offset) const;
+
+  uint32_t arraySize(const ViewLayout::FieldLayout& field, uint32_t offset) const;
+
+  uint32_t readLength(uint32_t offset) const;
+
+  const ViewLayout& _layout;
+  const uint8_t* _buffer;
+  size_t _buffer_size;
+
+  // Memoized offsets of the fields of a message (key: offset and index of the message)
+  // and of the elements of an array (key: offset and id of the field).
+  mutable std::unordered_map<uint64_t, std::vector<uint32_t>> _field_offsets;
+  mutable std::unordered_map<uint64_t, std::vector<uint32_t>> _element_offsets;
+};
+
+template <> inline boost::string_ref MessageView::Field::as() const
+{
+  return str();
+}
+
+template <> inline std::string MessageView::Field::as() const
+{
+  return str().to_string();
+}
+
+template <> inline ros::Time MessageView::Field::as() const
+{
+  return value().extract<ros::Time>();
+}
+
+} //end namespace
+
+#endif // ROS_INTROSPECTION_MESSAGE_VIEW_H
@@ -37,24 +37,25 @@
 
 #include <vector>
 #include <map>
+#include <unordered_map>
 #include <boost/function.hpp>
 #include <boost/utility/string_ref.hpp>
 #include "ros_type_introspection/stringtree.hpp"
 #include "ros_type_introspection/variant.hpp"
+#include "ros_type_introspection/interned_string.hpp"
 
 namespace RosIntrospection{
 
+// the names of the nodes are interned: the nodes can be compared by pointer.
+typedef details::TreeElement<InternedString> StringTreeNode;
+typedef details::Tree<InternedString> StringTree;
 
-#if 1
-// Faster, but might need more testing
-typedef ssoX::basic_string<char> SString;
-#else
-// slightly slower but safer option. More convenient during debug
-typedef std::string SString;
-#endif
-
-typedef details::TreeElement<SString> StringTreeNode;
-typedef details::Tree<SString> StringTree;
+/// Name of the nodes of StringTree that represent the elements of an array.
+inline const InternedString& arrayNodeName()
+{
+  static const InternedString name("#");
+  return name;
+}
 
 /**
  * @brief Description of a ROS type.
@@ -62,7 +63,7 @@ typedef details::Tree<SString> StringTree;
 class ROSType {
 public:
 
-  ROSType(){}
+  ROSType(): _is_array(false), _msg_hash( hashString("", 0) ) {}
 
   ROSType(const std::string& name);
 
@@ -94,6 +95,9 @@ public:
   /// If type is builtin, returns the id.  BuiltinType::OTHER otherwise.
   BuiltinType typeID() const;
 
+  /// hashString() of msgName(), computed once. Used by ROSTypeList::find.
+  size_t msgNameHash() const { return _msg_hash; }
+
   bool operator==(const ROSType& other) const  {
     return this->baseName() == other.baseName();
   }
@@ -113,10 +117,12 @@ public:
 protected:
 
   BuiltinType _id;
+  bool    _is_array;
   int     _array_size;
   SString _base_name;
   SString _msg_name;
   SString _pkg_name;
+  size_t  _msg_hash;
   boost::function<VarNumber(uint8_t** buffer)> _deserialize_impl;
 
 };
@@ -137,11 +143,14 @@ template <typename T> inline T ReadFromBuffer( uint8_t** buffer)
 class ROSField {
 public:
   ROSField(const std::string& name, const ROSType& type ):
-    _name( name ), _type( type ) {}
+    _name( name ), _type( type ), _message_index(-1) {}
 
   ROSField(const std::string& definition );
 
-  const SString&  name() const { return _name; }
+  const SString&  name() const { return _name.str(); }
+
+  /// Same as name(), but interned: it is the value of the nodes of StringTree.
+  const InternedString& internedName() const { return _name; }
 
   const ROSType&  type() const { return _type; }
 
@@ -153,18 +162,25 @@ public:
   /// If constant, value of field, else undefined
   const SString& value() const   { return _value; }
 
+  /// If the field is a constant of a numeric type, value() parsed once according to type().
+  /// VarNumber() (i.e. OTHER) for strings and for the fields that aren't constants.
+  const VarNumber& numericValue() const { return _numeric_value; }
+
+  /// Position in the ROSTypeList of the definition of type(), set by buildROSTypeMapFromDefinition
+  /// and ROSTypeList::buildIndex. -1 if the type is builtin or missing. See ROSTypeList::find(const ROSField&).
+  int messageIndex() const { return _message_index; }
+
   friend class ROSMessage;
 
 protected:
-  SString _name;
+  InternedString _name;
   ROSType _type;
   SString _value;
+  int _message_index;
+  VarNumber _numeric_value;
 };
 
-class ROSMessage;
-typedef std::vector<ROSMessage> ROSTypeList;
-
-
+class ROSTypeList;
 
 class ROSMessage{
 public:
@@ -181,12 +197,29 @@ public:
    */
   void updateTypes(const std::vector<ROSType> &all_types);
 
+  /// Same as the other updateTypes, using the index of the type list (linear in the number of fields).
+  /// It also links the fields that aren't builtin to their definition (see ROSField::messageIndex).
+  /// Throws std::runtime_error if a definition is missing.
+  void updateTypes(const ROSTypeList& type_list);
+
   /**
-   * @brief Get field by name.
-   * it uses linear search, so you should use it for debug only.
+   * @brief Get field by name, nullptr if it doesn't exist.
+   * It uses an index of the names, built by the constructor.
    */
   const ROSField* field(const SString& name) const;
 
+  /// Index of the field in fields(), -1 if it doesn't exist.
+  int fieldIndex(const SString& name) const;
+
+  /// Indexes in fields() of the constants, in the order of the definition.
+  const std::vector<size_t>& constants() const { return _constants; }
+
+  /**
+   * @brief First numeric constant equal to value, nullptr if there is none. It is meant to
+   * get the name of "enum" values, for instance the level of diagnostic_msgs/DiagnosticStatus.
+   */
+  const ROSField* findConstant(const VarNumber& value) const;
+
   /**
    * @brief Get field by index.
    */
@@ -203,19 +236,89 @@ public:
   void mutateType(const ROSType& new_type ) { _type = new_type; }
 
 private:
+  friend class ROSTypeList;
+
+  /// Set ROSField::messageIndex of all the fields, -1 if the type is missing.
+  void linkFields(const ROSTypeList& type_list);
+
   ROSType _type;
   std::vector<ROSField> _fields;
+  // hashString() of the name -> index in _fields
+  std::unordered_multimap<size_t, size_t> _field_index;
+  std::vector<size_t> _constants;
 };
 
+/**
+ * @brief The list of the ROSMessage(s) of a type and its dependencies, with an index that finds
+ * the definition of a type by name.
+ *
+ * It is a std::vector and can be modified as such, but buildIndex() must be called again afterwards.
+ * If the size changed, find() falls back to a linear search until then.
+ */
+class ROSTypeList: public std::vector<ROSMessage>{
+public:
 
-inline const ROSField* ROSMessage::field(const SString &name) const
+  ROSTypeList(): _indexed_size(0), _id(0) {}
+
+  /// Index the current content, link the fields to their definition (see ROSField::messageIndex)
+  /// and assign a new id(). Called by buildROSTypeMapFromDefinition.
+  void buildIndex();
+
+  /// Unique identifier of the content, assigned by buildIndex(); 0 if it was never indexed.
+  /// A copy has the same id of the original. Unlike the address, it is never reused.
+  uint64_t id() const { return _id; }
+
+  /// Definition of the type (same msgName and pkgName), nullptr if it isn't in the list.
+  const ROSMessage* find(const ROSType& type) const;
+
+  /// First definition with the given msgName and any package, nullptr if there is none.
+  const ROSMessage* findByMsgName(const ROSType& type) const;
+
+  /// Definition of the type of the field (of a message of this list), nullptr if it is builtin
+  /// or missing. It uses the link set by buildIndex(), without comparing the names, unless the
+  /// size changed since then: in that case it falls back to find(type).
+  const ROSMessage* find(const ROSField& field) const;
+
+  /// Same as find(type), but throws std::runtime_error (with the list of the available types) if it is missing.
+  const ROSMessage& definition(const ROSType& type) const;
+
+private:
+  template <typename Predicate>
+  const ROSMessage* findImpl(const ROSType& type, Predicate predicate) const;
+
+  // ROSType::msgNameHash() -> index in the vector
+  std::unordered_multimap<size_t, size_t> _index;
+  size_t _indexed_size;
+  uint64_t _id;
+};
+
+
+inline const ROSMessage* ROSTypeList::find(const ROSField& field) const
 {
-  for(int i=0; i<_fields.size(); i++ )  {
-    if(  name ==_fields[i].name() ) {
-      return &_fields[i];
-    }
+  if( field.type().typeID() != OTHER ) return nullptr;
+
+  if( _indexed_size == size() )
+  {
+    const size_t index = static_cast<size_t>( field.messageIndex() );
+    return (index < size()) ? &(*this)[index] : nullptr;
   }
-  return nullptr;
+  return find( field.type() );
+}
+
+inline int ROSMessage::fieldIndex(const SString &name) const
+{
+  auto range = _field_index.equal_range( hashString( name.data(), name.size() ) );
+  for (auto it = range.first; it != range.second; ++it)
+  {
+    if( _fields[it->second].name() == name ) return it->second;
+  }
+  return -1;
+}
+
+inline const ROSField* ROSMessage::field(const SString &name) const
+{
+  const int index = fieldIndex( name );
+  return (index < 0) ? nullptr : &_fields[index];
 }
 
 
@@ -0,0 +1,102 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright 2016 Davide Faconti
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of Willow Garage, Inc. nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+********************************************************************/
+
+
+#ifndef ROS_INTROSPECTION_PREDICATE_H
+#define ROS_INTROSPECTION_PREDICATE_H
+
+#include "ros_type_introspection/field_locator.hpp"
+
+namespace RosIntrospection{
+
+/**
+ * @brief A MessagePredicate is a condition on the fields of a message, that is evaluated
+ * directly on the serialized data, reading only the fields it needs (see FieldLocator).
+ *
+ * The expression is a list of comparisons between a field and a literal, combined with
+ * "&&" and "||" ("&&" has higher precedence, parenthesis are not supported):
+ *
+ *     header/frame_id == "base_link"
+ *     status.0/level >= 2 && status.0/name != "motor"
+ *
+ * The operators are ==, !=, <, <=, >, >=. Integer fields are compared exactly with integer
+ * literals, the other numbers as double; strings are compared lexicographically.
+ * If an array is shorter than the index in the path, the comparison is false.
+ */
+class MessagePredicate{
+public:
+
+  /// Throws std::runtime_error if the expression is not valid for this type.
+  MessagePredicate(const ROSTypeList& type_list,
+                   const ROSType& type,
+                   const std::string& expression);
+
+  MessagePredicate(const MessageSchema& schema, const std::string& expression);
+
+  const std::string& expression() const { return _expression; }
+
+  /**
+   * @brief Evaluate the predicate on a serialized message.
+   * Throws RangeException if the buffer is shorter than the message it describes.
+   */
+  bool operator()(const uint8_t* buffer, size_t buffer_size) const;
+
+private:
+
+  enum Operator{ EQUAL, NOT_EQUAL, LESS, LESS_EQUAL, GREATER, GREATER_EQUAL };
+
+  struct Comparison{
+    FieldLocator field;
+    Operator     op;
+    double       number;
+    /// true if the literal is an integer that fits in int64_t, stored also in integer.
+    bool         is_integer;
+    int64_t      integer;
+    std::string  text;
+  };
+
+  void parse(const ROSTypeList& type_list, const ROSType& type);
+
+  template <typename T> static bool compare(const T& a, const T& b, Operator op);
+
+  bool evaluate(const Comparison& comparison, const uint8_t* buffer, size_t buffer_size) const;
+
+  std::string _expression;
+  /// disjunction of conjunctions of comparisons.
+  std::vector<std::vector<Comparison>> _terms;
+};
+
+} //end namespace
+
+#endif // ROS_INTROSPECTION_PREDICATE_H
@@ -111,14 +111,15 @@ public:
    */
   SubstitutionRule(const char* pattern, const char* alias, const char* substitution);
 
-  const std::vector<SString>& pattern() const { return _pattern; }
-  const std::vector<SString>& alias() const { return _alias; }
+  /// Interned, to be compared with the nodes of StringTree.
+  const std::vector<InternedString>& pattern() const { return _pattern; }
+  const std::vector<InternedString>& alias() const { return _alias; }
   const std::vector<SString>& substitution() const { return _substitution; }
 
 
 private:
-  std::vector<SString> _pattern;
-  std::vector<SString> _alias;
+  std::vector<InternedString> _pattern;
+  std::vector<InternedString> _alias;
   std::vector<SString> _substitution;
 } ;
 
@@ -0,0 +1,150 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright 2016 Davide Faconti
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of Willow Garage, Inc. nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+********************************************************************/
+
+#ifndef ROS_INTROSPECTION_SCHEMA_H
+#define ROS_INTROSPECTION_SCHEMA_H
+
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <boost/shared_ptr.hpp>
+#include <boost/noncopyable.hpp>
+#include "ros_type_introspection/deserializer.hpp"
+#include "ros_type_introspection/decoder_registry.hpp"
+
+namespace RosIntrospection{
+
+class ViewLayout;
+class SchemaLayout;
+
+/**
+ * @brief The MessageSchema is the parsed description of a message type, i.e. the
+ * ROSTypeList created by buildROSTypeMapFromDefinition, together with the MD5,
+ * the name and the definition that identify the type.
+ *
+ * It is immutable, therefore it can be shared between threads.
+ */
+class MessageSchema: boost::noncopyable{
+public:
+
+  typedef boost::shared_ptr<const MessageSchema> ConstPtr;
+
+  /// Parse the definition. Throws std::runtime_error if it is not valid.
+  MessageSchema(const std::string& md5sum,
+                const std::string& datatype,
+                const std::string& definition);
+
+  ~MessageSchema();
+
+  const std::string& md5sum() const     { return _md5sum; }
+
+  const std::string& datatype() const   { return _datatype; }
+
+  const std::string& definition() const { return _definition; }
+
+  /// Type of the message, to be passed to buildRosFlatType.
+  const ROSType& rootType() const       { return _root_type; }
+
+  /// The main type and all its dependencies.
+  const ROSTypeList& typeList() const   { return _type_list; }
+
+  /// Layout used by MessageView, created the first time it is requested (thread-safe).
+  const ViewLayout& viewLayout() const;
+
+  /// Sizes and offsets of the main type and its dependencies, created the first time it is requested (thread-safe).
+  const SchemaLayout& layout() const;
+
+private:
+  std::string _md5sum;
+  std::string _datatype;
+  std::string _definition;
+  ROSType     _root_type;
+  ROSTypeList _type_list;
+  mutable std::once_flag _view_layout_flag;
+  mutable std::unique_ptr<ViewLayout> _view_layout;
+  mutable std::once_flag _layout_flag;
+  mutable std::unique_ptr<SchemaLayout> _layout;
+};
+
+/**
+ * @brief Thread-safe cache of MessageSchema(s), so that each definition is parsed only once.
+ */
+class SchemaCache: boost::noncopyable{
+public:
+
+  SchemaCache() {}
+
+  /// Cache used by ShapeShifter.
+  static SchemaCache& global();
+
+  /**
+   * @brief Return the schema with the given md5sum and datatype, parsing the
+   * definition only the first time it is requested.
+   */
+  MessageSchema::ConstPtr get(const std::string& md5sum,
+                              const std::string& datatype,
+                              const std::string& definition);
+
+  size_t size() const;
+
+  void clear();
+
+private:
+  mutable std::mutex _mutex;
+  // the MD5 doesn't include the name of the type, therefore the same MD5 might
+  // correspond to multiple schemas.
+  std::unordered_map<std::string, std::vector<MessageSchema::ConstPtr>> _schemas;
+};
+
+/// Same as the other buildRosFlatType, using the main type of the schema.
+/// If a generated decoder of this type was registered in DecoderRegistry::global(), it is used instead.
+inline void buildRosFlatType(const MessageSchema& schema,
+                             SString prefix,
+                             uint8_t *buffer_ptr,
+                             ROSTypeFlat* flat_container_output,
+                             const uint32_t max_array_size )
+{
+  GeneratedDecoder decoder = DecoderRegistry::global().find( schema.md5sum(), schema.datatype() );
+  if( decoder )
+  {
+    decoder( schema.typeList(), prefix, buffer_ptr, flat_container_output, max_array_size );
+    return;
+  }
+  buildRosFlatType( schema.typeList(), schema.rootType(), prefix,
+                    buffer_ptr, flat_container_output, max_array_size );
+}
+
+} //end namespace
+
+#endif // ROS_INTROSPECTION_SCHEMA_H
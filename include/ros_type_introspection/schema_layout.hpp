@@ -0,0 +1,128 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright 2016 Davide Faconti
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of Willow Garage, Inc. nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+********************************************************************/
+
+
+#ifndef ROS_INTROSPECTION_SCHEMA_LAYOUT_H
+#define ROS_INTROSPECTION_SCHEMA_LAYOUT_H
+
+#include <boost/noncopyable.hpp>
+#include "ros_type_introspection/parser.hpp"
+
+namespace RosIntrospection{
+
+/**
+ * @brief The SchemaLayout describes the serialized representation of a message type and of
+ * the types that it contains: the size of each message and field (when it doesn't depend on
+ * the content of the message), the minimum size, the offsets that are known statically and
+ * whether strings or arrays of variable length are present.
+ *
+ * Note that ROS serialization is packed: there is no padding and no alignment between fields.
+ *
+ * It keeps pointers to the ROSMessage(s) and ROSField(s) of the type list, that must outlive it.
+ */
+class SchemaLayout: boost::noncopyable{
+public:
+
+  enum Flags{
+    /// a string, in the field itself or in the nested messages
+    HAS_STRINGS = 1,
+    /// an array of variable length, in the field itself or in the nested messages
+    HAS_VARIABLE_ARRAYS = 2
+  };
+
+  struct FieldLayout{
+    /// definition of the field in the type list.
+    const ROSField* field;
+    /// index in messages(), or -1 if the type is builtin.
+    int message_index;
+    /// serialized size of an element of the array (or the field itself), -1 if variable.
+    int element_size;
+    /// minimum serialized size of an element of the array (or the field itself).
+    uint32_t min_element_size;
+    /// serialized size of the whole field, -1 if variable (or larger than INT_MAX).
+    int fixed_size;
+    /// minimum serialized size of the whole field (4 for arrays of variable length).
+    uint32_t min_size;
+    /// offset from the start of the message, -1 if it follows a field with variable size.
+    int fixed_offset;
+    /// minimum offset from the start of the message.
+    uint32_t min_offset;
+    /// combination of Flags.
+    uint32_t flags;
+
+    const ROSType& type() const { return field->type(); }
+  };
+
+  struct MessageLayout{
+    /// definition of the message in the type list.
+    const ROSMessage* definition;
+    /// the fields that are serialized, i.e. constants are excluded.
+    std::vector<FieldLayout> fields;
+    /// serialized size, -1 if variable (or larger than INT_MAX).
+    int fixed_size;
+    /// minimum serialized size.
+    uint32_t min_size;
+    /// combination of Flags of all the fields.
+    uint32_t flags;
+
+    bool isFixedSize() const { return fixed_size >= 0; }
+  };
+
+  /// Layout of type and of all the types that it contains.
+  /// Throws std::runtime_error if the type list doesn't contain all the types needed.
+  SchemaLayout(const ROSTypeList& type_list, const ROSType& type);
+
+  /// The first one is the main type, the others are in the order in which they are found.
+  const std::vector<MessageLayout>& messages() const { return _messages; }
+
+  const MessageLayout& root() const { return _messages.front(); }
+
+  /// Indexes in messages() sorted so that the nested types come before the types that contain them.
+  const std::vector<int>& postOrder() const { return _post_order; }
+
+  /// Index in messages(), or -1 if the type isn't part of the layout.
+  int messageIndex(const ROSType& type) const;
+
+private:
+
+  int addMessage(const ROSTypeList& type_list, const ROSType& type,
+                 std::vector<const ROSMessage*>* visiting);
+
+  std::vector<MessageLayout> _messages;
+  std::vector<int> _post_order;
+};
+
+} //end namespace
+
+#endif // ROS_INTROSPECTION_SCHEMA_LAYOUT_H
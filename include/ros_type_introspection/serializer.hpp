@@ -0,0 +1,209 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright 2016 Davide Faconti
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of Willow Garage, Inc. nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+********************************************************************/
+
+
+#ifndef ROS_INTROSPECTION_SERIALIZER_H
+#define ROS_INTROSPECTION_SERIALIZER_H
+
+#include <unordered_map>
+#include <boost/noncopyable.hpp>
+#include <boost/utility/string_ref.hpp>
+#include "ros_type_introspection/deserializer.hpp"
+#include "ros_type_introspection/shape_shifter.hpp"
+
+namespace RosIntrospection{
+
+class MessageSchema;
+class SchemaLayout;
+
+/**
+ * @brief Interface used by MessageSerializer to obtain the values to write.
+ *
+ * The methods are called in the same order of the fields in the serialized message.
+ * The StringTreeLeaf(s) refer to MessageSerializer::tree(), that has the same structure
+ * of the tree created by buildRosFlatType: for instance leaf.toStr() gives the same name.
+ */
+class SerializationSource{
+public:
+  virtual ~SerializationSource() {}
+
+  /// Called at the beginning of each pass over the message
+  /// (the size is computed first, then the message is written).
+  virtual void begin() {}
+
+  /// Number of elements of a variable length array. leaf.node_ptr is the node of the field
+  /// and index_array contains the indexes of the arrays that contain it, if any.
+  virtual uint32_t arraySize(const StringTreeLeaf& leaf) = 0;
+
+  /// Value of a field (other than string). It is converted to the type of the field.
+  virtual VarNumber number(const StringTreeLeaf& leaf, const ROSType& type) = 0;
+
+  /// Value of a string. It must be valid until the next call.
+  virtual boost::string_ref string(const StringTreeLeaf& leaf) = 0;
+};
+
+/**
+ * @brief The MessageSerializer is the inverse of buildRosFlatType: it writes a serialized
+ * message, given its type and a SerializationSource.
+ *
+ * The type is compiled once in the constructor. serialize() computes the size of the message
+ * first, then writes it into a buffer that is resized only once.
+ */
+class MessageSerializer: boost::noncopyable{
+public:
+
+  /// Throws std::runtime_error if the type list doesn't contain all the types needed.
+  MessageSerializer(const ROSTypeList& type_list, const ROSType& type, SString prefix = SString());
+
+  MessageSerializer(const MessageSchema& schema, SString prefix = SString());
+
+  /// Tree of the fields of the message. It is never modified after the constructor.
+  const StringTree& tree() const { return _tree; }
+
+  /// True if the message contains variable length arrays of messages whose elements may have
+  /// no leaves at all (for instance because they contain only variable length arrays).
+  bool hasElementsWithoutLeaves() const { return _elements_without_leaves; }
+
+  /// Size of the serialized message.
+  size_t serializedSize(SerializationSource* source) const;
+
+  /// Write the message into the buffer. Throws RangeException if the buffer is too small.
+  /// @return the number of bytes written.
+  size_t write(SerializationSource* source, uint8_t* buffer, size_t buffer_size) const;
+
+  /// Resize the buffer (std::vector<uint8_t> or PooledBuffer) and write the message.
+  template <class Buffer> void serialize(SerializationSource* source, Buffer* buffer) const
+  {
+    buffer->resize( serializedSize(source) );
+    write( source, buffer->data(), buffer->size() );
+  }
+
+  /// Serialize the message into a ShapeShifter. It should be morphed with the same type.
+  void serialize(SerializationSource* source, ShapeShifter* msg) const
+  {
+    msg->resize( serializedSize(source) );
+    write( source, msg->mutable_data(), msg->size() );
+  }
+
+private:
+
+  struct Field{
+    ROSType type;
+    /// node of the field
+    const StringTreeNode* node;
+    /// node of the elements, i.e. "#" if this is an array, otherwise node.
+    const StringTreeNode* element_node;
+    /// serialized size of an element of the array (or the field itself), -1 if variable.
+    int element_size;
+    /// serialized size of the whole field, -1 if variable.
+    int fixed_size;
+    /// false if an element can be serialized without any leaf (number or string).
+    bool element_has_leaves;
+    /// fields of the message, if the type is not builtin.
+    std::vector<Field> children;
+  };
+
+  struct Writer;
+
+  void compile(const SchemaLayout& schema_layout, int message_index,
+               StringTreeNode* node, std::vector<Field>* fields, int array_depth);
+
+  size_t fieldsSize(const std::vector<Field>& fields, StringTreeLeaf leaf, SerializationSource* source) const;
+
+  size_t elementSize(const Field& field, const StringTreeLeaf& leaf, SerializationSource* source) const;
+
+  void writeFields(const std::vector<Field>& fields, StringTreeLeaf leaf,
+                   SerializationSource* source, Writer* writer) const;
+
+  void writeElement(const Field& field, const StringTreeLeaf& leaf,
+                    SerializationSource* source, Writer* writer) const;
+
+  StringTree _tree;
+  std::vector<Field> _fields;
+  bool _elements_without_leaves;
+};
+
+/**
+ * @brief SerializationSource that takes the values from a ROSTypeFlat, for instance
+ * to serialize again a message flattened by buildRosFlatType, after modifying some values.
+ *
+ * The length of variable size arrays is deduced from the indexes of the leaves. For this reason
+ * the constructor throws std::runtime_error if the container is incomplete (ROSTypeFlat::skipped_arrays),
+ * if it uses ROSTypeFlat::numeric_arrays or if the elements of an array may have no leaves at all
+ * (see MessageSerializer::hasElementsWithoutLeaves). Missing values throw std::runtime_error too.
+ */
+class FlatContainerSource: public SerializationSource{
+public:
+
+  FlatContainerSource(const MessageSerializer& serializer, const ROSTypeFlat& container);
+
+  void begin() override;
+
+  uint32_t arraySize(const StringTreeLeaf& leaf) override;
+
+  VarNumber number(const StringTreeLeaf& leaf, const ROSType& type) override;
+
+  boost::string_ref string(const StringTreeLeaf& leaf) override;
+
+private:
+
+  struct ArrayKey{
+    const StringTreeNode* node;
+    uint8_t depth;
+    std::array<uint16_t,7> index;
+    bool operator==(const ArrayKey& other) const {
+      return node == other.node && depth == other.depth && index == other.index;
+    }
+  };
+
+  struct ArrayKeyHash{
+    size_t operator()(const ArrayKey& key) const;
+  };
+
+  void mapNodes(const StringTreeNode* schema_node, const StringTreeNode* flat_node);
+
+  const StringTreeNode* flatNode(const StringTreeNode* schema_node) const;
+
+  static bool sameLeaf(const StringTreeLeaf& flat_leaf, const StringTreeNode* node, const StringTreeLeaf& leaf);
+
+  const ROSTypeFlat& _container;
+  std::unordered_map<const StringTreeNode*, const StringTreeNode*> _nodes;
+  std::unordered_map<ArrayKey, uint32_t, ArrayKeyHash> _array_size;
+  size_t _value_index;
+  size_t _name_index;
+};
+
+} //end namespace
+
+#endif // ROS_INTROSPECTION_SERIALIZER_H
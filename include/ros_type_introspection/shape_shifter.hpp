@@ -40,13 +40,53 @@
 #include "ros/console.h"
 #include "ros/assert.h"
 #include <vector>
-#include <boost/flyweight.hpp>
+#include <boost/shared_array.hpp>
 #include <ros/message_traits.h>
 #include "ros_type_introspection/ros_introspection.hpp"
+#include "ros_type_introspection/buffer_pool.hpp"
+#include "ros_type_introspection/schema.hpp"
 
 namespace RosIntrospection
 {
 
+/**
+ * @brief Type information of a ShapeShifter. It is immutable and shared by all the
+ * messages received through the same connection.
+ */
+struct MessageInfo
+{
+  typedef boost::shared_ptr<const MessageInfo> ConstPtr;
+
+  std::string md5sum;
+  std::string datatype;
+  std::string definition;
+
+  /// False if md5sum is "*".
+  bool typed;
+
+  /// Empty if the ShapeShifter is untyped, the definition is not available or it can't be parsed.
+  MessageSchema::ConstPtr schema;
+
+  /// Why the definition couldn't be parsed, empty otherwise.
+  std::string schema_error;
+
+  /**
+   * @brief Create a new MessageInfo, resolving the schema through SchemaCache::global().
+   * It never throws because of the definition: the messages can still be received and
+   * forwarded without a schema (see schema_error).
+   */
+  static ConstPtr create(const std::string& md5sum,
+                         const std::string& datatype,
+                         const std::string& definition);
+
+  /**
+   * @brief Return the MessageInfo of a connection. It is created only the first time
+   * a connection header is seen; after that, the lookup is based only on the address
+   * of the header.
+   */
+  static ConstPtr fromConnectionHeader(const boost::shared_ptr<ros::M_string>& connection_header);
+};
+
 /**
  * @brief The ShapeShifter class is a type erased container for ROS Messages.
  * It can be used also to create generic publishers and subscribers.
@@ -68,6 +108,16 @@ public:
   std::string const& getMD5Sum()            const;
   std::string const& getMessageDefinition() const;
 
+  /**
+   * @brief Parsed schema of the message, resolved by morph() through SchemaCache::global().
+   * Empty if the ShapeShifter is untyped or the definition is not available or not valid
+   * (see MessageInfo::schema_error).
+   */
+  const MessageSchema::ConstPtr& schema() const;
+
+  /// Type information shared with the other messages of the same connection.
+  const MessageInfo::ConstPtr& info() const { return info_; }
+
   // Helper for advertising
   ros::Publisher advertise(ros::NodeHandle& nh, const std::string& topic, uint32_t queue_size,
                            bool latch=false,
@@ -90,19 +140,48 @@ public:
   template<typename Message>
   void direct_read(const Message& msg,bool morph);
 
+  /**
+   * @brief Reference a serialized message instead of copying it.
+   * The ShapeShifter shares the ownership of the buffer, that will be kept alive
+   * until a new message is read or the ShapeShifter is destroyed.
+   *
+   * @param owner  reference counted owner of the memory pointed by data.
+   * @param data   first byte of the serialized message.
+   * @param size   size of the serialized message.
+   */
+  void borrow(const boost::shared_ptr<const void>& owner, const uint8_t* data, uint32_t size);
+
+  ///! Reference the buffer of a ros::SerializedMessage, without copying it.
+  void borrow(const ros::SerializedMessage& serialized_msg);
+
+  ///! True if the data is referenced (see borrow) rather than owned.
+  bool isBorrowed() const { return borrowed_owner_ != nullptr; }
+
   //! Return the size of the serialized message
   uint32_t size() const;
 
+  ///! Data that can be modified in place. A borrowed buffer is copied first.
+  uint8_t* mutable_data();
+
+  ///! Change the size of the serialized message, preserving its content (see mutable_data).
+  void resize(uint32_t new_size);
+
   void morph(const std::string& md5sum, const std::string& datatype_, const std::string& msg_def_);
 
+  ///! Cheaper version of morph, used when the MessageInfo was already created.
+  void morph(const MessageInfo::ConstPtr& info);
+
 private:
 
-  boost::flyweight<std::string> md5_;
-  boost::flyweight<std::string> datatype_;
-  boost::flyweight<std::string> msg_def_;
-  bool typed_;
+  MessageInfo::ConstPtr info_;
+
+  // memory is recycled through BufferPool::global()
+  PooledBuffer msgBuf_;
 
-  std::vector<uint8_t> msgBuf_;
+  // used instead of msgBuf_ when the data is borrowed
+  boost::shared_ptr<const void> borrowed_owner_;
+  const uint8_t* borrowed_data_;
+  uint32_t borrowed_size_;
 
 };
 
@@ -171,11 +250,8 @@ struct PreDeserialize<RosIntrospection::ShapeShifter>
 {
   static void notify(const PreDeserializeParams<RosIntrospection::ShapeShifter>& params)
   {
-    std::string md5      = (*params.connection_header)["md5sum"];
-    std::string datatype = (*params.connection_header)["type"];
-    std::string msg_def  = (*params.connection_header)["message_definition"];
-
-    params.message->morph(md5, datatype, msg_def);
+    // the connection header is shared by all the messages of the same connection
+    params.message->morph( RosIntrospection::MessageInfo::fromConnectionHeader(params.connection_header) );
   }
 };
 
@@ -193,7 +269,7 @@ namespace RosIntrospection
 template<class M> inline 
 boost::shared_ptr<M> ShapeShifter::instantiate() const
 {
-  if (!typed_)
+  if (!info_ || !info_->typed)
     throw std::runtime_error("Tried to instantiate message from an untyped ShapeShifter2.");
 
   if (ros::message_traits::datatype<M>() != getDataType())
@@ -204,7 +280,7 @@ boost::shared_ptr<M> ShapeShifter::instantiate() const
 
   boost::shared_ptr<M> p(boost::make_shared<M>());
 
-  ros::serialization::IStream s(msgBuf_.data(), msgBuf_.size() );
+  ros::serialization::IStream s( const_cast<uint8_t*>(raw_data()), size() );
   ros::serialization::deserialize(s, *p);
 
   return p;
@@ -212,22 +288,23 @@ boost::shared_ptr<M> ShapeShifter::instantiate() const
 
 template<typename Stream> inline 
 void ShapeShifter::write(Stream& stream) const {
-  if (msgBuf_.size() > 0)
-    memcpy(stream.advance(msgBuf_.size()), msgBuf_.data(), msgBuf_.size());
+  if (size() > 0)
+    memcpy(stream.advance(size()), raw_data(), size());
 }
 
 inline const uint8_t* ShapeShifter::raw_data() const {
-  return msgBuf_.data();
+  return borrowed_owner_ ? borrowed_data_ : msgBuf_.data();
 }
 
-uint32_t ShapeShifter::size() const
+inline uint32_t ShapeShifter::size() const
 {
-  return msgBuf_.size();
+  return borrowed_owner_ ? borrowed_size_ : msgBuf_.size();
 }
 
 template<typename Stream> inline 
 void ShapeShifter::read(Stream& stream)
 {
+  borrowed_owner_.reset();
   //allocate enough space
   msgBuf_.resize( stream.getLength() );
   //copy
@@ -247,6 +324,7 @@ void ShapeShifter::direct_read(const Message& msg, bool do_morph)
 
   auto length = ros::serialization::serializationLength(msg);
 
+  borrowed_owner_.reset();
   //allocate enough space
   msgBuf_.resize( length );
   //copy
@@ -255,33 +333,101 @@ void ShapeShifter::direct_read(const Message& msg, bool do_morph)
 }
 
 inline ShapeShifter::ShapeShifter()
-  :  typed_(false),
-     msgBuf_()
+  :  msgBuf_(),
+     borrowed_data_(nullptr),
+     borrowed_size_(0)
+{
+}
+
+inline void ShapeShifter::borrow(const boost::shared_ptr<const void>& owner, const uint8_t* data, uint32_t size)
+{
+  if( !owner )
+    throw std::runtime_error("ShapeShifter::borrow requires a valid owner of the buffer.");
+
+  borrowed_owner_ = owner;
+  borrowed_data_  = data;
+  borrowed_size_  = size;
+  msgBuf_.clear();
+}
+
+inline void ShapeShifter::borrow(const ros::SerializedMessage& serialized_msg)
 {
+  // message_start skips the 4 bytes of the length prefix
+  const uint8_t* data = serialized_msg.message_start;
+  const uint32_t size = serialized_msg.num_bytes - (data - serialized_msg.buf.get());
+
+  // the deleter holds a copy of the shared_array, keeping the buffer alive
+  boost::shared_array<uint8_t> buffer = serialized_msg.buf;
+  boost::shared_ptr<const void> owner( static_cast<const void*>(buffer.get()),
+                                       [buffer](const void*) {} );
+  borrow(owner, data, size);
 }
 
 
+inline uint8_t* ShapeShifter::mutable_data()
+{
+  if( borrowed_owner_ )
+  {
+    msgBuf_.resize( borrowed_size_ );
+    if( borrowed_size_ > 0 ) {
+      memcpy( msgBuf_.data(), borrowed_data_, borrowed_size_ );
+    }
+    borrowed_owner_.reset();
+  }
+  return msgBuf_.data();
+}
+
+inline void ShapeShifter::resize(uint32_t new_size)
+{
+  mutable_data();
+  msgBuf_.resize( new_size );
+}
+
 inline ShapeShifter::~ShapeShifter()
 {
 
 }
 
 
-inline std::string const& ShapeShifter::getDataType()          const { return datatype_; }
+namespace details{
+inline const std::string& emptyString()
+{
+  static const std::string empty;
+  return empty;
+}
+}
 
+inline std::string const& ShapeShifter::getDataType()          const { return info_ ? info_->datatype : details::emptyString(); }
 
-inline std::string const& ShapeShifter::getMD5Sum()            const { return md5_;   }
 
+inline std::string const& ShapeShifter::getMD5Sum()            const { return info_ ? info_->md5sum : details::emptyString(); }
 
-inline std::string const& ShapeShifter::getMessageDefinition() const { return msg_def_;  }
+
+inline std::string const& ShapeShifter::getMessageDefinition() const { return info_ ? info_->definition : details::emptyString(); }
+
+
+inline const MessageSchema::ConstPtr& ShapeShifter::schema() const
+{
+  static const MessageSchema::ConstPtr empty;
+  return info_ ? info_->schema : empty;
+}
 
 
 inline void ShapeShifter::morph(const std::string& _md5sum, const std::string& _datatype, const std::string& _msg_def)
 {
-  md5_ = _md5sum;
-  datatype_ = _datatype;
-  msg_def_ = _msg_def;
-  typed_ = (md5_ != "*");
+  // md5sum and datatype identify the definition, no need to compare its whole text
+  if( info_ && info_->md5sum == _md5sum && info_->datatype == _datatype &&
+      info_->definition.size() == _msg_def.size() )
+  {
+    return;
+  }
+  info_ = MessageInfo::create( _md5sum, _datatype, _msg_def );
+}
+
+
+inline void ShapeShifter::morph(const MessageInfo::ConstPtr& info)
+{
+  info_ = info;
 }
 
 
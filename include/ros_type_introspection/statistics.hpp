@@ -0,0 +1,122 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright 2016 Davide Faconti
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of Willow Garage, Inc. nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+********************************************************************/
+
+
+#ifndef ROS_INTROSPECTION_STATISTICS_H
+#define ROS_INTROSPECTION_STATISTICS_H
+
+#include <stdint.h>
+#include <atomic>
+#include <mutex>
+#include <memory>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <boost/noncopyable.hpp>
+#include "ros_type_introspection/parser.hpp"
+
+namespace RosIntrospection{
+
+/**
+ * @brief Counters of a single ROS type. They are updated by buildRosFlatType and
+ * applyNameTransform when the DecodeStatistics are enabled.
+ */
+struct TypeCounters: boost::noncopyable{
+
+  TypeCounters();
+
+  std::atomic<uint64_t> messages;
+  std::atomic<uint64_t> bytes;
+  std::atomic<uint64_t> leaves;
+  std::atomic<uint64_t> skipped_arrays;
+  std::atomic<uint64_t> decode_ns;
+  std::atomic<uint64_t> rename_ns;
+};
+
+/// Copy of the TypeCounters, returned by DecodeStatistics::snapshot().
+struct TypeStatistics{
+  std::string datatype;
+  /// number of messages decoded by buildRosFlatType.
+  uint64_t messages;
+  /// bytes of serialized data consumed.
+  uint64_t bytes;
+  /// elements of ROSTypeFlat::value, ROSTypeFlat::name and ROSTypeFlat::array_values.
+  uint64_t leaves;
+  /// arrays skipped because they were larger than max_array_size.
+  uint64_t skipped_arrays;
+  /// cumulative time spent in buildRosFlatType, in nanoseconds.
+  uint64_t decode_ns;
+  /// cumulative time spent in applyNameTransform, in nanoseconds.
+  uint64_t rename_ns;
+};
+
+/**
+ * @brief Opt-in instrumentation of the deserializer, with one set of counters per ROS type.
+ *
+ * It is disabled by default; in that case the overhead is a single atomic load per call.
+ * When enabled, the counters of a type are looked up only when the tree of the ROSTypeFlat
+ * is created, therefore the steady state doesn't allocate memory.
+ *
+ * All the methods are thread-safe.
+ */
+class DecodeStatistics: boost::noncopyable{
+public:
+
+  DecodeStatistics(): _enabled(false) {}
+
+  /// The instance used by buildRosFlatType and applyNameTransform.
+  static DecodeStatistics& global();
+
+  void setEnabled(bool enabled) { _enabled.store(enabled, std::memory_order_relaxed); }
+
+  bool isEnabled() const { return _enabled.load(std::memory_order_relaxed); }
+
+  /// Counters of a type, created the first time. The pointer is valid as long as this object.
+  TypeCounters* counters(const SString& datatype);
+
+  /// Current value of the counters of all the types.
+  std::vector<TypeStatistics> snapshot() const;
+
+  /// Set all the counters to zero.
+  void reset();
+
+private:
+  std::atomic<bool> _enabled;
+  mutable std::mutex _mutex;
+  std::unordered_map<std::string, std::unique_ptr<TypeCounters>> _counters;
+};
+
+} //end namespace
+
+#endif // ROS_INTROSPECTION_STATISTICS_H
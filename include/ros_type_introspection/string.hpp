@@ -42,6 +42,7 @@
 #include <type_traits>
 
 #include <iostream>
+#include "ros_type_introspection/details/hash.hpp"
 
 namespace ssoX {
 
@@ -95,6 +96,17 @@ void set_msb(unsigned char& byte, bool bit) {
 
 }
 
+/**
+ * Source of the memory of the strings that don't fit in the SSO buffer
+ * (a minimal version of std::pmr::memory_resource, that is not available in C++11).
+ */
+class memory_resource {
+public:
+    virtual ~memory_resource() {}
+    virtual void* allocate(std::size_t bytes) = 0;
+    virtual void deallocate(void* ptr, std::size_t bytes) = 0;
+};
+
 template <typename CharT, typename Traits = std::char_traits<CharT>>
 class basic_string {
     typedef typename std::make_unsigned<CharT>::type UCharT;
@@ -103,18 +115,29 @@ public:
         : basic_string("", static_cast<std::size_t>(0)) {
     }
 
-    basic_string(CharT const* string, std::size_t size) {
+    basic_string(CharT const* string, std::size_t size)
+        : basic_string(string, size, nullptr) {
+    }
+
+    // If the string doesn't fit in the SSO buffer, its memory is obtained from resource
+    // (new[] if it is nullptr), that must outlive the string. Copies use new[].
+    basic_string(CharT const* string, std::size_t size, memory_resource* resource) {
 
         if(size <= sso_capacity) {
             Traits::move(m_data.sso.string, string, size);
             Traits::assign(m_data.sso.string[size], static_cast<CharT>(0));
             set_sso_size(size);
         } else {
-            size_t new_size = std::max( sso_capacity*2, size );
-            m_data.non_sso.ptr = new CharT[new_size +1 ];
+            size_t new_capacity = std::max( sso_capacity*2, size );
+            if( resource ) {
+                // the arena can't be grown in place: don't waste it
+                new_capacity = size;
+            }
+            m_data.non_sso.ptr = allocate(new_capacity, resource);
             Traits::move(m_data.non_sso.ptr, string, size);
             Traits::assign(m_data.non_sso.ptr[size], static_cast<CharT>(0));
-            set_non_sso_data(size, size);
+            set_non_sso_data(size, new_capacity);
+            set_resource(resource);
         }
     }
 
@@ -170,6 +193,13 @@ public:
         this->resize(0);
     }
 
+    /// Replace the content. The memory is obtained from resource, as in the constructor.
+    void assign(const CharT* buffer, size_t length, memory_resource* resource )
+    {
+        basic_string tmp(buffer, length, resource);
+        swap(tmp, *this);
+    }
+
     void assign(const CharT* buffer, size_t length )
     {
         this->resize(length);
@@ -189,8 +219,10 @@ public:
           // it will be SSO
             if( !this->sso() ) {
                 CharT* ptr = m_data.non_sso.ptr;
+                const std::size_t old_capacity = capacity();
+                memory_resource* resource = this->resource();
                 Traits::move( m_data.sso.string, ptr, std::min(old_size, new_size) ); // most probably new_size
-                delete[] ptr;
+                deallocate(ptr, old_capacity, resource);
             }
             Traits::assign(m_data.sso.string[new_size], static_cast<CharT>(0));
             set_sso_size(new_size);
@@ -198,11 +230,12 @@ public:
           // it will be non_sso
             size_t new_capacity = 0;
             CharT* ptr = nullptr;
+            memory_resource* resource = this->resource();
 
             if( this->sso() ){
                 // from sso to non_sso. Need to allocate new memory
                 new_capacity =  std::max(new_size, sso_capacity*2);
-                ptr = new CharT[ new_capacity + 1];
+                ptr = allocate( new_capacity, nullptr );
                 Traits::move( ptr, m_data.sso.string, std::min(old_size, new_size) );
                 m_data.non_sso.ptr = ptr;
             }
@@ -214,14 +247,15 @@ public:
             else{
                 // was non_sso, still non_sso. But I need to allocate more memory
                 new_capacity = std::max(new_size, capacity()*3/2);
-                ptr = new CharT[ new_capacity + 1];
+                ptr = allocate( new_capacity, resource );
                 Traits::move( ptr, m_data.non_sso.ptr, std::min(old_size, new_size) );
-                delete[] m_data.non_sso.ptr ;
+                deallocate( m_data.non_sso.ptr, capacity(), resource );
                 m_data.non_sso.ptr = ptr;
             }
 
             Traits::assign(m_data.non_sso.ptr[new_size], static_cast<CharT>(0));
             set_non_sso_data(new_size, new_capacity);
+            set_resource(resource);
         }
     }
 
@@ -254,8 +288,18 @@ public:
 
     ~basic_string() {
         if(!sso()) {
-            delete[] m_data.non_sso.ptr;
+            deallocate(m_data.non_sso.ptr, capacity(), resource());
+        }
+    }
+
+    /// Resource that provided the memory of the string; nullptr if it is new[] or the string is SSO.
+    memory_resource* resource() const noexcept {
+        if(sso()) {
+            return nullptr;
         }
+        memory_resource* resource;
+        std::memcpy(&resource, m_data.non_sso.overhead, sizeof(resource));
+        return resource;
     }
 
     CharT const* data() const noexcept {
@@ -312,6 +356,26 @@ private:
         set_sso_size(0);
     }
 
+    static CharT* allocate(std::size_t capacity, memory_resource* resource) {
+        if( resource ) {
+            return static_cast<CharT*>( resource->allocate( (capacity + 1) * sizeof(CharT) ) );
+        }
+        return new CharT[capacity + 1];
+    }
+
+    static void deallocate(CharT* ptr, std::size_t capacity, memory_resource* resource) {
+        if( resource ) {
+            resource->deallocate( ptr, (capacity + 1) * sizeof(CharT) );
+        } else {
+            delete[] ptr;
+        }
+    }
+
+    // only in non_sso mode, where the first bytes are not used
+    void set_resource(memory_resource* resource) noexcept {
+        std::memcpy(m_data.non_sso.overhead, &resource, sizeof(resource));
+    }
+
     // We are using sso if the last two bits are 0
     bool sso() const noexcept {
         return !detail::lsb<0>(m_data.sso.size) && !detail::lsb<1>(m_data.sso.size);
@@ -380,6 +444,9 @@ private:
         } sso;
     } m_data;
 
+    static_assert( sizeof(Data::NonSSO::overhead) >= sizeof(memory_resource*),
+                   "no room for the memory_resource" );
+
 public:
     static std::size_t const sso_capacity =  sizeof(typename Data::NonSSO) / sizeof(CharT)  - 1;
 };
@@ -415,4 +482,26 @@ bool operator < (const basic_string<CharT, Traits>& lhs,
 
 }
 
+namespace RosIntrospection{
+
+/// Hash of the characters, the same used by std::hash<SString> and InternedString::hash().
+inline size_t hashString(const char* str, size_t size)
+{
+  return static_cast<size_t>( details::hashBytes( str, size ) );
+}
+
+} //end namespace
+
+namespace std{
+
+template <> struct hash< ssoX::basic_string<char> >
+{
+  size_t operator()(const ssoX::basic_string<char>& str) const
+  {
+    return RosIntrospection::hashString( str.data(), str.size() );
+  }
+};
+
+} //end namespace std
+
 #endif
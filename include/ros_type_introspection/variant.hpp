@@ -11,6 +11,8 @@
 namespace RosIntrospection
 {
 
+class VarNumberColumn;
+
 class VarNumber
 {
 
@@ -26,11 +28,27 @@ public:
 
   template<typename T> T convert( ) const;
 
+  /**
+   * @brief Same rules of convert(), but it doesn't throw: it returns false (and leaves
+   * target unchanged) when the value can't be represented exactly by T.
+   */
+  template<typename T> bool tryConvert(T& target) const noexcept;
+
+  /**
+   * @brief Conversion that never fails: integers saturate to the limits of T, floating point
+   * values lose precision (they are truncated if T is an integer) and ros::Time/Duration are
+   * converted to seconds. NaN becomes 0 if T is an integer.
+   *
+   * Types that are not numbers (VarNumber() for instance) become NaN, or 0 if T is an integer.
+   */
+  template<typename T> T convertLossy( ) const noexcept;
+
   template<typename T> T extract( ) const;
 
   template <typename T> void assign(const T& value);
 
 private:
+  friend class VarNumberColumn;
   uint8_t _raw_data[9];
 
 };
@@ -99,7 +117,6 @@ template<typename DST> inline DST VarNumber::convert() const
   //----------
   switch( _raw_data[8] )
   {
-  case CHAR:
   case INT8:   convert_impl<int8_t,  DST>(*reinterpret_cast<const int8_t*>( _raw_data), target  ); break;
 
   case INT16:  convert_impl<int16_t, DST>(*reinterpret_cast<const int16_t*>( _raw_data), target  ); break;
@@ -108,6 +125,7 @@ template<typename DST> inline DST VarNumber::convert() const
 
   case BOOL:
   case BYTE:
+  case CHAR:
   case UINT8:   convert_impl<uint8_t,  DST>(*reinterpret_cast<const uint8_t*>( _raw_data), target  ); break;
 
   case UINT16:  convert_impl<uint16_t, DST>(*reinterpret_cast<const uint16_t*>( _raw_data), target  ); break;
@@ -136,7 +154,6 @@ template<> inline double VarNumber::convert() const
   //----------
   switch( _raw_data[8] )
   {
-  case CHAR:
   case INT8:   convert_impl<int8_t,  double>(*reinterpret_cast<const int8_t*>( _raw_data), target  ); break;
 
   case INT16:  convert_impl<int16_t, double>(*reinterpret_cast<const int16_t*>( _raw_data), target  ); break;
@@ -145,6 +162,7 @@ template<> inline double VarNumber::convert() const
 
   case BOOL:
   case BYTE:
+  case CHAR:
   case UINT8:   convert_impl<uint8_t,  double>(*reinterpret_cast<const uint8_t*>( _raw_data), target  ); break;
 
   case UINT16:  convert_impl<uint16_t, double>(*reinterpret_cast<const uint16_t*>( _raw_data), target  ); break;
@@ -169,6 +187,111 @@ template<> inline double VarNumber::convert() const
   return  target;
 }
 
+namespace details{
+
+template <typename DST> inline bool try_convert_seconds(double, DST&) { return false; }
+
+template <> inline bool try_convert_seconds(double seconds, double& target)
+{
+  target = seconds;
+  return true;
+}
+
+} // end namespace details
+
+template<typename DST> inline bool VarNumber::tryConvert(DST& target) const noexcept
+{
+  static_assert( std::is_arithmetic<DST>::value, "tryConvert works only with numbers");
+  using namespace RosIntrospection::details;
+
+  switch( _raw_data[8] )
+  {
+  case INT8:   return try_convert_impl<int8_t,  DST>(*reinterpret_cast<const int8_t*>( _raw_data), target ) == CONVERSION_OK;
+
+  case INT16:  return try_convert_impl<int16_t, DST>(*reinterpret_cast<const int16_t*>( _raw_data), target ) == CONVERSION_OK;
+  case INT32:  return try_convert_impl<int32_t, DST>(*reinterpret_cast<const int32_t*>( _raw_data), target ) == CONVERSION_OK;
+  case INT64:  return try_convert_impl<int64_t, DST>(*reinterpret_cast<const int64_t*>( _raw_data), target ) == CONVERSION_OK;
+
+  case BOOL:
+  case BYTE:
+  case CHAR:
+  case UINT8:  return try_convert_impl<uint8_t,  DST>(*reinterpret_cast<const uint8_t*>( _raw_data), target ) == CONVERSION_OK;
+
+  case UINT16: return try_convert_impl<uint16_t, DST>(*reinterpret_cast<const uint16_t*>( _raw_data), target ) == CONVERSION_OK;
+  case UINT32: return try_convert_impl<uint32_t, DST>(*reinterpret_cast<const uint32_t*>( _raw_data), target ) == CONVERSION_OK;
+  case UINT64: return try_convert_impl<uint64_t, DST>(*reinterpret_cast<const uint64_t*>( _raw_data), target ) == CONVERSION_OK;
+
+  case FLOAT32: return try_convert_impl<float, DST>(*reinterpret_cast<const float*>( _raw_data), target ) == CONVERSION_OK;
+  case FLOAT64: return try_convert_impl<double, DST>(*reinterpret_cast<const double*>( _raw_data), target ) == CONVERSION_OK;
+
+  // as convert(), only to double
+  case DURATION: return try_convert_seconds( reinterpret_cast<const ros::Duration*>( _raw_data)->toSec(), target );
+  case TIME:     return try_convert_seconds( reinterpret_cast<const ros::Time*>( _raw_data)->toSec(), target );
+
+  default: return false;
+  }
+}
+
+template<typename DST> inline DST VarNumber::convertLossy() const noexcept
+{
+  static_assert( std::is_arithmetic<DST>::value, "convertLossy works only with numbers");
+  using namespace RosIntrospection::details;
+
+  switch( _raw_data[8] )
+  {
+  case INT8:   return lossy_convert_impl<int8_t,  DST>(*reinterpret_cast<const int8_t*>( _raw_data) );
+
+  case INT16:  return lossy_convert_impl<int16_t, DST>(*reinterpret_cast<const int16_t*>( _raw_data) );
+  case INT32:  return lossy_convert_impl<int32_t, DST>(*reinterpret_cast<const int32_t*>( _raw_data) );
+  case INT64:  return lossy_convert_impl<int64_t, DST>(*reinterpret_cast<const int64_t*>( _raw_data) );
+
+  case BOOL:
+  case BYTE:
+  case CHAR:
+  case UINT8:  return lossy_convert_impl<uint8_t,  DST>(*reinterpret_cast<const uint8_t*>( _raw_data) );
+
+  case UINT16: return lossy_convert_impl<uint16_t, DST>(*reinterpret_cast<const uint16_t*>( _raw_data) );
+  case UINT32: return lossy_convert_impl<uint32_t, DST>(*reinterpret_cast<const uint32_t*>( _raw_data) );
+  case UINT64: return lossy_convert_impl<uint64_t, DST>(*reinterpret_cast<const uint64_t*>( _raw_data) );
+
+  case FLOAT32: return lossy_convert_impl<float, DST>(*reinterpret_cast<const float*>( _raw_data) );
+  case FLOAT64: return lossy_convert_impl<double, DST>(*reinterpret_cast<const double*>( _raw_data) );
+
+  case DURATION: return lossy_convert_impl<double, DST>( reinterpret_cast<const ros::Duration*>( _raw_data)->toSec() );
+  case TIME:     return lossy_convert_impl<double, DST>( reinterpret_cast<const ros::Time*>( _raw_data)->toSec() );
+
+  // quiet_NaN() is 0 for the integers
+  default: return std::numeric_limits<DST>::quiet_NaN();
+  }
+}
+
+/**
+ * @brief Convert "count" values using VarNumber::tryConvert. The elements of the output
+ * that can't be converted are left unchanged.
+ *
+ * @return the number of values that could NOT be converted.
+ */
+template <typename T> inline
+size_t tryConvert(const VarNumber* values, size_t count, T* output) noexcept
+{
+  size_t failures = 0;
+  for (size_t i=0; i<count; i++)
+  {
+    failures += values[i].tryConvert<T>( output[i] ) ? 0 : 1;
+  }
+  return failures;
+}
+
+/// Convert "count" values using VarNumber::convertLossy.
+template <typename T> inline
+void convertLossy(const VarNumber* values, size_t count, T* output) noexcept
+{
+  for (size_t i=0; i<count; i++)
+  {
+    output[i] = values[i].convertLossy<T>();
+  }
+}
+
 template<> inline ros::Time VarNumber::convert() const
 {
   if(  _raw_data[8] != TIME )
@@ -0,0 +1,135 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright 2016 Davide Faconti
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of Willow Garage, Inc. nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+********************************************************************/
+
+
+#ifndef ROS_INTROSPECTION_VARIANT_COLUMN_H
+#define ROS_INTROSPECTION_VARIANT_COLUMN_H
+
+#include <vector>
+#include "ros_type_introspection/variant.hpp"
+
+namespace RosIntrospection{
+
+/**
+ * @brief Column of VarNumber(s) that stores the values and their types separately:
+ * an array of 8 bytes per value and an array of type tags, that is omitted when all
+ * the values have the same type (isUniform).
+ *
+ * Compared to std::vector<VarNumber> (9 bytes each, unaligned) it is smaller and
+ * convertToDouble converts runs of values of the same type with SIMD instructions.
+ */
+class VarNumberColumn{
+public:
+
+  /// Read-only proxy of an element, with the same interface of VarNumber (use get() to obtain a copy).
+  class Reference{
+  public:
+    BuiltinType getTypeID() const { return _column->type(_index); }
+
+    template<typename T> T convert() const { return value().convert<T>(); }
+
+    template<typename T> bool tryConvert(T& target) const noexcept { return value().tryConvert<T>(target); }
+
+    template<typename T> T convertLossy() const noexcept { return value().convertLossy<T>(); }
+
+    template<typename T> T extract() const { return value().extract<T>(); }
+
+  private:
+    friend class VarNumberColumn;
+    Reference(const VarNumberColumn* column, size_t index): _column(column), _index(index) {}
+
+    VarNumber value() const { return _column->get(_index); }
+
+    const VarNumberColumn* _column;
+    size_t _index;
+  };
+
+  VarNumberColumn(): _uniform_type(OTHER) {}
+
+  size_t size() const { return _payload.size(); }
+
+  bool empty() const { return _payload.empty(); }
+
+  void reserve(size_t size) { _payload.reserve(size); }
+
+  /// Remove all the elements, but keep the allocated memory.
+  void clear();
+
+  /// True if all the elements have the same type; in this case the type tags are not stored.
+  bool isUniform() const { return _types.empty(); }
+
+  BuiltinType type(size_t index) const
+  {
+    return isUniform() ? _uniform_type : static_cast<BuiltinType>(_types[index]);
+  }
+
+  VarNumber get(size_t index) const;
+
+  Reference operator[](size_t index) const { return Reference(this, index); }
+
+  void set(size_t index, const VarNumber& value);
+
+  void push_back(const VarNumber& value);
+
+  /**
+   * @brief Append "count" serialized numbers of the same type, for instance the elements
+   * of a NumericArray. Throws TypeException if the type is STRING or OTHER.
+   */
+  void append(BuiltinType type, const uint8_t* data, size_t count);
+
+  /**
+   * @brief Convert all the elements to double, with the rules of VarNumber::convertLossy<double>()
+   * (i.e. it never throws). The output must have room for size() values.
+   */
+  void convertToDouble(double* output) const;
+
+  /// Same as the other convertToDouble, output is resized.
+  void convertToDouble(std::vector<double>* output) const;
+
+private:
+
+  // store the type of a new element, that will be added at the end.
+  void pushType(BuiltinType type, size_t count);
+
+  // the first BuiltinTypeSize[type] bytes of each value are the same of VarNumber,
+  // the others are 0.
+  std::vector<uint64_t> _payload;
+  // empty if all the values have type _uniform_type.
+  std::vector<uint8_t> _types;
+  BuiltinType _uniform_type;
+};
+
+} //end namespace
+
+#endif // ROS_INTROSPECTION_VARIANT_COLUMN_H
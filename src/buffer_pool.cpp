@@ -0,0 +1,214 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright 2016 Davide Faconti
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of Willow Garage, Inc. nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+********************************************************************/
+
+#include <algorithm>
+#include "ros_type_introspection/buffer_pool.hpp"
+
+namespace RosIntrospection{
+
+BufferPool::BufferPool(size_t max_cached_per_class, size_t max_cached_bytes, size_t max_buffer_size):
+  _max_cached_per_class(max_cached_per_class),
+  _max_cached_bytes(max_cached_bytes),
+  _num_classes(0),
+  _cached_bytes(0),
+  _hits(0), _misses(0), _recycled(0), _discarded(0)
+{
+  // classes larger than max_buffer_size are not used, neither are the ones that
+  // max_cached_bytes could never hold: their buffers would always be discarded
+  const size_t largest_class = std::min( max_buffer_size, max_cached_bytes );
+  while( _num_classes < NUM_CLASSES && (MIN_CLASS_SIZE << _num_classes) <= largest_class )
+  {
+    _num_classes++;
+  }
+}
+
+BufferPool::~BufferPool()
+{
+  clear();
+}
+
+BufferPool &BufferPool::global()
+{
+  // intentionally leaked: buffers might be released during static destruction
+  static BufferPool* pool = new BufferPool();
+  return *pool;
+}
+
+int BufferPool::sizeClass(size_t size) const
+{
+  size_t class_size = MIN_CLASS_SIZE;
+  for (int index = 0; index < _num_classes; index++)
+  {
+    if( size <= class_size ) return index;
+    class_size *= 2;
+  }
+  return -1;
+}
+
+uint8_t *BufferPool::acquire(size_t size, size_t *capacity)
+{
+  const int index = sizeClass( size );
+  if( index < 0 )
+  {
+    _misses++;
+    *capacity = size;
+    return new uint8_t[size];
+  }
+
+  *capacity = MIN_CLASS_SIZE << index;
+  {
+    SizeClass& size_class = _classes[index];
+    std::lock_guard<std::mutex> lock( size_class.mutex );
+    if( !size_class.free_list.empty() )
+    {
+      uint8_t* buffer = size_class.free_list.back();
+      size_class.free_list.pop_back();
+      _cached_bytes -= *capacity;
+      _hits++;
+      return buffer;
+    }
+  }
+  _misses++;
+  return new uint8_t[ *capacity ];
+}
+
+void BufferPool::release(uint8_t *buffer, size_t capacity)
+{
+  const int index = sizeClass( capacity );
+
+  // only buffers created by acquire() have the exact size of a class
+  if( index >= 0 && (MIN_CLASS_SIZE << index) == capacity )
+  {
+    SizeClass& size_class = _classes[index];
+    std::lock_guard<std::mutex> lock( size_class.mutex );
+    if( size_class.free_list.size() < _max_cached_per_class )
+    {
+      // reserve the bytes first: other classes might be doing the same
+      if( _cached_bytes.fetch_add( capacity ) + capacity <= _max_cached_bytes )
+      {
+        size_class.free_list.push_back( buffer );
+        _recycled++;
+        return;
+      }
+      _cached_bytes -= capacity;
+    }
+  }
+  _discarded++;
+  delete[] buffer;
+}
+
+BufferPool::Statistics BufferPool::statistics() const
+{
+  Statistics stats;
+  stats.hits      = _hits;
+  stats.misses    = _misses;
+  stats.recycled  = _recycled;
+  stats.discarded = _discarded;
+  return stats;
+}
+
+void BufferPool::resetStatistics()
+{
+  _hits = 0;
+  _misses = 0;
+  _recycled = 0;
+  _discarded = 0;
+}
+
+void BufferPool::clear()
+{
+  for (int index = 0; index < NUM_CLASSES; index++)
+  {
+    SizeClass& size_class = _classes[index];
+    std::lock_guard<std::mutex> lock( size_class.mutex );
+    for (uint8_t* buffer: size_class.free_list)
+    {
+      delete[] buffer;
+    }
+    _cached_bytes -= size_class.free_list.size() * (MIN_CLASS_SIZE << index);
+    size_class.free_list.clear();
+  }
+}
+
+//-------------------------------------------------------------------
+
+StringArena::StringArena(size_t block_size):
+  _current(0), _offset(0), _block_size( std::max<size_t>(block_size, 64) ), _capacity(0)
+{
+}
+
+StringArena::~StringArena()
+{
+  for (const Block& block: _blocks)
+  {
+    delete[] block.data;
+  }
+}
+
+void* StringArena::allocate(size_t bytes)
+{
+  const size_t aligned = (bytes + 7) & ~size_t(7);
+
+  while( _current < _blocks.size() )
+  {
+    const Block& block = _blocks[_current];
+    if( _offset + aligned <= block.size )
+    {
+      void* ptr = block.data + _offset;
+      _offset += aligned;
+      return ptr;
+    }
+    _current++;
+    _offset = 0;
+  }
+  // each new block is twice as large as the previous one
+  const size_t size = std::max( _blocks.empty() ? _block_size : _blocks.back().size * 2, aligned );
+  Block block;
+  block.data = new uint8_t[size];
+  block.size = size;
+  _blocks.push_back( block );
+  _capacity += size;
+
+  _current = _blocks.size() - 1;
+  _offset = aligned;
+  return block.data;
+}
+
+void StringArena::release()
+{
+  _current = 0;
+  _offset = 0;
+}
+
+} // end namespace
@@ -0,0 +1,479 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright 2016 Davide Faconti
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of Willow Garage, Inc. nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+********************************************************************/
+
+
+#include <sstream>
+#include "ros_type_introspection/codegen.hpp"
+#include "ros_type_introspection/schema_layout.hpp"
+#include "ros_type_introspection/details/bulk_conversion.hpp"
+
+namespace RosIntrospection{
+
+namespace {
+
+// fixed size arrays up to this size are unrolled
+const int UNROLL_LIMIT = 16;
+
+// StringTreeLeaf::index_array
+const int MAX_ARRAY_NESTING = 7;
+
+class DecoderGenerator{
+public:
+
+  DecoderGenerator(const ROSTypeList& type_list, const ROSType& type);
+
+  void generate(const std::string& md5sum, std::ostream& output);
+
+private:
+
+  struct FieldInfo{
+    std::string name;
+    ROSType type;
+    /// index in _messages, or -1 if the type is builtin.
+    int message_index;
+    /// serialized size of an element of the array (or the field itself), -1 if variable.
+    int element_size;
+    /// serialized size of the whole field, -1 if variable.
+    int fixed_size;
+  };
+
+  struct MessageInfo{
+    std::string datatype;
+    std::vector<FieldInfo> fields;
+    /// -1 if variable
+    int fixed_size;
+  };
+
+  std::string newVariable(const char* prefix) { return prefix + std::to_string(_var_count++); }
+
+  static std::string pointer(int offset);
+
+  static std::string load(const ROSType& type, const std::string& pointer);
+
+  std::string skipFunction(int message_index) const;
+
+  void flush(int* offset, const std::string& indent, std::ostream& os);
+
+  void emitMessage(int message_index, const std::string& node, const std::string& leaf, int depth,
+                   int* offset, const std::string& indent, std::ostream& os);
+
+  void emitField(const FieldInfo& field, const std::string& node, const std::string& leaf, int depth,
+                 int* offset, const std::string& indent, std::ostream& os);
+
+  void emitElement(const FieldInfo& field, const std::string& node, const std::string& leaf, int depth,
+                   int* offset, const std::string& indent, std::ostream& os);
+
+  void emitSkipMessage(int message_index, int* offset, const std::string& indent, std::ostream& os);
+
+  void emitSkipElements(const FieldInfo& field, const std::string& count, int* offset,
+                        const std::string& indent, std::ostream& os);
+
+  SchemaLayout _layout;
+  std::vector<MessageInfo> _messages;
+  int _var_count;
+};
+
+DecoderGenerator::DecoderGenerator(const ROSTypeList &type_list, const ROSType &type):
+  _layout(type_list, type), _var_count(0)
+{
+  // same indexes of the SchemaLayout, the main type is the first one
+  for (const SchemaLayout::MessageLayout& message: _layout.messages())
+  {
+    MessageInfo info;
+    info.datatype = message.definition->type().baseName().toStdString();
+    info.fixed_size = message.fixed_size;
+
+    for (const SchemaLayout::FieldLayout& field: message.fields)
+    {
+      FieldInfo field_info;
+      field_info.name = field.field->name().toStdString();
+      field_info.type = field.type();
+      field_info.message_index = field.message_index;
+      field_info.element_size = field.element_size;
+      field_info.fixed_size = field.fixed_size;
+      info.fields.push_back( field_info );
+    }
+    _messages.push_back( info );
+  }
+}
+
+std::string DecoderGenerator::pointer(int offset)
+{
+  return offset == 0 ? std::string("ptr") : "ptr + " + std::to_string(offset);
+}
+
+std::string DecoderGenerator::load(const ROSType &type, const std::string &pointer)
+{
+  const char* name = nullptr;
+  switch( type.typeID() )
+  {
+  case BOOL:     name = "bool"; break;
+  case BYTE:     name = "int8_t"; break;
+  case CHAR:     name = "char"; break;
+  case UINT8:    name = "uint8_t"; break;
+  case UINT16:   name = "uint16_t"; break;
+  case UINT32:   name = "uint32_t"; break;
+  case UINT64:   name = "uint64_t"; break;
+  case INT8:     name = "int8_t"; break;
+  case INT16:    name = "int16_t"; break;
+  case INT32:    name = "int32_t"; break;
+  case INT64:    name = "int64_t"; break;
+  case FLOAT32:  name = "float"; break;
+  case FLOAT64:  name = "double"; break;
+  // same as ROSType::deserializeFromBuffer
+  case TIME:
+  case DURATION: return "loadTime( " + pointer + " )";
+  default:
+    throw std::runtime_error( "generateDecoder: unexpected type " + type.baseName().toStdString() );
+  }
+  return std::string("load<") + name + ">( " + pointer + " )";
+}
+
+std::string DecoderGenerator::skipFunction(int message_index) const
+{
+  return "skip_" + std::to_string(message_index);
+}
+
+void DecoderGenerator::flush(int *offset, const std::string &indent, std::ostream &os)
+{
+  if( *offset > 0 )
+  {
+    os << indent << "ptr += " << *offset << ";\n";
+  }
+  *offset = 0;
+}
+
+void DecoderGenerator::emitMessage(int message_index, const std::string &node, const std::string &leaf,
+                                   int depth, int *offset, const std::string &indent, std::ostream &os)
+{
+  const MessageInfo& message = _messages[message_index];
+  for (size_t i=0; i < message.fields.size(); i++)
+  {
+    const FieldInfo& field = message.fields[i];
+    if( field.message_index >= 0 && !field.type.isArray() &&
+        _messages[field.message_index].fields.empty() )
+    {
+      continue; // nothing to read
+    }
+    const std::string child = newVariable("n");
+    os << indent << "StringTreeNode* " << child << " = &" << node << "->children()[" << i << "]; // "
+       << field.name << "\n";
+    emitField( field, child, leaf, depth, offset, indent, os );
+  }
+}
+
+void DecoderGenerator::emitElement(const FieldInfo &field, const std::string &node, const std::string &leaf,
+                                   int depth, int *offset, const std::string &indent, std::ostream &os)
+{
+  if( field.message_index >= 0 )
+  {
+    emitMessage( field.message_index, node, leaf, depth, offset, indent, os );
+  }
+  else if( field.type.typeID() == STRING )
+  {
+    flush( offset, indent, os );
+    os << indent << "ptr = storeString( ptr, leaf(" << leaf << ", " << node << "), flat );\n";
+  }
+  else{
+    os << indent << "flat->value.emplace_back( leaf(" << leaf << ", " << node << "), VarNumber( "
+       << load( field.type, pointer(*offset) ) << " ) );\n";
+    *offset += field.element_size;
+  }
+}
+
+void DecoderGenerator::emitField(const FieldInfo &field, const std::string &node, const std::string &leaf,
+                                 int depth, int *offset, const std::string &indent, std::ostream &os)
+{
+  if( !field.type.isArray() )
+  {
+    emitElement( field, node, leaf, depth, offset, indent, os );
+    return;
+  }
+  if( depth >= MAX_ARRAY_NESTING )
+  {
+    throw std::runtime_error( "generateDecoder: more than 7 nested arrays are not supported" );
+  }
+
+  const std::string elements = newVariable("e");
+  const std::string element_leaf = newVariable("l");
+  os << indent << "StringTreeNode* " << elements << " = &" << node << "->children()[0];\n"
+     << indent << "StringTreeLeaf " << element_leaf << " = " << leaf << ";\n"
+     << indent << element_leaf << ".array_size++;\n";
+
+  const int array_size = field.type.arraySize();
+  const std::string inner_indent = indent + "  ";
+
+  // see ROSTypeFlat::bulk_numeric_arrays
+  const bool numeric = field.message_index < 0 && details::isBulkConvertible( field.type.typeID() );
+  auto emit_bulk = [&](const std::string& count, const std::string& pointer, const std::string& indent)
+  {
+    os << indent << "if( flat->bulk_numeric_arrays )\n"
+       << indent << "{\n"
+       << indent << "  " << element_leaf << ".index_array[" << depth << "] = 0;\n"
+       << indent << "  " << (pointer == "ptr" ? "ptr = " : "")
+       << "appendNumericArray( leaf(" << element_leaf << ", " << elements << "), "
+       << toStr( field.type.typeID() ) << ", " << count << ", " << pointer << ", flat );\n"
+       << indent << "}\n"
+       << indent << "else{\n";
+  };
+
+  // small arrays with a fixed size: every element at a constant offset
+  if( array_size >= 0 && array_size <= UNROLL_LIMIT && field.fixed_size >= 0 )
+  {
+    os << indent << "if( " << array_size << " <= max_array_size )\n"
+       << indent << "{\n";
+    std::string element_indent = inner_indent;
+    if( numeric )
+    {
+      emit_bulk( std::to_string(array_size), pointer(*offset), inner_indent );
+      element_indent += "  ";
+    }
+    for (int i=0; i < array_size; i++)
+    {
+      int element_offset = *offset + i * field.element_size;
+      os << element_indent << element_leaf << ".index_array[" << depth << "] = " << i << ";\n";
+      emitElement( field, elements, element_leaf, depth+1, &element_offset, element_indent, os );
+    }
+    if( numeric )
+    {
+      os << inner_indent << "}\n";
+    }
+    os << indent << "}\n"
+       << indent << "else{\n"
+       << inner_indent << "flat->skipped_arrays++;\n"
+       << indent << "}\n";
+    *offset += field.fixed_size;
+    return;
+  }
+
+  flush( offset, indent, os );
+  std::string count;
+  if( array_size >= 0 )
+  {
+    count = std::to_string( array_size );
+  }
+  else{
+    count = newVariable("c");
+    os << indent << "const uint32_t " << count << " = load<uint32_t>( ptr );\n"
+       << indent << "ptr += 4;\n";
+  }
+  const std::string index = newVariable("i");
+
+  os << indent << "if( " << count << " <= max_array_size )\n"
+     << indent << "{\n";
+  std::string for_indent = inner_indent;
+  if( numeric )
+  {
+    emit_bulk( count, "ptr", inner_indent );
+    for_indent += "  ";
+  }
+  os << for_indent << "for (uint32_t " << index << "=0; " << index << " < " << count << "; " << index << "++)\n"
+     << for_indent << "{\n";
+  {
+    const std::string loop_indent = for_indent + "  ";
+    int element_offset = 0;
+    os << loop_indent << element_leaf << ".index_array[" << depth << "] = " << index << ";\n";
+    emitElement( field, elements, element_leaf, depth+1, &element_offset, loop_indent, os );
+    flush( &element_offset, loop_indent, os );
+  }
+  os << for_indent << "}\n";
+  if( numeric )
+  {
+    os << inner_indent << "}\n";
+  }
+  os << indent << "}\n"
+     << indent << "else{\n"
+     << inner_indent << "flat->skipped_arrays++;\n";
+  int skip_offset = 0;
+  emitSkipElements( field, count, &skip_offset, inner_indent, os );
+  os << indent << "}\n";
+}
+
+void DecoderGenerator::emitSkipElements(const FieldInfo &field, const std::string &count, int *offset,
+                                        const std::string &indent, std::ostream &os)
+{
+  flush( offset, indent, os );
+  if( field.element_size >= 0 )
+  {
+    os << indent << "ptr += size_t(" << count << ") * " << field.element_size << ";\n";
+    return;
+  }
+  const std::string index = newVariable("i");
+  os << indent << "for (uint32_t " << index << "=0; " << index << " < " << count << "; " << index << "++)\n"
+     << indent << "{\n";
+  if( field.message_index < 0 )
+  {
+    os << indent << "  ptr = skipString( ptr );\n";
+  }
+  else{
+    os << indent << "  ptr = " << skipFunction( field.message_index ) << "( ptr );\n";
+  }
+  os << indent << "}\n";
+}
+
+void DecoderGenerator::emitSkipMessage(int message_index, int *offset, const std::string &indent, std::ostream &os)
+{
+  for (const FieldInfo& field: _messages[message_index].fields)
+  {
+    if( field.fixed_size >= 0 )
+    {
+      *offset += field.fixed_size;
+    }
+    else if( !field.type.isArray() )
+    {
+      if( field.message_index >= 0 )
+      {
+        emitSkipMessage( field.message_index, offset, indent, os );
+      }
+      else{
+        flush( offset, indent, os );
+        os << indent << "ptr = skipString( ptr ); // " << field.name << "\n";
+      }
+    }
+    else{
+      flush( offset, indent, os );
+      std::string count;
+      if( field.type.arraySize() >= 0 )
+      {
+        count = std::to_string( field.type.arraySize() );
+      }
+      else{
+        count = newVariable("c");
+        os << indent << "const uint32_t " << count << " = load<uint32_t>( ptr ); // " << field.name << "\n"
+           << indent << "ptr += 4;\n";
+      }
+      emitSkipElements( field, count, offset, indent, os );
+    }
+  }
+}
+
+void DecoderGenerator::generate(const std::string &md5sum, std::ostream &output)
+{
+  const MessageInfo& root = _messages.front();
+
+  std::string identifier = root.datatype;
+  for (char& c: identifier)
+  {
+    if( !isalnum(c) ) c = '_';
+  }
+  std::string guard = "ROS_INTROSPECTION_GENERATED_" + identifier + "_H";
+  for (char& c: guard) c = toupper(c);
+
+  output << "// Decoder of " << root.datatype << ", generated by ros_introspection_codegen.\n"
+         << "// Do not edit: generate it again if the definition of the message changes.\n"
+         << "\n"
+         << "#ifndef " << guard << "\n"
+         << "#define " << guard << "\n"
+         << "\n"
+         << "#include <ros_type_introspection/decoder_registry.hpp>\n"
+         << "\n"
+         << "namespace RosIntrospection{\n"
+         << "namespace generated{\n"
+         << "namespace " << identifier << "{\n"
+         << "\n"
+         << "const char MD5SUM[] = \"" << md5sum << "\";\n"
+         << "const char DATATYPE[] = \"" << root.datatype << "\";\n";
+
+  // skip the elements of arrays larger than max_array_size
+  for (int index: _layout.postOrder())
+  {
+    const MessageInfo& message = _messages[index];
+    // the main type is never skipped
+    if( message.fixed_size >= 0 || index == 0 ) continue;
+
+    output << "\n"
+           << "// skip " << message.datatype << "\n"
+           << "inline const uint8_t* " << skipFunction(index) << "(const uint8_t* ptr)\n"
+           << "{\n"
+           << "  using namespace GeneratedCode;\n";
+    int offset = 0;
+    emitSkipMessage( index, &offset, "  ", output );
+    output << "  return " << pointer(offset) << ";\n"
+           << "}\n";
+  }
+
+  std::ostringstream body;
+  int offset = 0;
+  emitMessage( 0, "n", "leaf0", 0, &offset, "  ", body );
+
+  output << "\n"
+         << "inline void decode(const ROSTypeList& type_list,\n"
+         << "                   SString prefix,\n"
+         << "                   uint8_t* buffer_ptr,\n"
+         << "                   ROSTypeFlat* flat,\n"
+         << "                   const uint32_t max_array_size)\n"
+         << "{\n"
+         << "  using namespace GeneratedCode;\n";
+  if( body.str().find("max_array_size") == std::string::npos )
+  {
+    output << "  (void)max_array_size;\n";
+  }
+  output << "  static const ROSType type( DATATYPE );\n"
+         << "  buildFlatTree( type_list, type, prefix, flat );\n"
+         << "  flat->name.clear();\n"
+         << "  flat->value.clear();\n"
+         << "  flat->numeric_arrays.clear();\n"
+         << "  flat->array_values.clear();\n"
+         << "  flat->skipped_arrays = 0;\n"
+         << "\n"
+         << "  const uint8_t* ptr = buffer_ptr;\n"
+         << "  StringTreeNode* n = flat->tree.root();\n"
+         << "  StringTreeLeaf leaf0;\n"
+         << "  leaf0.node_ptr = n;\n"
+         << "\n"
+         << body.str()
+         << "}\n"
+         << "\n"
+         << "static const DecoderRegistration registration( MD5SUM, DATATYPE, &decode );\n"
+         << "\n"
+         << "} // end namespace " << identifier << "\n"
+         << "} // end namespace generated\n"
+         << "} // end namespace RosIntrospection\n"
+         << "\n"
+         << "#endif // " << guard << "\n";
+}
+
+} // end namespace
+
+
+void generateDecoder(const ROSTypeList& type_list,
+                     const ROSType& type,
+                     const std::string& md5sum,
+                     std::ostream& output)
+{
+  DecoderGenerator generator( type_list, type );
+  generator.generate( md5sum, output );
+}
+
+} // end namespace
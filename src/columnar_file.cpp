@@ -0,0 +1,398 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright 2016 Davide Faconti
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of Willow Garage, Inc. nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+********************************************************************/
+
+#include <fstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "ros_type_introspection/columnar_file.hpp"
+
+namespace RosIntrospection{
+
+namespace {
+
+const char     FILE_MAGIC[8]  = {'R','T','I','C','O','L','\0','\0'};
+const uint32_t FILE_VERSION   = 1;
+
+struct FileHeader{
+  char     magic[8];
+  uint32_t version;
+  uint32_t column_count;
+};
+
+struct ColumnHeader{
+  uint32_t name_length;
+  uint8_t  type;
+  uint8_t  padding[3];
+  uint64_t size;
+  uint64_t timestamps_offset;
+  uint64_t values_offset;
+};
+
+inline uint64_t align8(uint64_t offset)
+{
+  return (offset + 7) & ~static_cast<uint64_t>(7);
+}
+
+// True if count elements, starting at offset, are inside the file. It can't overflow.
+inline bool fitsInFile(uint64_t offset, uint64_t count, uint64_t element_size, uint64_t file_size)
+{
+  return offset <= file_size && count <= (file_size - offset) / element_size;
+}
+
+// The types that can be stored in a column and returned by ColumnView::value.
+inline bool isColumnType(BuiltinType type)
+{
+  switch( type )
+  {
+  case BOOL: case BYTE: case CHAR:
+  case INT8: case INT16: case INT32: case INT64:
+  case UINT8: case UINT16: case UINT32: case UINT64:
+  case FLOAT32: case FLOAT64:
+  case TIME: case DURATION: return true;
+  default: return false;
+  }
+}
+
+template <typename T> inline
+void appendNative(std::vector<uint8_t>& destination, const T& value)
+{
+  const size_t offset = destination.size();
+  destination.resize( offset + sizeof(T) );
+  memcpy( &destination[offset], &value, sizeof(T) );
+}
+
+template <typename T> inline
+VarNumber readNative(const uint8_t* buffer, size_t index)
+{
+  T value;
+  memcpy( &value, buffer + index*sizeof(T), sizeof(T) );
+  return VarNumber(value);
+}
+
+} // end anonymous namespace
+
+
+void ColumnarFileWriter::append(double timestamp, const RenamedValues &values)
+{
+  for(const auto& it: values)
+  {
+    appendValue( timestamp, it.first, it.second );
+  }
+}
+
+void ColumnarFileWriter::append(double timestamp, const ROSTypeFlat &flat_container)
+{
+  for(const auto& it: flat_container.value)
+  {
+    it.first.toStr( _key_buffer );
+    appendValue( timestamp, _key_buffer, it.second );
+  }
+  // the arrays stored in bulk were already converted to double
+  for(const NumericArray& array: flat_container.numeric_arrays)
+  {
+    for (uint32_t i=0; i < array.size; i++)
+    {
+      array.leafAt(i).toStr( _key_buffer );
+      appendValue( timestamp, _key_buffer, VarNumber( flat_container.array_values[array.first + i] ) );
+    }
+  }
+}
+
+void ColumnarFileWriter::appendValue(double timestamp, const std::string& key, const VarNumber& value)
+{
+  const BuiltinType type = value.getTypeID();
+  if( !isColumnType( type ) )
+  {
+    return; // nothing we can store
+  }
+
+  size_t column_index = _columns.size();
+  auto it = _column_index.find( key );
+  if( it != _column_index.end() )
+  {
+    column_index = it->second;
+  }
+  else{
+    _column_index.insert( std::make_pair(key, column_index) );
+    _columns.push_back( Column() );
+    _columns.back().name = key;
+    _columns.back().type = type;
+  }
+
+  Column& column = _columns[ column_index ];
+  if( column.type != type )
+  {
+    throw TypeException( "ColumnarFileWriter: the type of [" + key + "] changed from " +
+                         toStr(column.type) + " to " + toStr(type) );
+  }
+
+  column.timestamps.push_back( timestamp );
+
+  switch( type )
+  {
+  case BOOL:    appendNative( column.values, value.extract<bool>() ); break;
+  // 1 byte, char is read back as a C++ char and byte as int8, like the deserializer does
+  case BYTE:
+  case CHAR:    appendNative( column.values, value.convert<uint8_t>() ); break;
+
+  case INT8:    appendNative( column.values, value.extract<int8_t>() ); break;
+  case INT16:   appendNative( column.values, value.extract<int16_t>() ); break;
+  case INT32:   appendNative( column.values, value.extract<int32_t>() ); break;
+  case INT64:   appendNative( column.values, value.extract<int64_t>() ); break;
+
+  case UINT8:   appendNative( column.values, value.extract<uint8_t>() ); break;
+  case UINT16:  appendNative( column.values, value.extract<uint16_t>() ); break;
+  case UINT32:  appendNative( column.values, value.extract<uint32_t>() ); break;
+  case UINT64:  appendNative( column.values, value.extract<uint64_t>() ); break;
+
+  case FLOAT32: appendNative( column.values, value.extract<float>() ); break;
+  case FLOAT64: appendNative( column.values, value.extract<double>() ); break;
+
+  case TIME:     appendNative( column.values, value.extract<ros::Time>() ); break;
+  case DURATION: appendNative( column.values, value.extract<ros::Duration>() ); break;
+
+  default: throw TypeException( "ColumnarFileWriter: unsupported type " + std::string(toStr(type)) );
+  }
+}
+
+void ColumnarFileWriter::save(const std::string &filename) const
+{
+  // first pass: compute the offsets
+  uint64_t offset = sizeof(FileHeader);
+  for(const Column& column: _columns)
+  {
+    offset += sizeof(ColumnHeader) + align8( column.name.size() );
+  }
+
+  std::vector<ColumnHeader> headers( _columns.size() );
+
+  for(size_t i=0; i<_columns.size(); i++)
+  {
+    const Column& column = _columns[i];
+    ColumnHeader& header = headers[i];
+    memset( &header, 0, sizeof(ColumnHeader) );
+    header.name_length = column.name.size();
+    header.type = static_cast<uint8_t>( column.type );
+    header.size = column.timestamps.size();
+    header.timestamps_offset = offset;
+    offset = align8( offset + column.timestamps.size()*sizeof(double) );
+    header.values_offset = offset;
+    offset = align8( offset + column.values.size() );
+  }
+
+  // second pass: write
+  std::ofstream file( filename, std::ios::binary | std::ios::trunc );
+  if( !file )
+  {
+    throw std::runtime_error("ColumnarFileWriter: can't open file " + filename);
+  }
+
+  const char zeros[8] = {0,0,0,0,0,0,0,0};
+  uint64_t written = 0;
+
+  auto write = [&file, &written](const void* data, size_t size)
+  {
+    file.write( reinterpret_cast<const char*>(data), size );
+    written += size;
+  };
+  auto pad = [&file, &written, &zeros]()
+  {
+    file.write( zeros, align8(written) - written );
+    written = align8(written);
+  };
+
+  FileHeader file_header;
+  memcpy( file_header.magic, FILE_MAGIC, sizeof(FILE_MAGIC) );
+  file_header.version = FILE_VERSION;
+  file_header.column_count = _columns.size();
+  write( &file_header, sizeof(FileHeader) );
+
+  for(size_t i=0; i<_columns.size(); i++)
+  {
+    write( &headers[i], sizeof(ColumnHeader) );
+    write( _columns[i].name.data(), _columns[i].name.size() );
+    pad();
+  }
+
+  for(const Column& column: _columns)
+  {
+    write( column.timestamps.data(), column.timestamps.size()*sizeof(double) );
+    pad();
+    write( column.values.data(), column.values.size() );
+    pad();
+  }
+
+  if( !file )
+  {
+    throw std::runtime_error("ColumnarFileWriter: failed to write file " + filename);
+  }
+}
+
+void ColumnarFileWriter::clear()
+{
+  _columns.clear();
+  _column_index.clear();
+}
+
+//-------------------------------------------------
+
+VarNumber ColumnView::value(size_t index) const
+{
+  switch( _type )
+  {
+  case BOOL:    return readNative<bool>( _values, index );
+  case BYTE:    return readNative<int8_t>( _values, index );
+  case CHAR:    return readNative<char>( _values, index );
+
+  case INT8:    return readNative<int8_t>( _values, index );
+  case INT16:   return readNative<int16_t>( _values, index );
+  case INT32:   return readNative<int32_t>( _values, index );
+  case INT64:   return readNative<int64_t>( _values, index );
+
+  case UINT8:   return readNative<uint8_t>( _values, index );
+  case UINT16:  return readNative<uint16_t>( _values, index );
+  case UINT32:  return readNative<uint32_t>( _values, index );
+  case UINT64:  return readNative<uint64_t>( _values, index );
+
+  case FLOAT32: return readNative<float>( _values, index );
+  case FLOAT64: return readNative<double>( _values, index );
+
+  case TIME:     return readNative<ros::Time>( _values, index );
+  case DURATION: return readNative<ros::Duration>( _values, index );
+
+  default: throw TypeException( "ColumnView::value -> unsupported type" );
+  }
+}
+
+ColumnarFileReader::ColumnarFileReader(const std::string &filename):
+  _data(nullptr), _file_size(0)
+{
+  int fd = open( filename.c_str(), O_RDONLY );
+  if( fd < 0 )
+  {
+    throw std::runtime_error("ColumnarFileReader: can't open file " + filename);
+  }
+
+  struct stat file_stat;
+  if( fstat(fd, &file_stat) != 0 || file_stat.st_size < static_cast<off_t>(sizeof(FileHeader)) )
+  {
+    close(fd);
+    throw std::runtime_error("ColumnarFileReader: not a valid file " + filename);
+  }
+  _file_size = file_stat.st_size;
+
+  void* mapped = mmap( nullptr, _file_size, PROT_READ, MAP_SHARED, fd, 0 );
+  close(fd);
+  if( mapped == MAP_FAILED )
+  {
+    throw std::runtime_error("ColumnarFileReader: can't map file " + filename);
+  }
+  _data = static_cast<const uint8_t*>( mapped );
+
+  try{
+    FileHeader file_header;
+    memcpy( &file_header, _data, sizeof(FileHeader) );
+
+    if( memcmp( file_header.magic, FILE_MAGIC, sizeof(FILE_MAGIC) ) != 0 ||
+        file_header.version != FILE_VERSION )
+    {
+      throw std::runtime_error("ColumnarFileReader: wrong format or version " + filename);
+    }
+
+    // each column has at least its header in the dictionary
+    if( !fitsInFile( sizeof(FileHeader), file_header.column_count, sizeof(ColumnHeader), _file_size ) )
+    {
+      throw std::runtime_error("ColumnarFileReader: invalid number of columns " + filename);
+    }
+    _columns.resize( file_header.column_count );
+    uint64_t offset = sizeof(FileHeader);
+
+    for(ColumnView& column: _columns)
+    {
+      ColumnHeader header;
+      if( offset + sizeof(ColumnHeader) > _file_size )
+      {
+        throw std::runtime_error("ColumnarFileReader: truncated dictionary " + filename);
+      }
+      memcpy( &header, _data + offset, sizeof(ColumnHeader) );
+      offset += sizeof(ColumnHeader);
+
+      if( !isColumnType( static_cast<BuiltinType>( header.type ) ) ) {
+        throw std::runtime_error("ColumnarFileReader: invalid type " + filename);
+      }
+      if( !fitsInFile( offset, header.name_length, 1, _file_size ) ||
+          !fitsInFile( header.timestamps_offset, header.size, sizeof(double), _file_size ) ||
+          !fitsInFile( header.values_offset, header.size, BuiltinTypeSize[ header.type ], _file_size ) )
+      {
+        throw std::runtime_error("ColumnarFileReader: truncated file " + filename);
+      }
+      // timestamps and values are read in place (the writer aligns them to 8 bytes)
+      if( header.timestamps_offset % 8 != 0 || header.values_offset % 8 != 0 )
+      {
+        throw std::runtime_error("ColumnarFileReader: misaligned column " + filename);
+      }
+
+      column._name = boost::string_ref( reinterpret_cast<const char*>(_data + offset), header.name_length );
+      column._type = static_cast<BuiltinType>( header.type );
+      column._size = header.size;
+      column._timestamps = reinterpret_cast<const double*>( _data + header.timestamps_offset );
+      column._values = _data + header.values_offset;
+
+      offset += align8( header.name_length );
+    }
+  }
+  catch(...)
+  {
+    munmap( const_cast<uint8_t*>(_data), _file_size );
+    throw;
+  }
+}
+
+ColumnarFileReader::~ColumnarFileReader()
+{
+  munmap( const_cast<uint8_t*>(_data), _file_size );
+}
+
+const ColumnView* ColumnarFileReader::column(const boost::string_ref &name) const
+{
+  for(const ColumnView& column: _columns)
+  {
+    if( column.name() == name ) return &column;
+  }
+  return nullptr;
+}
+
+} // end namespace
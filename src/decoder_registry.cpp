@@ -0,0 +1,105 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright 2016 Davide Faconti
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of Willow Garage, Inc. nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+********************************************************************/
+
+
+#include "ros_type_introspection/decoder_registry.hpp"
+
+namespace RosIntrospection{
+
+DecoderRegistry &DecoderRegistry::global()
+{
+  // intentionally leaked: the generated headers register their decoders during the static initialization
+  static DecoderRegistry* registry = new DecoderRegistry();
+  return *registry;
+}
+
+void DecoderRegistry::add(const std::string &md5sum, const std::string &datatype, GeneratedDecoder decoder)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  auto& decoders = _decoders[md5sum];
+  for (auto& it: decoders)
+  {
+    if( it.first == datatype )
+    {
+      it.second = decoder;
+      return;
+    }
+  }
+  decoders.push_back( std::make_pair(datatype, decoder) );
+  _size++;
+}
+
+GeneratedDecoder DecoderRegistry::find(const std::string &md5sum, const std::string &datatype) const
+{
+  // common case: code generation is not used at all
+  if( _size.load(std::memory_order_relaxed) == 0 )
+  {
+    return nullptr;
+  }
+  std::lock_guard<std::mutex> lock(_mutex);
+  auto decoders = _decoders.find( md5sum );
+  if( decoders != _decoders.end() )
+  {
+    for (const auto& it: decoders->second)
+    {
+      if( it.first == datatype ) return it.second;
+    }
+  }
+  return nullptr;
+}
+
+void DecoderRegistry::remove(const std::string &md5sum, const std::string &datatype)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  auto decoders = _decoders.find( md5sum );
+  if( decoders != _decoders.end() )
+  {
+    auto& list = decoders->second;
+    for (size_t i=0; i < list.size(); i++)
+    {
+      if( list[i].first == datatype )
+      {
+        list.erase( list.begin() + i );
+        _size--;
+        break;
+      }
+    }
+    if( list.empty() )
+    {
+      _decoders.erase( decoders );
+    }
+  }
+}
+
+} // end namespace
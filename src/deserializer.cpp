@@ -32,8 +32,9 @@
 *  POSSIBILITY OF SUCH DAMAGE.
 ********************************************************************/
 
-#include <functional>
+#include <chrono>
 #include "ros_type_introspection/deserializer.hpp"
+#include "ros_type_introspection/details/bulk_conversion.hpp"
 
 
 namespace RosIntrospection{
@@ -41,157 +42,168 @@ namespace RosIntrospection{
 
 void buildRosFlatTypeImpl(const ROSTypeList& type_list,
                           const ROSType &type,
+                          const ROSMessage* mg_definition, // nullptr if it must be searched in type_list
                           StringTreeLeaf tree_node, // easier to use copy instead of reference or pointer
                           uint8_t** buffer_ptr,
                           ROSTypeFlat* flat_container,
                           const uint32_t max_array_size,
-                          bool do_store)
+                          bool do_store);
+
+// Deserialize a single element of the given type (i.e. an element of the array, if type is an array).
+// This used to be a std::function created for each field, but it required a memory allocation.
+inline void deserializeAndStore(const ROSTypeList& type_list,
+                                const ROSType &type,
+                                const ROSMessage* mg_definition,
+                                StringTreeLeaf tree_node,
+                                uint8_t** buffer_ptr,
+                                ROSTypeFlat* flat_container,
+                                const uint32_t max_array_size,
+                                bool STORE_RESULT)
 {
-  int array_size = type.arraySize();
-  if( array_size == -1)
-  {
-    array_size = ReadFromBuffer<int32_t>( buffer_ptr );
-  }
-
-  // std::cout << type.msgName() << " type: " <<  type.typeID() << " size: " << array_size << std::endl;
-
-  std::function<void(StringTreeLeaf, bool)> deserializeAndStore;
-
   if( type.typeID() == STRING )
   {
-    deserializeAndStore = [&flat_container, &buffer_ptr](StringTreeLeaf tree_node, bool store)
-    {
-      size_t string_size = (size_t) ReadFromBuffer<int32_t>( buffer_ptr );
-      SString id( (const char*)(*buffer_ptr), string_size );
-      (*buffer_ptr) += string_size;
-      if( store ) flat_container->name.push_back( std::make_pair( std::move(tree_node), id ) );
-    };
+    size_t string_size = (size_t) ReadFromBuffer<int32_t>( buffer_ptr );
+    if( STORE_RESULT ) {
+      flat_container->name.emplace_back( tree_node, SString( (const char*)(*buffer_ptr), string_size,
+                                                             flat_container->string_memory ) );
+    }
+    (*buffer_ptr) += string_size;
   }
   else if( type.isBuiltin())
   {
-    deserializeAndStore = [&flat_container, &buffer_ptr, type](StringTreeLeaf tree_node, bool store)
-    {
-      auto p = std::make_pair( std::move(tree_node), type.deserializeFromBuffer(buffer_ptr) );
-      if( store ) flat_container->value.push_back( p );
-    };
+    VarNumber value = type.deserializeFromBuffer(buffer_ptr);
+    if( STORE_RESULT ) flat_container->value.emplace_back( tree_node, value );
   }
-  else if( type.typeID() == OTHER)
+  else if( STORE_RESULT == false)
   {
-    const ROSMessage* mg_definition = nullptr;
-
-    for(const ROSMessage& msg: type_list) // find in the list
+    for (const ROSField& field : mg_definition->fields() )
     {
-      if( msg.type().msgName() == type.msgName() &&
-          msg.type().pkgName() == type.pkgName()  )
-      {
-        mg_definition = &msg;
-        break;
-      }
+      if( field.isConstant() ) continue;
+
+      buildRosFlatTypeImpl(type_list,
+                           field.type(),
+                           type_list.find( field ),
+                           (tree_node),
+                           buffer_ptr,
+                           flat_container,
+                           max_array_size,
+                           false);
     }
-    if( !mg_definition )
+  }
+  else{
+    auto& children_nodes = tree_node.node_ptr->children();
+
+    bool to_add = false;
+    if( children_nodes.empty() )
     {
-      std::string output( "can't deserialize this stuff: ");
-      output +=  type.baseName().toStdString() + "\n\n";
-      output +=  "Available types are: \n\n";
-      for(const ROSMessage& msg: type_list) // find in the list
-      {
-        output += "   " +msg.type().baseName().toStdString() + "\n";
-      }
-      throw std::runtime_error( output );
+      children_nodes.reserve( mg_definition->fields().size() );
+      to_add = true;
     }
 
-    deserializeAndStore = [&flat_container, &buffer_ptr, mg_definition, &type_list, max_array_size]
-        (StringTreeLeaf tree_node, bool STORE_RESULT)
+    size_t index = 0;
+
+    for (const ROSField& field : mg_definition->fields() )
     {
-      if( STORE_RESULT == false)
-      {
-        for (const ROSField& field : mg_definition->fields() )
-        {
-          buildRosFlatTypeImpl(type_list,
-                               field.type(),
-                               (tree_node),
-                               buffer_ptr,
-                               flat_container,
-                               max_array_size,
-                               false);
+      if(field.isConstant() == false) {
+
+        if( to_add ){
+          tree_node.node_ptr->addChild( field.internedName() );
         }
-      }
-      else{
-        auto& children_nodes = tree_node.node_ptr->children();
-
-        bool to_add = false;
-        if( children_nodes.empty() )
-        {
-          children_nodes.reserve( mg_definition->fields().size() );
-          to_add = true;
+        else if( index >= children_nodes.size() ){
+          throw std::runtime_error("the tree of ROSTypeFlat doesn't match the type definition");
         }
+        auto new_tree_node = tree_node;
+        new_tree_node.node_ptr = &children_nodes[index++];
+
+        buildRosFlatTypeImpl(type_list,
+                             field.type(),
+                             type_list.find( field ),
+                             (new_tree_node),
+                             buffer_ptr,
+                             flat_container,
+                             max_array_size,
+                             true);
+
+      } //end of field.isConstant()
+    } // end of for
+  } // end of STORE_RESULTS == true
+}
 
-        size_t index = 0;
-
-        for (const ROSField& field : mg_definition->fields() )
-        {
-          if(field.isConstant() == false) {
-
-            if( to_add ){
-              SString node_name( field.name() )  ;
-              tree_node.node_ptr->addChild( node_name );
-            }
-            auto new_tree_node = tree_node;
-            new_tree_node.node_ptr = &children_nodes[index++];
-
-            buildRosFlatTypeImpl(type_list,
-                                 field.type(),
-                                 (new_tree_node),
-                                 buffer_ptr,
-                                 flat_container,
-                                 max_array_size,
-                                 true);
-
-          } //end of field.isConstant()
-        } // end of for
-      } // end of STORE_RESULTS == true
-    };//end of lambda
+void buildRosFlatTypeImpl(const ROSTypeList& type_list,
+                          const ROSType &type,
+                          const ROSMessage* mg_definition, // nullptr if it must be searched in type_list
+                          StringTreeLeaf tree_node, // easier to use copy instead of reference or pointer
+                          uint8_t** buffer_ptr,
+                          ROSTypeFlat* flat_container,
+                          const uint32_t max_array_size,
+                          bool do_store)
+{
+  int array_size = type.arraySize();
+  if( array_size == -1)
+  {
+    array_size = ReadFromBuffer<int32_t>( buffer_ptr );
+  }
+
+  // std::cout << type.msgName() << " type: " <<  type.typeID() << " size: " << array_size << std::endl;
+
+  if( type.typeID() == OTHER )
+  {
+    // the fields are linked to their definition by the parser, only the main type is searched
+    if( !mg_definition ) mg_definition = &type_list.definition( type );
   }
-  else {
+  else if( type.typeID() != STRING && !type.isBuiltin() )
+  {
     throw std::runtime_error( "can't deserialize this stuff");
   }
 
   const bool STORE = ( do_store ) && ( array_size <= max_array_size );
 
-  if( array_size > max_array_size && do_store)
+  if( array_size > max_array_size && do_store )
   {
-    std::cout << "Warning: skipped a vector of type "
-              << type.baseName() << " and size "
-              << array_size << " because max_array_size = "
-              << max_array_size << "\n";
+    flat_container->skipped_arrays++;
+    if( flat_container->statistics && DecodeStatistics::global().isEnabled() )
+    {
+      flat_container->statistics->skipped_arrays++;
+    }
   }
 
   StringTreeNode* node = tree_node.node_ptr;
 
   if( type.isArray() == false  )
   {
-    deserializeAndStore( tree_node, STORE );
+    deserializeAndStore( type_list, type, mg_definition, tree_node,
+                         buffer_ptr, flat_container, max_array_size, STORE );
   }
   else
   {
     if(STORE)
     {
       node->children().reserve(1);
-      node->addChild( "#" );
+      node->addChild( arrayNodeName() );
       tree_node.node_ptr = &node->children().back();
       tree_node.array_size++;
 
+      if( flat_container->bulk_numeric_arrays && details::isBulkConvertible( type.typeID() ) )
+      {
+        tree_node.index_array[ tree_node.array_size-1 ] = 0;
+        *buffer_ptr = const_cast<uint8_t*>( appendNumericArray( tree_node, type.typeID(), array_size,
+                                                                *buffer_ptr, flat_container ) );
+        return;
+      }
+
       for (int v=0; v<array_size; v++)
       {
         tree_node.index_array[ tree_node.array_size-1 ] = static_cast<uint16_t>(v);
-        deserializeAndStore( tree_node, STORE );
+        deserializeAndStore( type_list, type, mg_definition, tree_node,
+                             buffer_ptr, flat_container, max_array_size, STORE );
       }
     }
     else{
       size_t previous_size = flat_container->value.size();
       for (int v=0; v<array_size; v++)
       {
-        deserializeAndStore( tree_node, STORE );
+        deserializeAndStore( type_list, type, mg_definition, tree_node,
+                             buffer_ptr, flat_container, max_array_size, STORE );
       }
       size_t new_size = flat_container->value.size();
       if( new_size > previous_size)
@@ -209,23 +221,144 @@ void buildRosFlatType(const ROSTypeList& type_map,
                       ROSTypeFlat* flat_container_output,
                       const uint32_t max_array_size )
 {
+  typedef std::chrono::steady_clock Clock;
+  DecodeStatistics& statistics = DecodeStatistics::global();
+  const bool measure = statistics.isEnabled();
+  Clock::time_point start_time;
+  if( measure ) start_time = Clock::now();
+
+  uint8_t* const buffer_start = buffer_ptr;
   uint8_t** buffer = &buffer_ptr;
 
-  flat_container_output->tree.root()->children().clear();
-  flat_container_output->tree.root()->value() = prefix;
+  StringTreeNode* root = flat_container_output->tree.root();
+
+  // Nodes are added to the tree only when they are missing, therefore the tree
+  // created by a previous message of the same type can be used again.
+  const bool same_tree = ( type_map.id() != 0 &&
+                           flat_container_output->tree_type_list_id == type_map.id() &&
+                           flat_container_output->tree_type == type.baseName() &&
+                           root->value() == prefix );
+  if( !same_tree )
+  {
+    root->children().clear();
+    root->value() = prefix;
+    flat_container_output->tree_type = type.baseName();
+    flat_container_output->tree_type_list_id = type_map.id();
+    flat_container_output->tree_complete = false;
+    flat_container_output->statistics = nullptr;
+  }
+  if( measure && !flat_container_output->statistics )
+  {
+    flat_container_output->statistics = statistics.counters( type.baseName() );
+  }
   flat_container_output->name.clear();
   flat_container_output->value.clear();
+  flat_container_output->numeric_arrays.clear();
+  flat_container_output->array_values.clear();
+  flat_container_output->skipped_arrays = 0;
 
   StringTreeLeaf rootnode;
-  rootnode.node_ptr = flat_container_output->tree.root();
+  rootnode.node_ptr = root;
 
   buildRosFlatTypeImpl( type_map,
                         type,
+                        nullptr,
                         rootnode,
                         buffer,
                         flat_container_output,
                         max_array_size,
                         true);
+
+  if( measure )
+  {
+    TypeCounters* counters = flat_container_output->statistics;
+    counters->messages++;
+    counters->bytes += static_cast<uint64_t>( buffer_ptr - buffer_start );
+    counters->leaves += flat_container_output->value.size() + flat_container_output->name.size() +
+                       flat_container_output->array_values.size();
+    counters->decode_ns += std::chrono::duration_cast<std::chrono::nanoseconds>( Clock::now() - start_time ).count();
+  }
+}
+
+const uint8_t* appendNumericArray(const StringTreeLeaf& leaf,
+                                  BuiltinType type,
+                                  uint32_t size,
+                                  const uint8_t* buffer_ptr,
+                                  ROSTypeFlat* flat_container_output)
+{
+  std::vector<double>& values = flat_container_output->array_values;
+  const size_t first = values.size();
+  values.resize( first + size );
+  details::convertToDouble( type, buffer_ptr, size, values.data() + first );
+
+  NumericArray array;
+  array.leaf  = leaf;
+  array.type  = type;
+  array.first = first;
+  array.size  = size;
+  array.data  = buffer_ptr;
+  flat_container_output->numeric_arrays.push_back( array );
+
+  return buffer_ptr + size_t(size) * BuiltinTypeSize[type];
+}
+
+static void addTreeNodes(const ROSTypeList& type_list, const ROSType& type,
+                         const ROSMessage* mg_definition, StringTreeNode* node)
+{
+  if( type.isArray() )
+  {
+    node->children().reserve(1);
+    node->addChild( arrayNodeName() );
+    node = &node->children().back();
+  }
+  if( type.typeID() != OTHER )
+  {
+    return;
+  }
+
+  if( !mg_definition )
+  {
+    mg_definition = &type_list.definition( type );
+  }
+
+  node->children().reserve( mg_definition->fields().size() );
+  for (const ROSField& field : mg_definition->fields() )
+  {
+    if( !field.isConstant() ) node->addChild( field.internedName() );
+  }
+  size_t index = 0;
+  for (const ROSField& field : mg_definition->fields() )
+  {
+    if( !field.isConstant() )
+    {
+      addTreeNodes( type_list, field.type(), type_list.find( field ), &node->children()[index++] );
+    }
+  }
+}
+
+void buildFlatTree(const ROSTypeList& type_map,
+                   const ROSType& type,
+                   SString prefix,
+                   ROSTypeFlat* flat_container_output)
+{
+  StringTreeNode* root = flat_container_output->tree.root();
+
+  if( flat_container_output->tree_complete &&
+      type_map.id() != 0 &&
+      flat_container_output->tree_type_list_id == type_map.id() &&
+      flat_container_output->tree_type == type.baseName() &&
+      root->value() == prefix )
+  {
+    return;
+  }
+  root->children().clear();
+  root->value() = prefix;
+  flat_container_output->tree_type = type.baseName();
+  flat_container_output->tree_type_list_id = type_map.id();
+  flat_container_output->statistics = nullptr;
+
+  addTreeNodes( type_map, type, nullptr, root );
+  flat_container_output->tree_complete = true;
 }
 
 StringTreeLeaf::StringTreeLeaf(): node_ptr(nullptr), array_size(0)
@@ -289,8 +422,8 @@ int StringTreeLeaf::toStr(char* buffer) const
 
   while ( index >=0 )
   {
-    const SString& value =  nodes_from_leaf_to_root[index]->value();
-    if( value.size()== 1 && value.at(0) == '#' )
+    const InternedString& value =  nodes_from_leaf_to_root[index]->value();
+    if( value == arrayNodeName() )
     {
       buffer[off-1] = '.';
       off += print_number(&buffer[off], this->index_array[ array_count++ ] );
@@ -0,0 +1,319 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright 2016 Davide Faconti
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of Willow Garage, Inc. nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+********************************************************************/
+
+
+#include <cstring>
+#include "ros_type_introspection/field_locator.hpp"
+#include "ros_type_introspection/schema.hpp"
+#include "ros_type_introspection/schema_layout.hpp"
+
+namespace RosIntrospection{
+
+namespace {
+
+inline void advance(const uint8_t** ptr, const uint8_t* end, uint64_t bytes)
+{
+  if( bytes > static_cast<uint64_t>(end - *ptr) )
+  {
+    throw RangeException("FieldLocator: the buffer is shorter than the serialized message");
+  }
+  *ptr += bytes;
+}
+
+inline uint32_t readLength(const uint8_t** ptr, const uint8_t* end)
+{
+  const uint8_t* length_ptr = *ptr;
+  advance( ptr, end, sizeof(uint32_t) );
+  uint32_t length;
+  memcpy( &length, length_ptr, sizeof(uint32_t) );
+  return length;
+}
+
+} // end namespace
+
+
+FieldLocator::FieldLocator(const ROSTypeList &type_list,
+                           const ROSType &type,
+                           const std::string &path):
+  _path(path)
+{
+  init( SchemaLayout( type_list, type ) );
+}
+
+FieldLocator::FieldLocator(const MessageSchema &schema, const std::string &path):
+  _path(path)
+{
+  init( schema.layout() );
+}
+
+void FieldLocator::init(const SchemaLayout &schema_layout)
+{
+  // same indexes of the SchemaLayout, the main type is the first one
+  for (const SchemaLayout::MessageLayout& message: schema_layout.messages())
+  {
+    std::vector<FieldLayout> fields;
+    for (const SchemaLayout::FieldLayout& field: message.fields)
+    {
+      FieldLayout layout;
+      layout.type = field.type();
+      layout.message_index = field.message_index;
+      layout.element_size = field.element_size;
+      layout.fixed_size = field.fixed_size;
+      fields.push_back( layout );
+    }
+    _messages.push_back( fields );
+  }
+
+  int message_index = 0;
+
+  std::vector<std::string> names;
+  size_t start = 0;
+  while( start <= _path.size() )
+  {
+    size_t end = _path.find('/', start);
+    if( end == std::string::npos ) end = _path.size();
+    names.push_back( _path.substr(start, end - start) );
+    start = end + 1;
+  }
+
+  for (size_t n=0; n < names.size(); n++)
+  {
+    if( message_index < 0 )
+    {
+      throw std::runtime_error( "FieldLocator: in [" + _path + "], the field before [" +
+                                names[n] + "] is not a message" );
+    }
+
+    std::string name = names[n];
+    Step step;
+    step.array_index = -1;
+
+    // optional index, appended with a dot
+    const size_t dot = name.find('.');
+    if( dot != std::string::npos )
+    {
+      const std::string index = name.substr(dot+1);
+      if( index.empty() || index.find_first_not_of("0123456789") != std::string::npos )
+      {
+        throw std::runtime_error( "FieldLocator: invalid index in [" + _path + "]" );
+      }
+      step.array_index = std::stoi( index );
+      name = name.substr(0, dot);
+    }
+
+    const SchemaLayout::MessageLayout& message = schema_layout.messages()[message_index];
+    const std::vector<FieldLayout>& fields = _messages[message_index];
+
+    // the FieldLayout(s) don't include the constants
+    size_t field_index = 0;
+    while( field_index < message.fields.size() &&
+           !( message.fields[field_index].field->name() == SString(name) ) )
+    {
+      field_index++;
+    }
+    if( field_index == message.fields.size() )
+    {
+      throw std::runtime_error( "FieldLocator: in [" + _path + "], the type " +
+                                message.definition->type().baseName().toStdString() +
+                                " has no field [" + name + "]" );
+    }
+
+    step.field = field_index;
+    step.fixed_offset = 0;
+    if( message.fields[field_index].fixed_offset >= 0 )
+    {
+      step.fixed_offset = message.fields[field_index].fixed_offset;
+    }
+    else{
+      for (size_t i=0; i < field_index; i++)
+      {
+        if( fields[i].fixed_size >= 0 ) {
+          step.fixed_offset += fields[i].fixed_size;
+        }
+        else{
+          step.variable_fields.push_back( std::make_pair(step.fixed_offset, i) );
+          step.fixed_offset = 0;
+        }
+      }
+    }
+
+    const FieldLayout& field = fields[field_index];
+    if( field.type.isArray() && step.array_index < 0 )
+    {
+      throw std::runtime_error( "FieldLocator: in [" + _path + "], the field [" +
+                                name + "] is an array, but it has no index" );
+    }
+    if( !field.type.isArray() && step.array_index >= 0 )
+    {
+      throw std::runtime_error( "FieldLocator: in [" + _path + "], the field [" +
+                                name + "] is not an array" );
+    }
+
+    _steps.push_back( step );
+    _step_message.push_back( message_index );
+    message_index = field.message_index;
+
+    if( n+1 == names.size() )
+    {
+      if( message_index >= 0 )
+      {
+        throw std::runtime_error( "FieldLocator: the path [" + _path +
+                                  "] doesn't refer to a builtin type" );
+      }
+      _type = ROSType( field.type.msgName().toStdString() );
+    }
+  }
+}
+
+void FieldLocator::skipElement(const FieldLayout &field, const uint8_t **ptr, const uint8_t *end) const
+{
+  if( field.element_size >= 0 )
+  {
+    advance( ptr, end, field.element_size );
+  }
+  else if( field.message_index < 0 ) // string
+  {
+    advance( ptr, end, readLength( ptr, end ) );
+  }
+  else{
+    for (const FieldLayout& child: _messages[field.message_index])
+    {
+      skipField( child, ptr, end );
+    }
+  }
+}
+
+void FieldLocator::skipField(const FieldLayout &field, const uint8_t **ptr, const uint8_t *end) const
+{
+  if( field.fixed_size >= 0 )
+  {
+    advance( ptr, end, field.fixed_size );
+    return;
+  }
+
+  uint32_t count = 1;
+  if( field.type.isArray() )
+  {
+    count = field.type.arraySize() >= 0 ? field.type.arraySize() : readLength( ptr, end );
+  }
+
+  if( field.element_size >= 0 )
+  {
+    advance( ptr, end, uint64_t(count) * field.element_size );
+  }
+  else{
+    for (uint32_t i=0; i < count; i++)
+    {
+      skipElement( field, ptr, end );
+    }
+  }
+}
+
+const uint8_t *FieldLocator::locate(const uint8_t *buffer, size_t buffer_size) const
+{
+  const uint8_t* ptr = buffer;
+  const uint8_t* end = buffer + buffer_size;
+
+  for (size_t s=0; s < _steps.size(); s++)
+  {
+    const Step& step = _steps[s];
+    const std::vector<FieldLayout>& fields = _messages[ _step_message[s] ];
+
+    for (const auto& variable_field: step.variable_fields)
+    {
+      advance( &ptr, end, variable_field.first );
+      skipField( fields[ variable_field.second ], &ptr, end );
+    }
+    advance( &ptr, end, step.fixed_offset );
+
+    const FieldLayout& field = fields[ step.field ];
+    if( step.array_index >= 0 )
+    {
+      const uint32_t count = field.type.arraySize() >= 0 ? field.type.arraySize() : readLength( &ptr, end );
+      if( uint32_t(step.array_index) >= count )
+      {
+        return nullptr;
+      }
+      if( field.element_size >= 0 )
+      {
+        advance( &ptr, end, uint64_t(step.array_index) * field.element_size );
+      }
+      else{
+        for (int i=0; i < step.array_index; i++)
+        {
+          skipElement( field, &ptr, end );
+        }
+      }
+    }
+  }
+  return ptr;
+}
+
+bool FieldLocator::extract(const uint8_t *buffer, size_t buffer_size, VarNumber *value) const
+{
+  if( _type.typeID() == STRING )
+  {
+    throw TypeException( "FieldLocator: [" + _path + "] is a string" );
+  }
+  const uint8_t* ptr = locate( buffer, buffer_size );
+  if( !ptr ) return false;
+
+  const uint8_t* end = buffer + buffer_size;
+  const uint8_t* field_ptr = ptr;
+  advance( &ptr, end, _type.typeSize() );
+
+  uint8_t* read_ptr = const_cast<uint8_t*>( field_ptr );
+  *value = _type.deserializeFromBuffer( &read_ptr );
+  return true;
+}
+
+bool FieldLocator::extract(const uint8_t *buffer, size_t buffer_size, boost::string_ref *value) const
+{
+  if( _type.typeID() != STRING )
+  {
+    throw TypeException( "FieldLocator: [" + _path + "] is not a string" );
+  }
+  const uint8_t* ptr = locate( buffer, buffer_size );
+  if( !ptr ) return false;
+
+  const uint8_t* end = buffer + buffer_size;
+  const uint32_t length = readLength( &ptr, end );
+  const uint8_t* string_ptr = ptr;
+  advance( &ptr, end, length );
+
+  *value = boost::string_ref( reinterpret_cast<const char*>(string_ptr), length );
+  return true;
+}
+
+} // end namespace
@@ -0,0 +1,85 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright 2016 Davide Faconti
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of Willow Garage, Inc. nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+********************************************************************/
+
+
+#include "ros_type_introspection/interned_string.hpp"
+
+namespace RosIntrospection{
+
+StringPool &StringPool::global()
+{
+  static StringPool* pool = new StringPool();
+  return *pool;
+}
+
+StringPool::StringPool()
+{
+  _empty = intern( "", 0 )._entry;
+}
+
+InternedString StringPool::intern(const char *str, size_t size)
+{
+  const size_t hash = hashString( str, size );
+  // the upper 4 bits select one of the 16 shards, the lower ones are used by the buckets of the index
+  static_assert( NUM_SHARDS == 16, "update the selection of the shard" );
+  Shard& shard = _shards[ hash >> (sizeof(size_t)*8 - 4) ];
+
+  std::lock_guard<std::mutex> lock( shard.mutex );
+  auto range = shard.index.equal_range( hash );
+  for (auto it = range.first; it != range.second; it++)
+  {
+    const SString& entry = it->second->str;
+    if( entry.size() == size && memcmp( entry.data(), str, size ) == 0 )
+    {
+      return InternedString( it->second );
+    }
+  }
+  shard.entries.push_back( details::InternedEntry{ SString(str, size), hash } );
+  const details::InternedEntry* entry = &shard.entries.back();
+  shard.index.insert( std::make_pair( hash, entry ) );
+  return InternedString( entry );
+}
+
+size_t StringPool::size() const
+{
+  size_t count = 0;
+  for (const Shard& shard: _shards)
+  {
+    std::lock_guard<std::mutex> lock( shard.mutex );
+    count += shard.entries.size();
+  }
+  return count;
+}
+
+} //end namespace
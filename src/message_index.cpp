@@ -0,0 +1,402 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright 2016 Davide Faconti
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of Willow Garage, Inc. nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+********************************************************************/
+
+
+#include <algorithm>
+#include <cstring>
+#include "ros_type_introspection/message_index.hpp"
+#include "ros_type_introspection/schema.hpp"
+#include "ros_type_introspection/schema_layout.hpp"
+
+namespace RosIntrospection{
+
+namespace {
+
+inline void advance(const uint8_t** ptr, const uint8_t* end, uint64_t bytes)
+{
+  if( bytes > static_cast<uint64_t>(end - *ptr) )
+  {
+    throw RangeException("MessageIndex: the buffer is shorter than the serialized message");
+  }
+  *ptr += bytes;
+}
+
+} // end namespace
+
+
+MessageIndex::MessageIndex(const ROSTypeList &type_list, const ROSType &type):
+  _buffer(nullptr),
+  _message_size(0)
+{
+  init( SchemaLayout( type_list, type ) );
+}
+
+MessageIndex::MessageIndex(const MessageSchema &schema):
+  _buffer(nullptr),
+  _message_size(0)
+{
+  init( schema.layout() );
+}
+
+void MessageIndex::init(const SchemaLayout &schema_layout)
+{
+  // same indexes of the SchemaLayout, the main type is the first one
+  _messages.reserve( schema_layout.messages().size() );
+  for (const SchemaLayout::MessageLayout& message: schema_layout.messages())
+  {
+    MessageLayout layout;
+    for (const SchemaLayout::FieldLayout& field: message.fields)
+    {
+      FieldLayout field_layout;
+      field_layout.name = field.field->name();
+      field_layout.type = field.type();
+      field_layout.message_index = field.message_index;
+      field_layout.element_size = field.element_size;
+      field_layout.fixed_offset = field.fixed_offset;
+
+      layout.field_index.emplace( hashString( field_layout.name.data(), field_layout.name.size() ),
+                                  layout.fields.size() );
+      layout.fields.push_back( field_layout );
+    }
+    _messages.push_back( std::move(layout) );
+  }
+}
+
+int MessageIndex::MessageLayout::fieldIndex(const boost::string_ref &name) const
+{
+  auto range = field_index.equal_range( hashString( name.data(), name.size() ) );
+  for (auto it = range.first; it != range.second; ++it)
+  {
+    const SString& field_name = fields[it->second].name;
+    if( field_name.size() == name.size() &&
+        memcmp( field_name.data(), name.data(), name.size() ) == 0 )
+    {
+      return it->second;
+    }
+  }
+  return -1;
+}
+
+uint32_t MessageIndex::readLength(const uint8_t **ptr, const uint8_t *end)
+{
+  const uint8_t* length_ptr = *ptr;
+  advance( ptr, end, sizeof(uint32_t) );
+  uint32_t length;
+  memcpy( &length, length_ptr, sizeof(uint32_t) );
+  _lengths.push_back( std::make_pair( uint32_t(length_ptr - _buffer), length ) );
+  return length;
+}
+
+uint32_t MessageIndex::indexMessage(int message_index, const uint8_t **ptr, const uint8_t *end)
+{
+  const std::vector<FieldLayout>& fields = _messages[message_index].fields;
+  const uint32_t first_entry = _entries.size();
+  _entries.resize( first_entry + fields.size() );
+
+  for (size_t f=0; f < fields.size(); f++)
+  {
+    const FieldLayout& field = fields[f];
+    // _entries may be reallocated by the nested messages: don't keep a reference.
+    Entry entry;
+    entry.offset = *ptr - _buffer;
+    entry.child = NONE;
+    entry.count = 1;
+
+    if( field.type.isArray() )
+    {
+      entry.count = field.type.arraySize() >= 0 ? field.type.arraySize() : readLength( ptr, end );
+    }
+
+    if( field.element_size >= 0 )
+    {
+      advance( ptr, end, uint64_t(entry.count) * field.element_size );
+    }
+    else if( !field.type.isArray() )
+    {
+      if( field.message_index < 0 ) // string
+      {
+        advance( ptr, end, readLength( ptr, end ) );
+      }
+      else{
+        entry.child = indexMessage( field.message_index, ptr, end );
+      }
+    }
+    else{
+      // arrays of strings and messages: the position of each element
+      entry.child = _elements.size();
+      _elements.resize( _elements.size() + entry.count );
+      for (uint32_t i=0; i < entry.count; i++)
+      {
+        if( field.message_index < 0 )
+        {
+          _elements[entry.child + i] = *ptr - _buffer;
+          advance( ptr, end, readLength( ptr, end ) );
+        }
+        else{
+          const uint32_t child = indexMessage( field.message_index, ptr, end );
+          _elements[entry.child + i] = child;
+        }
+      }
+    }
+    _entries[first_entry + f] = entry;
+  }
+  return first_entry;
+}
+
+void MessageIndex::build(const uint8_t *buffer, size_t buffer_size)
+{
+  _entries.clear();
+  _elements.clear();
+  _lengths.clear();
+  _buffer = buffer;
+  _message_size = 0;
+
+  const uint8_t* ptr = buffer;
+  try{
+    indexMessage( 0, &ptr, buffer + buffer_size );
+  }
+  catch(...)
+  {
+    _entries.clear();
+    _elements.clear();
+    _lengths.clear();
+    _buffer = nullptr;
+    throw;
+  }
+  _message_size = ptr - buffer;
+}
+
+bool MessageIndex::rebind(const uint8_t *buffer, size_t buffer_size)
+{
+  if( !_buffer || buffer_size < _message_size )
+  {
+    return false;
+  }
+  for (const auto& length: _lengths)
+  {
+    uint32_t value;
+    memcpy( &value, buffer + length.first, sizeof(uint32_t) );
+    if( value != length.second ) return false;
+  }
+  _buffer = buffer;
+  return true;
+}
+
+MessageIndex::Position MessageIndex::resolve(const std::string &path) const
+{
+  if( !_buffer )
+  {
+    throw std::runtime_error( "MessageIndex: build() was never called" );
+  }
+
+  Position position;
+  position.field = nullptr;
+  position.offset = -1;
+  position.count = -1;
+  position.is_array = false;
+
+  int message_index = 0;
+  // false if an array in the path is too short. In that case the rest of the path is validated anyway.
+  bool present = true;
+  // first Entry of the current message, if it has a variable size.
+  uint32_t first_entry = 0;
+  // start of the current message if it has a fixed size (its fields have no Entry), -1 otherwise.
+  long message_offset = -1;
+  size_t start = 0;
+
+  while( start <= path.size() )
+  {
+    if( message_index < 0 )
+    {
+      throw std::runtime_error( "MessageIndex: in [" + path + "], the field [" +
+                                path.substr(0, start-1) + "] is not a message" );
+    }
+
+    size_t end = path.find('/', start);
+    if( end == std::string::npos ) end = path.size();
+    boost::string_ref name( path.data() + start, end - start );
+    start = end + 1;
+    const bool last = (start > path.size());
+
+    // optional index, appended with a dot
+    int64_t array_index = -1;
+    const size_t dot = name.find('.');
+    if( dot != boost::string_ref::npos )
+    {
+      const boost::string_ref index = name.substr(dot+1);
+      if( index.empty() ||
+          std::find_if( index.begin(), index.end(), [](char c){ return c < '0' || c > '9'; } ) != index.end() )
+      {
+        throw std::runtime_error( "MessageIndex: invalid index in [" + path + "]" );
+      }
+      // larger than any array, without overflowing
+      array_index = 0;
+      for (char c: index)
+      {
+        if( array_index <= 0xFFFFFFFF ) array_index = array_index * 10 + (c - '0');
+      }
+      name = name.substr(0, dot);
+    }
+
+    const MessageLayout& layout = _messages[message_index];
+    const int field_index = layout.fieldIndex( name );
+    if( field_index < 0 )
+    {
+      throw std::runtime_error( "MessageIndex: in [" + path + "], there is no field [" +
+                                name.to_string() + "]" );
+    }
+    const FieldLayout& field = layout.fields[ field_index ];
+    const bool is_array = field.type.isArray();
+
+    if( !is_array && array_index >= 0 )
+    {
+      throw std::runtime_error( "MessageIndex: in [" + path + "], the field [" +
+                                name.to_string() + "] is not an array" );
+    }
+    if( is_array && array_index < 0 && !last )
+    {
+      throw std::runtime_error( "MessageIndex: in [" + path + "], the field [" +
+                                name.to_string() + "] is an array, but it has no index" );
+    }
+
+    position.field = &field;
+    position.offset = -1;
+    position.count = -1;
+    position.is_array = (is_array && array_index < 0);
+    message_index = field.message_index;
+
+    if( !present ) continue;
+
+    const Entry* entry = nullptr;
+    long field_offset;
+    uint32_t count;
+    if( message_offset >= 0 )
+    {
+      // all the fields of a message with fixed size are at a known offset
+      field_offset = message_offset + field.fixed_offset;
+      count = is_array ? field.type.arraySize() : 1;
+    }
+    else{
+      entry = &_entries[ first_entry + field_index ];
+      field_offset = entry->offset;
+      count = entry->count;
+    }
+    // the first element follows the length of variable arrays
+    const long first_element = field_offset + ( (is_array && field.type.arraySize() < 0) ? sizeof(uint32_t) : 0 );
+
+    if( position.is_array )
+    {
+      position.offset = first_element;
+      position.count = count;
+      continue;
+    }
+    if( array_index >= int64_t(count) )
+    {
+      present = false;
+      continue;
+    }
+
+    if( field.element_size >= 0 )
+    {
+      position.offset = is_array ? first_element + array_index * field.element_size : field_offset;
+      message_offset = position.offset;
+    }
+    else if( !is_array )
+    {
+      position.offset = field_offset;
+      message_offset = -1;
+      first_entry = entry->child;
+    }
+    else if( field.message_index < 0 ) // string
+    {
+      position.offset = _elements[ entry->child + array_index ];
+    }
+    else{
+      message_offset = -1;
+      first_entry = _elements[ entry->child + array_index ];
+      // the first field of the element starts where the element does
+      position.offset = _entries[first_entry].offset;
+    }
+  }
+  return position;
+}
+
+bool MessageIndex::getValue(const std::string &path, VarNumber *value) const
+{
+  const Position position = resolve( path );
+  const ROSType& type = position.field->type;
+  if( position.is_array || type.typeID() == OTHER || type.typeID() == STRING )
+  {
+    throw TypeException( "MessageIndex: [" + path + "] is not a number" );
+  }
+  if( position.offset < 0 ) return false;
+
+  uint8_t* read_ptr = const_cast<uint8_t*>( _buffer + position.offset );
+  // the elements of an array are read by the same function
+  *value = type.deserializeFromBuffer( &read_ptr );
+  return true;
+}
+
+bool MessageIndex::getString(const std::string &path, boost::string_ref *value) const
+{
+  const Position position = resolve( path );
+  if( position.is_array || position.field->type.typeID() != STRING )
+  {
+    throw TypeException( "MessageIndex: [" + path + "] is not a string" );
+  }
+  if( position.offset < 0 ) return false;
+
+  uint32_t length;
+  memcpy( &length, _buffer + position.offset, sizeof(uint32_t) );
+  *value = boost::string_ref( reinterpret_cast<const char*>(_buffer + position.offset + sizeof(uint32_t)),
+                              length );
+  return true;
+}
+
+int MessageIndex::getArraySize(const std::string &path) const
+{
+  const Position position = resolve( path );
+  if( !position.is_array )
+  {
+    throw TypeException( "MessageIndex: [" + path + "] is not an array" );
+  }
+  return position.count;
+}
+
+long MessageIndex::getOffset(const std::string &path) const
+{
+  return resolve( path ).offset;
+}
+
+} // end namespace
@@ -0,0 +1,287 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright 2016 Davide Faconti
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of Willow Garage, Inc. nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+********************************************************************/
+
+
+#include <cstring>
+#include "ros_type_introspection/message_view.hpp"
+#include "ros_type_introspection/schema.hpp"
+#include "ros_type_introspection/schema_layout.hpp"
+
+namespace RosIntrospection{
+
+ViewLayout::ViewLayout(const ROSTypeList &type_list, const ROSType &type):
+  ViewLayout( SchemaLayout( type_list, type ) )
+{
+}
+
+ViewLayout::ViewLayout(const SchemaLayout &schema_layout):
+  _field_count(0)
+{
+  // same indexes of the SchemaLayout, the main type is the first one
+  _messages.reserve( schema_layout.messages().size() );
+  for (const SchemaLayout::MessageLayout& message: schema_layout.messages())
+  {
+    MessageLayout layout;
+    layout.fixed_size = message.fixed_size;
+
+    for (const SchemaLayout::FieldLayout& field: message.fields)
+    {
+      FieldLayout field_layout;
+      field_layout.type = field.type();
+      field_layout.message_index = field.message_index;
+      field_layout.element_size = field.element_size;
+      field_layout.fixed_size = field.fixed_size;
+      field_layout.fixed_offset = field.fixed_offset;
+      field_layout.id = _field_count++;
+
+      layout.field_index[ field.field->name().toStdString() ] = layout.fields.size();
+      layout.fields.push_back( field_layout );
+    }
+    _messages.push_back( std::move(layout) );
+  }
+}
+
+//-------------------------------------------------------------------
+
+MessageView::MessageView(const MessageSchema &schema, const uint8_t *buffer, size_t buffer_size):
+  MessageView( schema.viewLayout(), buffer, buffer_size )
+{
+}
+
+MessageView::MessageView(const ViewLayout &layout, const uint8_t *buffer, size_t buffer_size):
+  _layout(layout),
+  _buffer(buffer),
+  _buffer_size(buffer_size)
+{
+}
+
+uint32_t MessageView::readLength(uint32_t offset) const
+{
+  if( uint64_t(offset) + sizeof(uint32_t) > _buffer_size )
+  {
+    throw RangeException("MessageView: the buffer is shorter than the serialized message");
+  }
+  uint32_t length;
+  memcpy( &length, _buffer + offset, sizeof(uint32_t) );
+  return length;
+}
+
+uint32_t MessageView::arraySize(const ViewLayout::FieldLayout &field, uint32_t offset) const
+{
+  const int array_size = field.type.arraySize();
+  return array_size >= 0 ? uint32_t(array_size) : readLength( offset );
+}
+
+uint32_t MessageView::fieldOffset(int message_index, uint32_t message_offset, size_t field) const
+{
+  // field can be equal to the number of fields: in that case, it is the end of the message
+  const ViewLayout::MessageLayout& message = _layout.messages()[message_index];
+  const int fixed_offset = (field < message.fields.size()) ? message.fields[field].fixed_offset
+                                                           : message.fixed_size;
+  if( fixed_offset >= 0 )
+  {
+    return message_offset + fixed_offset;
+  }
+
+  const uint64_t key = (uint64_t(message_offset) << 32) | uint32_t(message_index);
+  // the elements of an unordered_map are not moved when it grows
+  std::vector<uint32_t>& offsets = _field_offsets[key];
+  if( offsets.empty() )
+  {
+    for (const ViewLayout::FieldLayout& field_layout: message.fields)
+    {
+      if( field_layout.fixed_offset < 0 ) break;
+      offsets.push_back( message_offset + field_layout.fixed_offset );
+    }
+  }
+  while( offsets.size() <= field )
+  {
+    const size_t previous = offsets.size() - 1;
+    const uint64_t next = uint64_t(offsets[previous]) + fieldSize( message.fields[previous], offsets[previous] );
+    if( next > _buffer_size )
+    {
+      throw RangeException("MessageView: the buffer is shorter than the serialized message");
+    }
+    offsets.push_back( next );
+  }
+  return offsets[field];
+}
+
+uint32_t MessageView::elementSize(const ViewLayout::FieldLayout &field, uint32_t offset) const
+{
+  if( field.element_size >= 0 )
+  {
+    return field.element_size;
+  }
+  if( field.message_index < 0 ) // string
+  {
+    return sizeof(uint32_t) + readLength( offset );
+  }
+  const size_t field_count = _layout.messages()[field.message_index].fields.size();
+  return fieldOffset( field.message_index, offset, field_count ) - offset;
+}
+
+uint32_t MessageView::fieldSize(const ViewLayout::FieldLayout &field, uint32_t offset) const
+{
+  if( field.fixed_size >= 0 )
+  {
+    return field.fixed_size;
+  }
+  if( !field.type.isArray() )
+  {
+    return elementSize( field, offset );
+  }
+  const uint32_t count = arraySize( field, offset );
+  return elementOffset( field, offset, count ) - offset;
+}
+
+uint32_t MessageView::elementOffset(const ViewLayout::FieldLayout &field, uint32_t offset, uint32_t index) const
+{
+  const uint32_t first = offset + (field.type.arraySize() < 0 ? sizeof(uint32_t) : 0);
+  if( field.element_size >= 0 )
+  {
+    const uint64_t element_offset = first + uint64_t(index) * field.element_size;
+    if( element_offset > _buffer_size )
+    {
+      throw RangeException("MessageView: the buffer is shorter than the serialized message");
+    }
+    return element_offset;
+  }
+
+  const uint64_t key = (uint64_t(offset) << 32) | field.id;
+  std::vector<uint32_t>& offsets = _element_offsets[key];
+  if( offsets.empty() )
+  {
+    offsets.push_back( first );
+  }
+  while( offsets.size() <= index )
+  {
+    const uint32_t previous = offsets.back();
+    const uint64_t next = uint64_t(previous) + elementSize( field, previous );
+    if( next > _buffer_size )
+    {
+      throw RangeException("MessageView: the buffer is shorter than the serialized message");
+    }
+    offsets.push_back( next );
+  }
+  return offsets[index];
+}
+
+//-------------------------------------------------------------------
+
+MessageView::Field MessageView::Field::operator[](const std::string &name) const
+{
+  if( !isMessage() )
+  {
+    throw std::runtime_error( "MessageView: can't get the field [" + name +
+                              "] of a field that is not a message" );
+  }
+  const int message_index = messageIndex();
+  const ViewLayout::MessageLayout& message = _view->_layout.messages()[message_index];
+
+  size_t field_index;
+  auto it = message.field_index.find( name );
+  if( it != message.field_index.end() )
+  {
+    field_index = it->second;
+  }
+  else{
+    throw std::runtime_error( "MessageView: there is no field [" + name + "]" );
+  }
+  const ViewLayout::FieldLayout& field = message.fields[field_index];
+  return Field( _view, &field, !field.type.isArray(),
+                _view->fieldOffset( message_index, _offset, field_index ) );
+}
+
+MessageView::Field MessageView::Field::operator[](size_t index) const
+{
+  if( !isArray() )
+  {
+    throw std::runtime_error( "MessageView: the field is not an array" );
+  }
+  if( index >= size() )
+  {
+    throw RangeException( "MessageView: index " + std::to_string(index) + " out of range" );
+  }
+  return Field( _view, _field, true, _view->elementOffset( *_field, _offset, index ) );
+}
+
+size_t MessageView::Field::size() const
+{
+  if( !isArray() )
+  {
+    throw std::runtime_error( "MessageView: the field is not an array" );
+  }
+  return _view->arraySize( *_field, _offset );
+}
+
+const ROSType &MessageView::Field::type() const
+{
+  if( !_field )
+  {
+    throw std::runtime_error( "MessageView: the type of the whole message is not available" );
+  }
+  return _field->type;
+}
+
+VarNumber MessageView::Field::value() const
+{
+  if( isArray() || !_field || _field->element_size < 0 || _field->message_index >= 0 )
+  {
+    throw TypeException( "MessageView: the field is not a number" );
+  }
+  if( uint64_t(_offset) + _field->element_size > _view->_buffer_size )
+  {
+    throw RangeException("MessageView: the buffer is shorter than the serialized message");
+  }
+  uint8_t* read_ptr = const_cast<uint8_t*>( _view->_buffer + _offset );
+  return _field->type.deserializeFromBuffer( &read_ptr );
+}
+
+boost::string_ref MessageView::Field::str() const
+{
+  if( isArray() || !_field || _field->type.typeID() != STRING )
+  {
+    throw TypeException( "MessageView: the field is not a string" );
+  }
+  const uint32_t length = _view->readLength( _offset );
+  if( uint64_t(_offset) + sizeof(uint32_t) + length > _view->_buffer_size )
+  {
+    throw RangeException("MessageView: the buffer is shorter than the serialized message");
+  }
+  return boost::string_ref( reinterpret_cast<const char*>(_view->_buffer + _offset + sizeof(uint32_t)),
+                            length );
+}
+
+} // end namespace
@@ -39,6 +39,12 @@
 #include <iostream>
 #include <sstream>
 #include <functional>
+#include <atomic>
+#include <cmath>
+#include <cerrno>
+#include <cstdlib>
+#include <limits>
+#include <type_traits>
 #include <boost/regex.hpp>
 #include <boost/algorithm/string/regex.hpp>
 
@@ -95,6 +101,7 @@ ROSType::ROSType(const std::string &name):
   if (boost::regex_search(type_field, what, array_regex))
   {
     _msg_name = std::string(what[1].first, what[1].second);
+    _is_array = true;
 
     if (what.size() == 3) {
       _array_size = -1;
@@ -108,8 +115,10 @@ ROSType::ROSType(const std::string &name):
     }
   } else {
     _msg_name = type_field;
+    _is_array = false;
     _array_size = 1;
   }
+  _msg_hash = hashString( _msg_name.data(), _msg_name.size() );
   //------------------------------
   _id = RosIntrospection::OTHER;
 
@@ -226,7 +235,7 @@ ROSTypeList buildROSTypeMapFromDefinition(
   std::vector<std::string> split;
   boost::split_regex(split, msg_definition, msg_separation_regex);
 
-  std::vector<ROSType> all_types;
+  type_list.reserve( split.size() );
 
   for (size_t i = 0; i < split.size(); ++i) {
 
@@ -236,13 +245,13 @@ ROSTypeList buildROSTypeMapFromDefinition(
       msg.mutateType( ROSType(type_name) );
     }
 
-    type_list.push_back( msg );
-    all_types.push_back( msg.type() );
+    type_list.push_back( std::move(msg) );
   }
+  type_list.buildIndex();
 
   for( ROSMessage& msg: type_list )
   {
-    msg.updateTypes( all_types );
+    msg.updateTypes( type_list );
   }
 
   return type_list;
@@ -289,7 +298,8 @@ void ROSType::setPkgName(const SString &new_pkg)
 
 bool ROSType::isArray() const
 {
-  return _array_size != 1;
+  // a fixed size array with a single element is still an array
+  return _is_array;
 }
 
 bool ROSType::isBuiltin() const
@@ -346,6 +356,42 @@ ROSMessage::ROSMessage(const std::string &msg_def)
       _fields.push_back(new_field);
     }
   }
+
+  _field_index.reserve( _fields.size() );
+  for (size_t i=0; i < _fields.size(); i++)
+  {
+    const SString& name = _fields[i].name();
+    _field_index.insert( std::make_pair( hashString( name.data(), name.size() ), i ) );
+    if( _fields[i].isConstant() ) _constants.push_back( i );
+  }
+}
+
+// Integers are compared exactly, the other numbers as double.
+static bool sameNumber(const VarNumber& a, const VarNumber& b)
+{
+  int64_t signed_a = 0, signed_b = 0;
+  if( a.tryConvert( signed_a ) && b.tryConvert( signed_b ) ) return signed_a == signed_b;
+
+  uint64_t unsigned_a = 0, unsigned_b = 0;
+  if( a.tryConvert( unsigned_a ) && b.tryConvert( unsigned_b ) ) return unsigned_a == unsigned_b;
+
+  double double_a = 0, double_b = 0;
+  if( a.tryConvert( double_a ) && b.tryConvert( double_b ) ) return double_a == double_b;
+  return false;
+}
+
+const ROSField *ROSMessage::findConstant(const VarNumber &value) const
+{
+  for (size_t index: _constants)
+  {
+    const ROSField& constant = _fields[index];
+    if( constant.numericValue().getTypeID() != OTHER &&
+        sameNumber( constant.numericValue(), value ) )
+    {
+      return &constant;
+    }
+  }
+  return nullptr;
 }
 
 void ROSMessage::updateTypes(const std::vector<ROSType> &all_types)
@@ -367,7 +413,206 @@ void ROSMessage::updateTypes(const std::vector<ROSType> &all_types)
   }
 }
 
-ROSField::ROSField(const std::string &definition)
+void ROSMessage::updateTypes(const ROSTypeList &type_list)
+{
+  for (ROSField& field: _fields)
+  {
+    // if package name is missing, try to find msgName in the list of known_type
+    if( field.type().pkgName().size() == 0 && !field.type().isBuiltin() )
+    {
+      const ROSMessage* known = type_list.findByMsgName( field.type() );
+      if( known )
+      {
+        field._type.setPkgName( known->type().pkgName() );
+      }
+    }
+    if( field.type().typeID() == OTHER )
+    {
+      field._message_index = static_cast<int>( &type_list.definition( field.type() ) - type_list.data() );
+    }
+  }
+}
+
+void ROSMessage::linkFields(const ROSTypeList &type_list)
+{
+  for (ROSField& field: _fields)
+  {
+    if( field.type().typeID() != OTHER ) continue;
+    const ROSMessage* definition = type_list.find( field.type() );
+    field._message_index = definition ? static_cast<int>( definition - type_list.data() ) : -1;
+  }
+}
+
+void ROSTypeList::buildIndex()
+{
+  _index.clear();
+  _index.reserve( size() );
+  for (size_t i=0; i < size(); i++)
+  {
+    _index.insert( std::make_pair( (*this)[i].type().msgNameHash(), i ) );
+  }
+  _indexed_size = size();
+
+  for (ROSMessage& msg: *this)
+  {
+    msg.linkFields( *this );
+  }
+
+  static std::atomic<uint64_t> last_id(0);
+  _id = ++last_id;
+}
+
+template <typename Predicate>
+const ROSMessage* ROSTypeList::findImpl(const ROSType &type, Predicate predicate) const
+{
+  if( _indexed_size == size() )
+  {
+    // the order of the elements with the same key is unspecified: keep the first one in the list
+    size_t found = size();
+    auto range = _index.equal_range( type.msgNameHash() );
+    for (auto it = range.first; it != range.second; ++it)
+    {
+      if( it->second < found && predicate( (*this)[it->second].type() ) )
+      {
+        found = it->second;
+      }
+    }
+    return (found < size()) ? &(*this)[found] : nullptr;
+  }
+  // elements were added or removed after buildIndex
+  for (const ROSMessage& msg: *this)
+  {
+    if( predicate( msg.type() ) ) return &msg;
+  }
+  return nullptr;
+}
+
+const ROSMessage *ROSTypeList::find(const ROSType &type) const
+{
+  return findImpl( type, [&type](const ROSType& msg_type)
+  {
+    return msg_type.msgName() == type.msgName() && msg_type.pkgName() == type.pkgName();
+  });
+}
+
+const ROSMessage &ROSTypeList::definition(const ROSType &type) const
+{
+  const ROSMessage* msg = find( type );
+  if( !msg )
+  {
+    std::string output( "can't deserialize this stuff: ");
+    output +=  type.baseName().toStdString() + "\n\n";
+    output +=  "Available types are: \n\n";
+    for(const ROSMessage& available: *this)
+    {
+      output += "   " + available.type().baseName().toStdString() + "\n";
+    }
+    throw std::runtime_error( output );
+  }
+  return *msg;
+}
+
+const ROSMessage *ROSTypeList::findByMsgName(const ROSType &type) const
+{
+  return findImpl( type, [&type](const ROSType& msg_type)
+  {
+    return msg_type.msgName() == type.msgName();
+  });
+}
+
+// signed integers
+template <typename T>
+static bool parseInteger(const std::string& text, VarNumber* output, std::true_type)
+{
+  const char* begin = text.c_str();
+  char* end = nullptr;
+  errno = 0;
+  const long long value = std::strtoll( begin, &end, 10 );
+  if( text.empty() || errno != 0 || end != begin + text.size() ||
+      value < std::numeric_limits<T>::min() || value > std::numeric_limits<T>::max() )
+  {
+    return false;
+  }
+  *output = VarNumber( static_cast<T>(value) );
+  return true;
+}
+
+// unsigned integers
+template <typename T>
+static bool parseInteger(const std::string& text, VarNumber* output, std::false_type)
+{
+  // strtoull accepts negative numbers
+  if( text.empty() || text[0] == '-' ) return false;
+  const char* begin = text.c_str();
+  char* end = nullptr;
+  errno = 0;
+  const unsigned long long value = std::strtoull( begin, &end, 10 );
+  if( errno != 0 || end != begin + text.size() || value > std::numeric_limits<T>::max() )
+  {
+    return false;
+  }
+  *output = VarNumber( static_cast<T>(value) );
+  return true;
+}
+
+template <typename T>
+static bool parseInteger(const std::string& text, VarNumber* output)
+{
+  return parseInteger<T>( text, output, std::is_signed<T>() );
+}
+
+template <typename T>
+static bool parseFloat(const std::string& text, VarNumber* output)
+{
+  if( text.empty() ) return false;
+  const char* begin = text.c_str();
+  char* end = nullptr;
+  errno = 0;
+  const double value = std::strtod( begin, &end );
+  if( errno == ERANGE || end != begin + text.size() ) return false;
+  // casting a finite double outside the range of T is undefined behaviour
+  if( std::isfinite( value ) && std::fabs( value ) > std::numeric_limits<T>::max() ) return false;
+  *output = VarNumber( static_cast<T>(value) );
+  return true;
+}
+
+// Same rules of genmsg: integers must be in the range of the type, bool accepts also True/False.
+static bool parseConstant(BuiltinType type, const std::string& text, VarNumber* output)
+{
+  switch( type )
+  {
+  case BOOL:{
+    if( text == "True" || text == "true" )  { *output = VarNumber( true );  return true; }
+    if( text == "False" || text == "false" ){ *output = VarNumber( false ); return true; }
+    VarNumber number;
+    if( !parseInteger<int64_t>( text, &number ) ) return false;
+    *output = VarNumber( number.extract<int64_t>() != 0 );
+    return true;
+  }
+  // same representation used by the deserializer: byte is int8, char is a C++ char in the range of uint8
+  case BYTE:    return parseInteger<int8_t>( text, output );
+  case CHAR:{
+    VarNumber number;
+    if( !parseInteger<uint8_t>( text, &number ) ) return false;
+    *output = VarNumber( static_cast<char>( number.extract<uint8_t>() ) );
+    return true;
+  }
+  case UINT8:   return parseInteger<uint8_t>( text, output );
+  case UINT16:  return parseInteger<uint16_t>( text, output );
+  case UINT32:  return parseInteger<uint32_t>( text, output );
+  case UINT64:  return parseInteger<uint64_t>( text, output );
+  case INT8:    return parseInteger<int8_t>( text, output );
+  case INT16:   return parseInteger<int16_t>( text, output );
+  case INT32:   return parseInteger<int32_t>( text, output );
+  case INT64:   return parseInteger<int64_t>( text, output );
+  case FLOAT32: return parseFloat<float>( text, output );
+  case FLOAT64: return parseFloat<double>( text, output );
+  default: return false;
+  }
+}
+
+ROSField::ROSField(const std::string &definition):
+  _message_index(-1)
 {
   static const  boost::regex type_regex("[a-zA-Z][a-zA-Z0-9_]*"
                                         "(/[a-zA-Z][a-zA-Z0-9_]*){0,1}"
@@ -419,10 +664,13 @@ ROSField::ROSField(const std::string &definition)
         else {
           value.assign(begin, end);
         }
-        // TODO: Raise error if string is not numeric
       }
 
       boost::algorithm::trim(value);
+      if( value.empty() && type != "string" )
+      {
+        throw std::runtime_error("Bad constant value when parsing message ----\n" + definition);
+      }
     } else if (what[0] == "#") {
       // Ignore comment
     } else {
@@ -434,6 +682,14 @@ ROSField::ROSField(const std::string &definition)
   _type  = ROSType( type );
   _name  = fieldname;
   _value = value;
+
+  if( isConstant() && _type.typeID() != STRING )
+  {
+    if( _type.isArray() || !parseConstant( _type.typeID(), value, &_numeric_value ) )
+    {
+      throw std::runtime_error("Bad constant value when parsing message ----\n" + definition);
+    }
+  }
 }
 
 
@@ -0,0 +1,229 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright 2016 Davide Faconti
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of Willow Garage, Inc. nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+********************************************************************/
+
+
+#include <cctype>
+#include <cstdlib>
+#include <cerrno>
+#include "ros_type_introspection/predicate.hpp"
+#include "ros_type_introspection/schema.hpp"
+
+namespace RosIntrospection{
+
+MessagePredicate::MessagePredicate(const ROSTypeList &type_list,
+                                   const ROSType &type,
+                                   const std::string &expression):
+  _expression(expression)
+{
+  parse( type_list, type );
+}
+
+MessagePredicate::MessagePredicate(const MessageSchema &schema, const std::string &expression):
+  _expression(expression)
+{
+  parse( schema.typeList(), schema.rootType() );
+}
+
+void MessagePredicate::parse(const ROSTypeList &type_list, const ROSType &type)
+{
+  const std::string& expr = _expression;
+  size_t pos = 0;
+
+  auto error = [&expr](const std::string& message)
+  {
+    throw std::runtime_error( "MessagePredicate: " + message + " in [" + expr + "]" );
+  };
+
+  auto skip_spaces = [&]()
+  {
+    while( pos < expr.size() && std::isspace( static_cast<unsigned char>(expr[pos]) ) ) pos++;
+  };
+
+  auto starts_with = [&](const char* token) -> bool
+  {
+    const size_t length = strlen(token);
+    if( expr.compare(pos, length, token) == 0 ) {
+      pos += length;
+      return true;
+    }
+    return false;
+  };
+
+  std::vector<Comparison> conjunction;
+
+  while( true )
+  {
+    // field
+    skip_spaces();
+    const size_t path_start = pos;
+    while( pos < expr.size() &&
+           ( std::isalnum( static_cast<unsigned char>(expr[pos]) ) ||
+             expr[pos] == '_' || expr[pos] == '/' || expr[pos] == '.') )
+    {
+      pos++;
+    }
+    if( pos == path_start ) error( "expected the name of a field at position " + std::to_string(pos) );
+    const std::string path = expr.substr( path_start, pos - path_start );
+
+    // operator
+    skip_spaces();
+    Operator op;
+    if( starts_with("==") )      op = EQUAL;
+    else if( starts_with("!=") ) op = NOT_EQUAL;
+    else if( starts_with("<=") ) op = LESS_EQUAL;
+    else if( starts_with(">=") ) op = GREATER_EQUAL;
+    else if( starts_with("<") )  op = LESS;
+    else if( starts_with(">") )  op = GREATER;
+    else error( "expected a comparison operator at position " + std::to_string(pos) );
+
+    Comparison comparison = { FieldLocator( type_list, type, path ), op, 0.0, false, 0, std::string() };
+    const bool is_string = ( comparison.field.type().typeID() == STRING );
+
+    // literal
+    skip_spaces();
+    if( pos < expr.size() && expr[pos] == '"' )
+    {
+      if( !is_string ) error( "the field [" + path + "] is not a string" );
+      pos++;
+      bool closed = false;
+      while( pos < expr.size() )
+      {
+        char c = expr[pos++];
+        if( c == '"' ) {
+          closed = true;
+          break;
+        }
+        if( c == '\\' && pos < expr.size() ) c = expr[pos++];
+        comparison.text.push_back( c );
+      }
+      if( !closed ) error( "unterminated string" );
+    }
+    else{
+      if( is_string ) error( "the field [" + path + "] is a string" );
+      const char* number_start = expr.c_str() + pos;
+      char* number_end = nullptr;
+      comparison.number = strtod( number_start, &number_end );
+      if( number_end == number_start ) error( "expected a number at position " + std::to_string(pos) );
+
+      // the same literal, read as an integer
+      char* integer_end = nullptr;
+      errno = 0;
+      const long long integer = strtoll( number_start, &integer_end, 10 );
+      comparison.is_integer = ( integer_end == number_end && errno == 0 );
+      comparison.integer = integer;
+
+      pos += number_end - number_start;
+    }
+    conjunction.push_back( comparison );
+
+    skip_spaces();
+    if( pos == expr.size() ) {
+      _terms.push_back( conjunction );
+      break;
+    }
+    if( starts_with("||") ) {
+      _terms.push_back( conjunction );
+      conjunction.clear();
+    }
+    else if( !starts_with("&&") ) {
+      error( "expected && or || at position " + std::to_string(pos) );
+    }
+  }
+}
+
+template <typename T> inline
+bool MessagePredicate::compare(const T& a, const T& b, Operator op)
+{
+  switch( op )
+  {
+  case EQUAL:         return a == b;
+  case NOT_EQUAL:     return a != b;
+  case LESS:          return a < b;
+  case LESS_EQUAL:    return a <= b;
+  case GREATER:       return a > b;
+  case GREATER_EQUAL: return a >= b;
+  }
+  return false;
+}
+
+inline bool isInteger(BuiltinType type)
+{
+  return type == BYTE || type == CHAR ||
+         (type >= UINT8 && type <= UINT64) ||
+         (type >= INT8 && type <= INT64);
+}
+
+bool MessagePredicate::evaluate(const Comparison &comparison, const uint8_t *buffer, size_t buffer_size) const
+{
+  if( comparison.field.type().typeID() == STRING )
+  {
+    boost::string_ref value;
+    if( !comparison.field.extract( buffer, buffer_size, &value ) ) return false;
+    return compare( value.compare( comparison.text ), 0, comparison.op );
+  }
+  VarNumber value;
+  if( !comparison.field.extract( buffer, buffer_size, &value ) ) return false;
+
+  // 64 bits integers (stamps in nanoseconds, counters) don't fit in a double
+  if( comparison.is_integer && isInteger( value.getTypeID() ) )
+  {
+    int64_t integer = 0;
+    if( value.tryConvert( integer ) )
+    {
+      return compare( integer, comparison.integer, comparison.op );
+    }
+    // uint64_t larger than any int64_t
+    return compare( 1, 0, comparison.op );
+  }
+  return compare( value.convertLossy<double>(), comparison.number, comparison.op );
+}
+
+bool MessagePredicate::operator()(const uint8_t *buffer, size_t buffer_size) const
+{
+  for (const std::vector<Comparison>& conjunction: _terms)
+  {
+    bool result = true;
+    for (const Comparison& comparison: conjunction)
+    {
+      if( !evaluate( comparison, buffer, buffer_size ) ) {
+        result = false;
+        break;
+      }
+    }
+    if( result ) return true;
+  }
+  return false;
+}
+
+} // end namespace
@@ -33,15 +33,16 @@
 ********************************************************************/
 
 
+#include <chrono>
 #include <boost/algorithm/string.hpp>
 #include <boost/utility/string_ref.hpp>
 #include "ros_type_introspection/renamer.hpp"
 
 namespace RosIntrospection{
 
-inline bool isNumberPlaceholder( const SString& s)
+inline bool isNumberPlaceholder( const InternedString& s)
 {
-  return s.size() == 1 && s.at(0) == '#';
+  return s == arrayNodeName();
 }
 
 inline bool isSubstitutionPlaceholder( const SString& s)
@@ -49,7 +50,7 @@ inline bool isSubstitutionPlaceholder( const SString& s)
   return s.size() == 1 && s.at(0) == '@';
 }
 
-inline bool FindPattern( const std::vector<SString>& pattern,  size_t index,
+inline bool FindPattern( const std::vector<InternedString>& pattern,  size_t index,
                          const StringTreeNode* tail,
                          const  StringTreeNode** head )
 {
@@ -109,9 +110,9 @@ int  PatternMatchAndIndexPosition(const StringTreeLeaf& leaf,
 }
 
 
-void applyNameTransform(const std::vector<SubstitutionRule> &rules,
-                        const ROSTypeFlat& container,
-                        RenamedValues& renamed_value )
+static void applyNameTransformImpl(const std::vector<SubstitutionRule> &rules,
+                                   const ROSTypeFlat& container,
+                                   RenamedValues& renamed_value )
 {
 
   const bool debug = false ;
@@ -192,9 +193,9 @@ void applyNameTransform(const std::vector<SubstitutionRule> &rules,
 
           while( node_ptr != pattern_head)
           {
-            const SString* value = &node_ptr->value();
+            const SString* value = &node_ptr->value().str();
 
-            if( isNumberPlaceholder( *value) ){
+            if( isNumberPlaceholder( node_ptr->value() ) ){
               char buffer[16];
               print_number( buffer, leaf.index_array[position--] );
               formatted_string.push_back( std::move(SString(buffer)) );
@@ -228,9 +229,9 @@ void applyNameTransform(const std::vector<SubstitutionRule> &rules,
 
           while( node_ptr )
           {
-            const SString* value = &node_ptr->value();
+            const SString* value = &node_ptr->value().str();
 
-            if( isNumberPlaceholder( *value) ){
+            if( isNumberPlaceholder( node_ptr->value() ) ){
               char buffer[16];
               print_number( buffer, leaf.index_array[position--] );
               formatted_string.push_back( std::move(SString(buffer)) );
@@ -314,4 +315,20 @@ SubstitutionRule::SubstitutionRule(const char *pattern, const char *alias, const
 
 
 
+void applyNameTransform(const std::vector<SubstitutionRule> &rules,
+                        const ROSTypeFlat& container,
+                        RenamedValues& renamed_value )
+{
+  TypeCounters* counters = container.statistics;
+  if( !counters || !DecodeStatistics::global().isEnabled() )
+  {
+    applyNameTransformImpl( rules, container, renamed_value );
+    return;
+  }
+  typedef std::chrono::steady_clock Clock;
+  const Clock::time_point start_time = Clock::now();
+  applyNameTransformImpl( rules, container, renamed_value );
+  counters->rename_ns += std::chrono::duration_cast<std::chrono::nanoseconds>( Clock::now() - start_time ).count();
+}
+
 } //end namespace
@@ -0,0 +1,127 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright 2016 Davide Faconti
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of Willow Garage, Inc. nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+********************************************************************/
+
+#include "ros_type_introspection/schema.hpp"
+#include "ros_type_introspection/message_view.hpp"
+#include "ros_type_introspection/schema_layout.hpp"
+
+namespace RosIntrospection{
+
+MessageSchema::MessageSchema(const std::string &md5sum,
+                             const std::string &datatype,
+                             const std::string &definition):
+  _md5sum(md5sum),
+  _datatype(datatype),
+  _definition(definition),
+  _root_type(datatype),
+  _type_list( buildROSTypeMapFromDefinition(datatype, definition) )
+{
+}
+
+MessageSchema::~MessageSchema()
+{
+}
+
+const ViewLayout &MessageSchema::viewLayout() const
+{
+  std::call_once( _view_layout_flag, [this]()
+  {
+    _view_layout.reset( new ViewLayout( layout() ) );
+  });
+  return *_view_layout;
+}
+
+const SchemaLayout &MessageSchema::layout() const
+{
+  std::call_once( _layout_flag, [this]()
+  {
+    _layout.reset( new SchemaLayout( _type_list, _root_type ) );
+  });
+  return *_layout;
+}
+
+SchemaCache &SchemaCache::global()
+{
+  static SchemaCache cache;
+  return cache;
+}
+
+MessageSchema::ConstPtr SchemaCache::get(const std::string &md5sum,
+                                         const std::string &datatype,
+                                         const std::string &definition)
+{
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto it = _schemas.find( md5sum );
+    if( it != _schemas.end() )
+    {
+      for(const MessageSchema::ConstPtr& schema: it->second)
+      {
+        if( schema->datatype() == datatype ) return schema;
+      }
+    }
+  }
+
+  // parse without holding the lock. If two threads do this at the same time,
+  // the first one to store the result wins.
+  MessageSchema::ConstPtr new_schema( new MessageSchema(md5sum, datatype, definition) );
+
+  std::lock_guard<std::mutex> lock(_mutex);
+  std::vector<MessageSchema::ConstPtr>& schemas = _schemas[md5sum];
+  for(const MessageSchema::ConstPtr& schema: schemas)
+  {
+    if( schema->datatype() == datatype ) return schema;
+  }
+  schemas.push_back( new_schema );
+  return new_schema;
+}
+
+size_t SchemaCache::size() const
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  size_t count = 0;
+  for(const auto& it: _schemas)
+  {
+    count += it.second.size();
+  }
+  return count;
+}
+
+void SchemaCache::clear()
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  _schemas.clear();
+}
+
+} // end namespace
@@ -0,0 +1,180 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright 2016 Davide Faconti
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of Willow Garage, Inc. nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+********************************************************************/
+
+
+#include <algorithm>
+#include <limits>
+#include "ros_type_introspection/schema_layout.hpp"
+
+namespace RosIntrospection{
+
+namespace {
+
+// A size that doesn't fit in an int is handled as variable.
+inline int fixedSize(int64_t size)
+{
+  return size > std::numeric_limits<int>::max() ? -1 : static_cast<int>(size);
+}
+
+// A minimum size is saturated: it is still a lower bound.
+inline uint32_t minSize(uint64_t size)
+{
+  return static_cast<uint32_t>( std::min<uint64_t>( size, std::numeric_limits<uint32_t>::max() ) );
+}
+
+} // end anonymous namespace
+
+SchemaLayout::SchemaLayout(const ROSTypeList &type_list, const ROSType &type)
+{
+  std::vector<const ROSMessage*> visiting;
+  addMessage( type_list, type, &visiting );
+}
+
+int SchemaLayout::messageIndex(const ROSType &type) const
+{
+  for (size_t i=0; i < _messages.size(); i++)
+  {
+    const ROSType& msg_type = _messages[i].definition->type();
+    if( msg_type.msgName() == type.msgName() &&
+        msg_type.pkgName() == type.pkgName() )
+    {
+      return i;
+    }
+  }
+  return -1;
+}
+
+int SchemaLayout::addMessage(const ROSTypeList &type_list,
+                             const ROSType &type,
+                             std::vector<const ROSMessage*>* visiting)
+{
+  const ROSMessage* msg_definition = type_list.find( type );
+  if( !msg_definition )
+  {
+    throw std::runtime_error( "SchemaLayout: can't find the definition of " +
+                              type.baseName().toStdString() );
+  }
+
+  for (size_t i=0; i< _messages.size(); i++)
+  {
+    if( _messages[i].definition == msg_definition )
+    {
+      if( std::find( visiting->begin(), visiting->end(), msg_definition ) != visiting->end() )
+      {
+        throw std::runtime_error( "SchemaLayout: the type " + type.baseName().toStdString() +
+                                  " contains itself" );
+      }
+      return i;
+    }
+  }
+
+  // reserve the position before the nested types, so that the main type is the first one
+  const int index = _messages.size();
+  _messages.emplace_back();
+  _messages[index].definition = msg_definition;
+  visiting->push_back( msg_definition );
+
+  MessageLayout layout;
+  layout.definition = msg_definition;
+  layout.fixed_size = 0;
+  layout.min_size = 0;
+  layout.flags = 0;
+
+  for (const ROSField& field: msg_definition->fields())
+  {
+    if( field.isConstant() ) continue;
+
+    FieldLayout field_layout;
+    field_layout.field = &field;
+    field_layout.message_index = -1;
+    field_layout.flags = 0;
+
+    if( field.type().typeID() == OTHER )
+    {
+      field_layout.message_index = addMessage( type_list, field.type(), visiting );
+      const MessageLayout& child = _messages[field_layout.message_index];
+      field_layout.element_size = child.fixed_size;
+      field_layout.min_element_size = child.min_size;
+      field_layout.flags = child.flags;
+    }
+    else if( field.type().typeID() == STRING )
+    {
+      field_layout.element_size = -1;
+      field_layout.min_element_size = sizeof(uint32_t);
+      field_layout.flags = HAS_STRINGS;
+    }
+    else{
+      field_layout.element_size = field.type().typeSize();
+      field_layout.min_element_size = field_layout.element_size;
+    }
+
+    if( !field.type().isArray() )
+    {
+      field_layout.fixed_size = field_layout.element_size;
+      field_layout.min_size = field_layout.min_element_size;
+    }
+    else if( field.type().arraySize() < 0 )
+    {
+      field_layout.fixed_size = -1;
+      // the length of an empty array
+      field_layout.min_size = sizeof(uint32_t);
+      field_layout.flags |= HAS_VARIABLE_ARRAYS;
+    }
+    else {
+      const int array_size = field.type().arraySize();
+      field_layout.fixed_size = (field_layout.element_size < 0) ? -1 :
+                                  fixedSize( int64_t(field_layout.element_size) * array_size );
+      field_layout.min_size = minSize( uint64_t(field_layout.min_element_size) * array_size );
+    }
+
+    field_layout.fixed_offset = layout.fixed_size;
+    field_layout.min_offset = layout.min_size;
+
+    if( layout.fixed_size >= 0 )
+    {
+      layout.fixed_size = (field_layout.fixed_size >= 0) ?
+                            fixedSize( int64_t(layout.fixed_size) + field_layout.fixed_size ) : -1;
+    }
+    layout.min_size = minSize( uint64_t(layout.min_size) + field_layout.min_size );
+    layout.flags |= field_layout.flags;
+    layout.fields.push_back( field_layout );
+  }
+
+  _messages[index] = std::move(layout);
+  _post_order.push_back( index );
+  visiting->pop_back();
+  return index;
+}
+
+} // end namespace
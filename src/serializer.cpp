@@ -0,0 +1,486 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright 2016 Davide Faconti
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of Willow Garage, Inc. nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+********************************************************************/
+
+
+#include <cmath>
+#include <cstring>
+#include <type_traits>
+#include "ros_type_introspection/serializer.hpp"
+#include "ros_type_introspection/schema.hpp"
+#include "ros_type_introspection/schema_layout.hpp"
+
+namespace RosIntrospection{
+
+struct MessageSerializer::Writer
+{
+  uint8_t* ptr;
+  uint8_t* end;
+
+  void write(const void* data, size_t size)
+  {
+    if( size > static_cast<size_t>(end - ptr) )
+    {
+      throw RangeException("MessageSerializer: the buffer is too small");
+    }
+    memcpy( ptr, data, size );
+    ptr += size;
+  }
+
+  template <typename T> void write(const T& value)
+  {
+    write( &value, sizeof(T) );
+  }
+};
+
+namespace {
+
+inline bool isArrayNode(const StringTreeNode* node)
+{
+  return node->value() == arrayNodeName();
+}
+
+inline std::string leafName(const StringTreeLeaf& leaf)
+{
+  std::string name;
+  leaf.toStr( name );
+  return name;
+}
+
+// Integers must be represented exactly, floating point fields can lose precision.
+template <typename T> inline T fieldValue(const VarNumber& value, const StringTreeLeaf& leaf)
+{
+  T output = T();
+  if( value.tryConvert( output ) )
+  {
+    return output;
+  }
+  if( std::is_floating_point<T>::value && value.getTypeID() != OTHER )
+  {
+    return value.convertLossy<T>();
+  }
+  throw RangeException( "MessageSerializer: the value of [" + leafName( leaf ) + "] doesn't fit in its type" );
+}
+
+} // end namespace
+
+MessageSerializer::MessageSerializer(const ROSTypeList &type_list, const ROSType &type, SString prefix):
+  _elements_without_leaves(false)
+{
+  _tree.root()->value() = prefix;
+  const SchemaLayout schema_layout( type_list, type );
+  compile( schema_layout, 0, _tree.root(), &_fields, 0 );
+}
+
+MessageSerializer::MessageSerializer(const MessageSchema &schema, SString prefix):
+  _elements_without_leaves(false)
+{
+  _tree.root()->value() = prefix;
+  compile( schema.layout(), 0, _tree.root(), &_fields, 0 );
+}
+
+void MessageSerializer::compile(const SchemaLayout &schema_layout, int message_index,
+                                StringTreeNode *node, std::vector<Field> *fields, int array_depth)
+{
+  const SchemaLayout::MessageLayout& message = schema_layout.messages()[message_index];
+
+  // the children are never reallocated, therefore the pointers to the nodes are stable
+  node->children().reserve( message.fields.size() );
+
+  for (const SchemaLayout::FieldLayout& field_layout: message.fields)
+  {
+    node->addChild( field_layout.field->internedName() );
+    StringTreeNode* field_node = &node->children().back();
+
+    Field field;
+    field.type = field_layout.type();
+    field.node = field_node;
+    field.element_node = field_node;
+    field.element_size = field_layout.element_size;
+    field.fixed_size = field_layout.fixed_size;
+    field.element_has_leaves = true;
+
+    int depth = array_depth;
+    if( field.type.isArray() )
+    {
+      if( ++depth > 7 )
+      {
+        throw std::runtime_error( "MessageSerializer: more than 7 nested arrays in " +
+                                  message.definition->type().baseName().toStdString() );
+      }
+      field_node->children().reserve(1);
+      field_node->addChild( arrayNodeName() );
+      field.element_node = &field_node->children().back();
+    }
+
+    if( field_layout.message_index >= 0 )
+    {
+      compile( schema_layout, field_layout.message_index, const_cast<StringTreeNode*>(field.element_node),
+               &field.children, depth );
+      field.element_has_leaves = false;
+      for (const Field& child: field.children)
+      {
+        // variable length arrays may be empty
+        if( child.element_has_leaves && child.type.arraySize() > 0 )
+        {
+          field.element_has_leaves = true;
+        }
+      }
+      if( field.type.arraySize() < 0 && !field.element_has_leaves )
+      {
+        _elements_without_leaves = true;
+      }
+    }
+    fields->push_back( std::move(field) );
+  }
+}
+
+size_t MessageSerializer::elementSize(const Field &field, const StringTreeLeaf &leaf,
+                                      SerializationSource *source) const
+{
+  if( field.element_size >= 0 )
+  {
+    return field.element_size;
+  }
+  if( field.type.typeID() == STRING )
+  {
+    return sizeof(uint32_t) + source->string( leaf ).size();
+  }
+  return fieldsSize( field.children, leaf, source );
+}
+
+size_t MessageSerializer::fieldsSize(const std::vector<Field> &fields, StringTreeLeaf leaf,
+                                     SerializationSource *source) const
+{
+  size_t size = 0;
+  for (const Field& field: fields)
+  {
+    if( field.fixed_size >= 0 )
+    {
+      size += field.fixed_size;
+      continue;
+    }
+    leaf.node_ptr = const_cast<StringTreeNode*>( field.node );
+
+    if( !field.type.isArray() )
+    {
+      size += elementSize( field, leaf, source );
+      continue;
+    }
+
+    uint32_t count = field.type.arraySize();
+    if( field.type.arraySize() < 0 )
+    {
+      count = source->arraySize( leaf );
+      size += sizeof(uint32_t);
+    }
+
+    if( field.element_size >= 0 )
+    {
+      size += size_t(count) * field.element_size;
+      continue;
+    }
+    StringTreeLeaf element_leaf = leaf;
+    element_leaf.node_ptr = const_cast<StringTreeNode*>( field.element_node );
+    element_leaf.array_size++;
+    for (uint32_t i=0; i < count; i++)
+    {
+      element_leaf.index_array[ element_leaf.array_size-1 ] = static_cast<uint16_t>(i);
+      size += elementSize( field, element_leaf, source );
+    }
+  }
+  return size;
+}
+
+size_t MessageSerializer::serializedSize(SerializationSource *source) const
+{
+  source->begin();
+  StringTreeLeaf leaf;
+  leaf.node_ptr = const_cast<StringTreeNode*>( _tree.croot() );
+  return fieldsSize( _fields, leaf, source );
+}
+
+void MessageSerializer::writeElement(const Field &field, const StringTreeLeaf &leaf,
+                                     SerializationSource *source, Writer *writer) const
+{
+  const BuiltinType id = field.type.typeID();
+
+  if( id == OTHER )
+  {
+    writeFields( field.children, leaf, source, writer );
+    return;
+  }
+  if( id == STRING )
+  {
+    boost::string_ref str = source->string( leaf );
+    writer->write( static_cast<uint32_t>( str.size() ) );
+    writer->write( str.data(), str.size() );
+    return;
+  }
+
+  const VarNumber value = source->number( leaf, field.type );
+
+  switch( id )
+  {
+  case BOOL:
+  case CHAR:
+  case UINT8:   writer->write( fieldValue<uint8_t>( value, leaf ) );  break;
+  case BYTE:
+  case INT8:    writer->write( fieldValue<int8_t>( value, leaf ) );   break;
+  case UINT16:  writer->write( fieldValue<uint16_t>( value, leaf ) ); break;
+  case UINT32:  writer->write( fieldValue<uint32_t>( value, leaf ) ); break;
+  case UINT64:  writer->write( fieldValue<uint64_t>( value, leaf ) ); break;
+  case INT16:   writer->write( fieldValue<int16_t>( value, leaf ) );  break;
+  case INT32:   writer->write( fieldValue<int32_t>( value, leaf ) );  break;
+  case INT64:   writer->write( fieldValue<int64_t>( value, leaf ) );  break;
+  case FLOAT32: writer->write( fieldValue<float>( value, leaf ) );    break;
+  case FLOAT64: writer->write( fieldValue<double>( value, leaf ) );   break;
+
+  case TIME:
+  case DURATION:
+  {
+    // note that the deserializer stores also DURATION as ros::Time
+    if( value.getTypeID() == TIME )
+    {
+      writer->write( value.extract<ros::Time>() );
+    }
+    else if( value.getTypeID() == DURATION )
+    {
+      writer->write( value.extract<ros::Duration>() );
+    }
+    else {
+      const double seconds = fieldValue<double>( value, leaf );
+      int32_t sec = static_cast<int32_t>( std::floor(seconds) );
+      int32_t nsec = static_cast<int32_t>( std::round( (seconds - sec) * 1e9 ) );
+      if( nsec >= 1000000000 ) {
+        sec++;
+        nsec -= 1000000000;
+      }
+      writer->write( sec );
+      writer->write( nsec );
+    }
+  } break;
+
+  default:
+    throw std::runtime_error( "MessageSerializer: can't serialize the type " +
+                              field.type.baseName().toStdString() );
+  }
+}
+
+void MessageSerializer::writeFields(const std::vector<Field> &fields, StringTreeLeaf leaf,
+                                    SerializationSource *source, Writer *writer) const
+{
+  for (const Field& field: fields)
+  {
+    leaf.node_ptr = const_cast<StringTreeNode*>( field.node );
+
+    if( !field.type.isArray() )
+    {
+      writeElement( field, leaf, source, writer );
+      continue;
+    }
+
+    uint32_t count = field.type.arraySize();
+    if( field.type.arraySize() < 0 )
+    {
+      count = source->arraySize( leaf );
+      writer->write( count );
+    }
+
+    StringTreeLeaf element_leaf = leaf;
+    element_leaf.node_ptr = const_cast<StringTreeNode*>( field.element_node );
+    element_leaf.array_size++;
+    for (uint32_t i=0; i < count; i++)
+    {
+      element_leaf.index_array[ element_leaf.array_size-1 ] = static_cast<uint16_t>(i);
+      writeElement( field, element_leaf, source, writer );
+    }
+  }
+}
+
+size_t MessageSerializer::write(SerializationSource *source, uint8_t *buffer, size_t buffer_size) const
+{
+  source->begin();
+  Writer writer = { buffer, buffer + buffer_size };
+  StringTreeLeaf leaf;
+  leaf.node_ptr = const_cast<StringTreeNode*>( _tree.croot() );
+  writeFields( _fields, leaf, source, &writer );
+  return writer.ptr - buffer;
+}
+
+//-------------------------------------------------------------------
+
+size_t FlatContainerSource::ArrayKeyHash::operator()(const ArrayKey &key) const
+{
+  size_t hash = std::hash<const void*>()( key.node ) ^ key.depth;
+  for (int i=0; i < key.depth; i++)
+  {
+    hash = hash * 31 + key.index[i];
+  }
+  return hash;
+}
+
+FlatContainerSource::FlatContainerSource(const MessageSerializer &serializer,
+                                         const ROSTypeFlat &container):
+  _container(container),
+  _value_index(0),
+  _name_index(0)
+{
+  if( !container.numeric_arrays.empty() )
+  {
+    throw std::runtime_error( "FlatContainerSource: the arrays in ROSTypeFlat::numeric_arrays "
+                              "(bulk_numeric_arrays) are not supported" );
+  }
+  if( container.skipped_arrays > 0 )
+  {
+    throw std::runtime_error( "FlatContainerSource: the container is incomplete, some arrays "
+                              "were larger than max_array_size" );
+  }
+  if( serializer.hasElementsWithoutLeaves() )
+  {
+    throw std::runtime_error( "FlatContainerSource: the length of some arrays can't be deduced "
+                              "from the container, because their elements may have no values" );
+  }
+
+  mapNodes( serializer.tree().croot(), container.tree.croot() );
+
+  // the length of an array is the largest index of its elements, plus one.
+  auto add_leaf = [this](const StringTreeLeaf& leaf)
+  {
+    int depth = leaf.array_size;
+    for (const StringTreeNode* node = leaf.node_ptr; node && depth > 0; node = node->parent())
+    {
+      if( !isArrayNode(node) ) continue;
+      depth--;
+      ArrayKey key;
+      key.node = node->parent();
+      key.depth = depth;
+      key.index.fill(0);
+      for (int i=0; i < depth; i++) key.index[i] = leaf.index_array[i];
+
+      uint32_t& size = _array_size[key];
+      size = std::max<uint32_t>( size, leaf.index_array[depth] + 1 );
+    }
+  };
+  for (const auto& it: container.value) add_leaf( it.first );
+  for (const auto& it: container.name)  add_leaf( it.first );
+}
+
+void FlatContainerSource::mapNodes(const StringTreeNode *schema_node, const StringTreeNode *flat_node)
+{
+  _nodes[schema_node] = flat_node;
+
+  const auto& schema_children = schema_node->children();
+  const auto& flat_children = flat_node->children();
+
+  for (size_t i=0; i < schema_children.size(); i++)
+  {
+    const StringTreeNode* schema_child = &schema_children[i];
+    // usually, the children are in the same order
+    if( i < flat_children.size() && flat_children[i].value() == schema_child->value() )
+    {
+      mapNodes( schema_child, &flat_children[i] );
+      continue;
+    }
+    for (const StringTreeNode& flat_child: flat_children)
+    {
+      if( flat_child.value() == schema_child->value() )
+      {
+        mapNodes( schema_child, &flat_child );
+        break;
+      }
+    }
+  }
+}
+
+const StringTreeNode *FlatContainerSource::flatNode(const StringTreeNode *schema_node) const
+{
+  auto it = _nodes.find( schema_node );
+  return (it != _nodes.end()) ? it->second : nullptr;
+}
+
+bool FlatContainerSource::sameLeaf(const StringTreeLeaf &flat_leaf,
+                                   const StringTreeNode *node,
+                                   const StringTreeLeaf &leaf)
+{
+  if( flat_leaf.node_ptr != node || flat_leaf.array_size != leaf.array_size ) return false;
+  for (int i=0; i < leaf.array_size; i++)
+  {
+    if( flat_leaf.index_array[i] != leaf.index_array[i] ) return false;
+  }
+  return true;
+}
+
+void FlatContainerSource::begin()
+{
+  _value_index = 0;
+  _name_index = 0;
+}
+
+uint32_t FlatContainerSource::arraySize(const StringTreeLeaf &leaf)
+{
+  ArrayKey key;
+  key.node = flatNode( leaf.node_ptr );
+  if( !key.node ) return 0;
+  key.depth = leaf.array_size;
+  key.index.fill(0);
+  for (int i=0; i < leaf.array_size; i++) key.index[i] = leaf.index_array[i];
+
+  auto it = _array_size.find( key );
+  return (it != _array_size.end()) ? it->second : 0;
+}
+
+VarNumber FlatContainerSource::number(const StringTreeLeaf &leaf, const ROSType &)
+{
+  const auto& values = _container.value;
+  if( _value_index < values.size() &&
+      sameLeaf( values[_value_index].first, flatNode( leaf.node_ptr ), leaf ) )
+  {
+    return values[_value_index++].second;
+  }
+  throw std::runtime_error( "FlatContainerSource: missing value of " + leafName( leaf ) );
+}
+
+boost::string_ref FlatContainerSource::string(const StringTreeLeaf &leaf)
+{
+  const auto& names = _container.name;
+  if( _name_index < names.size() &&
+      sameLeaf( names[_name_index].first, flatNode( leaf.node_ptr ), leaf ) )
+  {
+    const SString& str = names[_name_index++].second;
+    return boost::string_ref( str.data(), str.size() );
+  }
+  throw std::runtime_error( "FlatContainerSource: missing string " + leafName( leaf ) );
+}
+
+} // end namespace
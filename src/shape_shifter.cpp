@@ -0,0 +1,136 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright 2016 Davide Faconti
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of Willow Garage, Inc. nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+********************************************************************/
+
+#include <map>
+#include <mutex>
+#include <boost/weak_ptr.hpp>
+#include <boost/smart_ptr/owner_less.hpp>
+#include "ros_type_introspection/shape_shifter.hpp"
+
+namespace RosIntrospection{
+
+namespace {
+
+typedef boost::weak_ptr<ros::M_string> HeaderWeakPtr;
+
+// weak pointers are compared by ownership, therefore an expired entry can never be
+// confused with a new connection header allocated at the same address.
+typedef std::map<HeaderWeakPtr, MessageInfo::ConstPtr,
+                 boost::owner_less<HeaderWeakPtr> > ConnectionMap;
+
+std::mutex    connections_mutex;
+ConnectionMap connections;
+
+const std::string& headerValue(const ros::M_string& header, const char* key)
+{
+  static const std::string empty;
+  auto it = header.find(key);
+  return (it != header.end()) ? it->second : empty;
+}
+
+bool sameOwner(const HeaderWeakPtr& a, const boost::shared_ptr<ros::M_string>& b)
+{
+  return !a.owner_before(b) && !b.owner_before(a);
+}
+
+} // end anonymous namespace
+
+
+MessageInfo::ConstPtr MessageInfo::create(const std::string &md5sum,
+                                          const std::string &datatype,
+                                          const std::string &definition)
+{
+  boost::shared_ptr<MessageInfo> info( new MessageInfo );
+  info->md5sum = md5sum;
+  info->datatype = datatype;
+  info->definition = definition;
+  info->typed = (md5sum != "*");
+
+  if( info->typed && !definition.empty() )
+  {
+    // this is called by roscpp when a message is received: an exception would drop the message
+    try{
+      info->schema = SchemaCache::global().get( md5sum, datatype, definition );
+    }
+    catch( std::exception& err )
+    {
+      info->schema_error = err.what();
+    }
+  }
+  return info;
+}
+
+MessageInfo::ConstPtr MessageInfo::fromConnectionHeader(const boost::shared_ptr<ros::M_string> &connection_header)
+{
+  // fast path: consecutive messages received by a thread usually come from the same connection
+  thread_local HeaderWeakPtr         last_header;
+  thread_local MessageInfo::ConstPtr last_info;
+
+  if( last_info && sameOwner(last_header, connection_header) )
+  {
+    return last_info;
+  }
+
+  MessageInfo::ConstPtr info;
+  {
+    std::lock_guard<std::mutex> lock( connections_mutex );
+    auto it = connections.find( connection_header );
+    if( it != connections.end() )
+    {
+      info = it->second;
+    }
+  }
+
+  if( !info )
+  {
+    info = create( headerValue(*connection_header, "md5sum"),
+                   headerValue(*connection_header, "type"),
+                   headerValue(*connection_header, "message_definition") );
+
+    std::lock_guard<std::mutex> lock( connections_mutex );
+    // remove closed connections
+    for (auto it = connections.begin(); it != connections.end(); )
+    {
+      if( it->first.expired() ) { it = connections.erase(it); }
+      else { ++it; }
+    }
+    connections.insert( std::make_pair( HeaderWeakPtr(connection_header), info) );
+  }
+
+  last_header = connection_header;
+  last_info   = info;
+  return info;
+}
+
+} // end namespace
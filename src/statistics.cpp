@@ -0,0 +1,99 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright 2016 Davide Faconti
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of Willow Garage, Inc. nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+********************************************************************/
+
+
+#include "ros_type_introspection/statistics.hpp"
+
+namespace RosIntrospection{
+
+TypeCounters::TypeCounters():
+  messages(0), bytes(0), leaves(0), skipped_arrays(0), decode_ns(0), rename_ns(0)
+{
+}
+
+DecodeStatistics &DecodeStatistics::global()
+{
+  // intentionally leaked: ROSTypeFlat(s) might point to the counters during static destruction
+  static DecodeStatistics* statistics = new DecodeStatistics();
+  return *statistics;
+}
+
+TypeCounters *DecodeStatistics::counters(const SString &datatype)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  std::unique_ptr<TypeCounters>& counters = _counters[ datatype.toStdString() ];
+  if( !counters )
+  {
+    counters.reset( new TypeCounters );
+  }
+  return counters.get();
+}
+
+std::vector<TypeStatistics> DecodeStatistics::snapshot() const
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  std::vector<TypeStatistics> output;
+  output.reserve( _counters.size() );
+  for(const auto& it: _counters)
+  {
+    const TypeCounters& counters = *it.second;
+    TypeStatistics stats;
+    stats.datatype       = it.first;
+    stats.messages       = counters.messages;
+    stats.bytes          = counters.bytes;
+    stats.leaves         = counters.leaves;
+    stats.skipped_arrays = counters.skipped_arrays;
+    stats.decode_ns      = counters.decode_ns;
+    stats.rename_ns      = counters.rename_ns;
+    output.push_back( stats );
+  }
+  return output;
+}
+
+void DecodeStatistics::reset()
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  for(const auto& it: _counters)
+  {
+    TypeCounters& counters = *it.second;
+    counters.messages = 0;
+    counters.bytes = 0;
+    counters.leaves = 0;
+    counters.skipped_arrays = 0;
+    counters.decode_ns = 0;
+    counters.rename_ns = 0;
+  }
+}
+
+} // end namespace
@@ -0,0 +1,320 @@
+#include "config.h"
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <ros_type_introspection/renamer.hpp>
+#include <ros_type_introspection/shape_shifter.hpp>
+#include <ros_type_introspection/buffer_pool.hpp>
+#include <ros_type_introspection/message_index.hpp>
+
+/*
+ * This test replaces the global operator new/delete (and malloc, when the C library is glibc)
+ * to count the memory allocations done by the hot paths of the library, once they have
+ * been warmed up.
+ *
+ * buildRosFlatType and ShapeShifter::read are meant to be allocation-free in steady state:
+ * the test fails if they start allocating. The allocations of applyNameTransform are only reported.
+ *
+ * It must be a separate executable, because the replacement affects the whole program.
+ */
+
+namespace {
+
+std::atomic<bool>   counting(false);
+std::atomic<size_t> allocation_count(0);
+std::atomic<size_t> allocated_bytes(0);
+
+inline void countAllocation(size_t size)
+{
+  if( counting ){
+    allocation_count++;
+    allocated_bytes += size;
+  }
+}
+
+} // end namespace
+
+#ifdef __GLIBC__
+
+extern "C" {
+
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t num, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void  __libc_free(void* ptr);
+
+void* malloc(size_t size)
+{
+  countAllocation(size);
+  return __libc_malloc(size);
+}
+
+void* calloc(size_t num, size_t size)
+{
+  countAllocation(num*size);
+  return __libc_calloc(num, size);
+}
+
+void* realloc(void* ptr, size_t size)
+{
+  countAllocation(size);
+  return __libc_realloc(ptr, size);
+}
+
+void free(void* ptr)
+{
+  __libc_free(ptr);
+}
+
+} // end extern "C"
+
+// malloc is already counted
+inline void* countedAllocation(size_t size) { return malloc(size); }
+
+#else
+
+inline void* countedAllocation(size_t size)
+{
+  countAllocation(size);
+  return std::malloc(size);
+}
+
+#endif
+
+void* operator new(size_t size)
+{
+  void* ptr = countedAllocation( size > 0 ? size : 1 );
+  if( !ptr ) throw std::bad_alloc();
+  return ptr;
+}
+
+void* operator new[](size_t size)
+{
+  return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+  return countedAllocation( size > 0 ? size : 1 );
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+  return countedAllocation( size > 0 ? size : 1 );
+}
+
+void operator delete(void* ptr) noexcept                          { std::free(ptr); }
+void operator delete[](void* ptr) noexcept                        { std::free(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept   { std::free(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { std::free(ptr); }
+
+//-------------------------------------------------------------------
+
+using namespace RosIntrospection;
+
+struct AllocationStats
+{
+  double allocations; // per call
+  double bytes;       // per call
+};
+
+// Call the function WARMUP times, then count the allocations of the following ITERATIONS calls.
+template <typename Function>
+AllocationStats CountAllocations(const char* name, Function function)
+{
+  const int WARMUP = 10;
+  const int ITERATIONS = 100;
+
+  for (int i=0; i<WARMUP; i++) { function(i); }
+
+  allocation_count = 0;
+  allocated_bytes = 0;
+  counting = true;
+  for (int i=0; i<ITERATIONS; i++) { function(i); }
+  counting = false;
+
+  AllocationStats stats;
+  stats.allocations = double(allocation_count) / ITERATIONS;
+  stats.bytes       = double(allocated_bytes) / ITERATIONS;
+
+  std::cout << "[ ALLOCATIONS ] " << name << ": "
+            << stats.allocations << " allocations and "
+            << stats.bytes << " bytes per message" << std::endl;
+  return stats;
+}
+
+// JointState-like message, serialized by hand.
+const char* DEFINITION =
+    "Header header\n"
+    "string[] name\n"
+    "float64[] position\n"
+    "float64[] velocity\n"
+    "================================================================================\n"
+    "MSG: std_msgs/Header\n"
+    "uint32 seq\n"
+    "time stamp\n"
+    "string frame_id\n";
+
+template <typename T> void Append(std::vector<uint8_t>& buffer, T value)
+{
+  const uint8_t* ptr = reinterpret_cast<const uint8_t*>(&value);
+  buffer.insert( buffer.end(), ptr, ptr + sizeof(T) );
+}
+
+void AppendString(std::vector<uint8_t>& buffer, const std::string& str)
+{
+  Append<uint32_t>( buffer, str.size() );
+  buffer.insert( buffer.end(), str.begin(), str.end() );
+}
+
+std::vector<uint8_t> SerializeJointState(int joints, const std::string& name_prefix = "joint_")
+{
+  std::vector<uint8_t> buffer;
+  Append<uint32_t>( buffer, 42 );   // seq
+  Append<uint32_t>( buffer, 1234 ); // stamp.sec
+  Append<uint32_t>( buffer, 5678 ); // stamp.nsec
+  AppendString( buffer, "base_link" );
+
+  Append<uint32_t>( buffer, joints );
+  for (int i=0; i<joints; i++) AppendString( buffer, name_prefix + std::to_string(i) );
+  Append<uint32_t>( buffer, joints );
+  for (int i=0; i<joints; i++) Append<double>( buffer, 10 + i );
+  Append<uint32_t>( buffer, joints );
+  for (int i=0; i<joints; i++) Append<double>( buffer, 20 + i );
+  return buffer;
+}
+
+TEST(Allocations, BuildRosFlatType)
+{
+  ROSTypeList type_map = buildROSTypeMapFromDefinition( "sensor_msgs/JointState", DEFINITION );
+  ROSType main_type( "sensor_msgs/JointState" );
+  SString prefix( "JointState" );
+
+  // messages with a different number of elements are alternated
+  std::vector<uint8_t> buffers[2] = { SerializeJointState(3), SerializeJointState(6) };
+
+  ROSTypeFlat flat_container;
+  AllocationStats stats = CountAllocations( "buildRosFlatType", [&](int i)
+  {
+    buildRosFlatType( type_map, main_type, prefix, buffers[i%2].data(), &flat_container, 100 );
+  });
+  EXPECT_EQ( stats.allocations, 0 );
+
+  // the instrumentation doesn't allocate either
+  DecodeStatistics::global().setEnabled( true );
+  stats = CountAllocations( "buildRosFlatType (with DecodeStatistics)", [&](int i)
+  {
+    buildRosFlatType( type_map, main_type, prefix, buffers[i%2].data(), &flat_container, 100 );
+  });
+  DecodeStatistics::global().setEnabled( false );
+  EXPECT_EQ( stats.allocations, 0 );
+
+  ROSTypeFlat bulk_container;
+  bulk_container.bulk_numeric_arrays = true;
+  stats = CountAllocations( "buildRosFlatType (bulk_numeric_arrays)", [&](int i)
+  {
+    buildRosFlatType( type_map, main_type, prefix, buffers[i%2].data(), &bulk_container, 100 );
+  });
+  EXPECT_EQ( stats.allocations, 0 );
+
+  // the reused tree gives the same result of a new one
+  ROSTypeFlat new_container;
+  buildRosFlatType( type_map, main_type, prefix, buffers[1].data(), &new_container, 100 );
+  ASSERT_EQ( flat_container.value.size(), new_container.value.size() );
+  ASSERT_EQ( flat_container.name.size(),  new_container.name.size() );
+  for (size_t i=0; i<new_container.value.size(); i++)
+  {
+    EXPECT_EQ( flat_container.value[i].first.toStdString(), new_container.value[i].first.toStdString() );
+    EXPECT_EQ( flat_container.value[i].second.convert<double>(), new_container.value[i].second.convert<double>() );
+  }
+  for (size_t i=0; i<new_container.name.size(); i++)
+  {
+    EXPECT_EQ( flat_container.name[i].first.toStdString(), new_container.name[i].first.toStdString() );
+    EXPECT_EQ( flat_container.name[i].second, new_container.name[i].second );
+  }
+}
+
+TEST(Allocations, BuildRosFlatTypeLongStrings)
+{
+  ROSTypeList type_map = buildROSTypeMapFromDefinition( "sensor_msgs/JointState", DEFINITION );
+  ROSType main_type( "sensor_msgs/JointState" );
+  SString prefix( "JointState" );
+
+  // the names don't fit in the internal buffer of SString
+  const std::string long_name = "a_joint_name_that_is_longer_than_the_sso_capacity_";
+  std::vector<uint8_t> buffers[2] = { SerializeJointState(3, long_name), SerializeJointState(6, long_name) };
+
+  ROSTypeFlat flat_container;
+  AllocationStats heap_stats = CountAllocations( "buildRosFlatType (long strings)", [&](int i)
+  {
+    buildRosFlatType( type_map, main_type, prefix, buffers[i%2].data(), &flat_container, 100 );
+  });
+  EXPECT_GT( heap_stats.allocations, 0 );
+
+  StringArena arena;
+  ROSTypeFlat arena_container;
+  arena_container.string_memory = &arena;
+  AllocationStats arena_stats = CountAllocations( "buildRosFlatType (long strings, StringArena)", [&](int i)
+  {
+    arena.release();
+    buildRosFlatType( type_map, main_type, prefix, buffers[i%2].data(), &arena_container, 100 );
+  });
+  EXPECT_EQ( arena_stats.allocations, 0 );
+  ASSERT_EQ( arena_container.name.size(), 7 );
+  EXPECT_EQ( arena_container.name[6].second.toStdString(), long_name + "5" );
+}
+
+TEST(Allocations, ShapeShifterRead)
+{
+  std::vector<uint8_t> buffers[2] = { SerializeJointState(3), SerializeJointState(6) };
+
+  ShapeShifter shifter;
+  AllocationStats stats = CountAllocations( "ShapeShifter::read", [&](int i)
+  {
+    ros::serialization::IStream stream( buffers[i%2].data(), buffers[i%2].size() );
+    shifter.read( stream );
+  });
+  EXPECT_EQ( stats.allocations, 0 );
+}
+
+TEST(Allocations, MessageIndexGetValue)
+{
+  ROSTypeList type_map = buildROSTypeMapFromDefinition( "sensor_msgs/JointState", DEFINITION );
+  MessageIndex index( type_map, ROSType("sensor_msgs/JointState") );
+
+  std::vector<uint8_t> buffer = SerializeJointState(6);
+  index.build( buffer.data(), buffer.size() );
+
+  const std::string paths[2] = { "header/stamp", "velocity.4" };
+  VarNumber value;
+  AllocationStats stats = CountAllocations( "MessageIndex::getValue", [&](int i)
+  {
+    index.getValue( paths[i%2], &value );
+  });
+  EXPECT_EQ( stats.allocations, 0 );
+  EXPECT_EQ( value.convert<double>(), 24 );
+}
+
+TEST(Allocations, ApplyNameTransform)
+{
+  ROSTypeList type_map = buildROSTypeMapFromDefinition( "sensor_msgs/JointState", DEFINITION );
+  ROSType main_type( "sensor_msgs/JointState" );
+
+  std::vector<SubstitutionRule> rules;
+  rules.push_back( SubstitutionRule( "position.#", "name.#", "@.position" ));
+  rules.push_back( SubstitutionRule( "velocity.#", "name.#", "@.velocity" ));
+
+  std::vector<uint8_t> buffer = SerializeJointState(6);
+  ROSTypeFlat flat_container;
+  buildRosFlatType( type_map, main_type, "JointState", buffer.data(), &flat_container, 100 );
+
+  RenamedValues renamed_values;
+  // not allocation-free yet: only reported
+  CountAllocations( "applyNameTransform", [&](int)
+  {
+    applyNameTransform( rules, flat_container, renamed_values );
+  });
+  EXPECT_EQ( renamed_values.size(), flat_container.value.size() );
+}
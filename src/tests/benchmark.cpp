@@ -1,92 +1,393 @@
-
-#include <topic_tools/shape_shifter.h>
 #include <boost/algorithm/string.hpp>
-#include <boost/serialization/serialization.hpp>
 #include <boost/utility/string_ref.hpp>
-#include <geometry_msgs/Pose.h>
 #include <sensor_msgs/JointState.h>
+#include <sensor_msgs/Imu.h>
+#include <sensor_msgs/LaserScan.h>
+#include <sensor_msgs/PointCloud2.h>
+#include <tf2_msgs/TFMessage.h>
+#include <visualization_msgs/MarkerArray.h>
+#include <diagnostic_msgs/DiagnosticArray.h>
 #include <sstream>
 #include <iostream>
 #include <chrono>
+#include <algorithm>
+#include <functional>
 #include <ros_type_introspection/renamer.hpp>
+#include <ros_type_introspection/buffer_pool.hpp>
+#include "synthetic_generator.hpp"
 
 using namespace ros::message_traits;
 using namespace RosIntrospection;
 
+/*
+ * Benchmark of the parser, the deserializer and the renamer on a fixed corpus of messages.
+ *
+ * Each stage is measured separately, with warmup and repetitions. The output is CSV
+ * (one line per message and stage) to make it easy to compare different releases.
+ *
+ * usage: ros_introspection_benchmark [--repetitions N] [--filter substring]
+ */
 
-std::vector<SubstitutionRule> Rules()
+struct Sample
 {
-    std::vector<SubstitutionRule> rules;
+  std::string name;
+  std::string datatype;
+  std::string definition;
+  std::vector<uint8_t> buffer;
+  std::vector<SubstitutionRule> rules;
+};
 
-/*
-    rules.push_back( SubstitutionRule( "transforms.#.transform",
-                                       "transforms.#.header.frame_id",
-                                       "transforms.#" ));
-
-    rules.push_back( SubstitutionRule( "transforms.#.header",
-                                       "transforms.#.header.frame_id",
-                                       "transforms.#.header" ));*/
-
-    rules.push_back( SubstitutionRule( "position.#", "name.#", "@.position" ));
-    rules.push_back( SubstitutionRule( "velocity.#", "name.#", "@.velocity" ));
-    rules.push_back( SubstitutionRule( "effort.#",   "name.#", "@.effort"   ));
-    return rules;
+struct Options
+{
+  int warmup_ms = 200;
+  int repetition_ms = 200;
+  int repetitions = 5;
+  uint32_t max_array_size = 2000;
+  std::string filter;
+};
+
+template <typename Message>
+Sample CreateSample(const std::string& name, const Message& msg,
+                    std::vector<SubstitutionRule> rules = std::vector<SubstitutionRule>())
+{
+  Sample sample;
+  sample.name = name;
+  sample.datatype = DataType<Message>::value();
+  sample.definition = Definition<Message>::value();
+  sample.buffer.resize( ros::serialization::serializationLength(msg) );
+  ros::serialization::OStream stream(sample.buffer.data(), sample.buffer.size());
+  ros::serialization::serialize(stream, msg);
+  sample.rules = rules;
+  return sample;
 }
 
+std::vector<SubstitutionRule> JointStateRules()
+{
+  std::vector<SubstitutionRule> rules;
+  rules.push_back( SubstitutionRule( "position.#", "name.#", "@.position" ));
+  rules.push_back( SubstitutionRule( "velocity.#", "name.#", "@.velocity" ));
+  rules.push_back( SubstitutionRule( "effort.#",   "name.#", "@.effort"   ));
+  return rules;
+}
 
-int main( int argc, char** argv)
+Sample JointStateSample(int joints)
 {
+  sensor_msgs::JointState msg;
+  msg.header.seq = 100;
+  msg.header.stamp.sec = 1234;
+  msg.header.frame_id = "base_link";
 
-    ROSTypeList type_map =  buildROSTypeMapFromDefinition(
-                DataType<sensor_msgs::JointState >::value(),
-                Definition<sensor_msgs::JointState>::value() );
+  for (int i=0; i< joints; i++)
+  {
+    msg.name.push_back( "joint_" + std::to_string(i) );
+    msg.position.push_back( 10 + i );
+    msg.velocity.push_back( 20 + i );
+    msg.effort.push_back( 30 + i );
+  }
+  return CreateSample( "JointState_" + std::to_string(joints), msg, JointStateRules() );
+}
 
-    std::cout << "------------------------------"  << std::endl;
-    std::cout << type_map << std::endl;
+Sample TFMessageSample()
+{
+  tf2_msgs::TFMessage msg;
+  for (int i=0; i< 20; i++)
+  {
+    geometry_msgs::TransformStamped transform;
+    transform.header.frame_id = "frame_" + std::to_string(i);
+    transform.child_frame_id  = "frame_" + std::to_string(i+1);
+    transform.transform.translation.x = i;
+    transform.transform.rotation.w = 1.0;
+    msg.transforms.push_back( transform );
+  }
+  std::vector<SubstitutionRule> rules;
+  rules.push_back( SubstitutionRule( "transforms.#.transform",
+                                     "transforms.#.child_frame_id",
+                                     "transforms.@" ));
+  return CreateSample( "TFMessage_20", msg, rules );
+}
 
-    sensor_msgs::JointState js_msg;
+Sample ImuSample()
+{
+  sensor_msgs::Imu msg;
+  msg.header.frame_id = "imu_link";
+  msg.orientation.w = 1.0;
+  for (int i=0; i<9; i++) msg.orientation_covariance[i] = i;
+  return CreateSample( "Imu", msg );
+}
 
-    js_msg.name.resize(6);
-    js_msg.position.resize(6);
-    js_msg.velocity.resize(6);
-    js_msg.effort.resize(6);
+Sample LaserScanSample()
+{
+  sensor_msgs::LaserScan msg;
+  msg.header.frame_id = "laser";
+  msg.ranges.resize( 1081 );
+  msg.intensities.resize( 1081 );
+  for (size_t i=0; i< msg.ranges.size(); i++)
+  {
+    msg.ranges[i] = 1.0 + 0.001*i;
+    msg.intensities[i] = i % 100;
+  }
+  return CreateSample( "LaserScan_1081", msg );
+}
+
+Sample PointCloudSample()
+{
+  sensor_msgs::PointCloud2 msg;
+  msg.header.frame_id = "camera";
+  msg.height = 1;
+  msg.width  = 10000;
+  const char* names[3] = {"x", "y", "z"};
+  for (int i=0; i<3; i++)
+  {
+    sensor_msgs::PointField field;
+    field.name = names[i];
+    field.offset = 4*i;
+    field.datatype = sensor_msgs::PointField::FLOAT32;
+    field.count = 1;
+    msg.fields.push_back( field );
+  }
+  msg.point_step = 12;
+  msg.row_step = msg.point_step * msg.width;
+  msg.data.resize( msg.row_step );
+  // data is larger than max_array_size: this measures the cost of skipping it.
+  return CreateSample( "PointCloud2_10000", msg );
+}
 
-    const char* suffix[6] = { "_A", "_B", "_C", "_D" , "_E", "_F"};
+Sample MarkerArraySample()
+{
+  visualization_msgs::MarkerArray msg;
+  for (int i=0; i<10; i++)
+  {
+    visualization_msgs::Marker marker;
+    marker.header.frame_id = "map";
+    marker.ns = "benchmark";
+    marker.id = i;
+    marker.type = visualization_msgs::Marker::LINE_STRIP;
+    for (int p=0; p<10; p++)
+    {
+      geometry_msgs::Point point;
+      point.x = p;
+      marker.points.push_back( point );
+    }
+    msg.markers.push_back( marker );
+  }
+  return CreateSample( "MarkerArray_10", msg );
+}
 
-    for (int i=0; i< js_msg.name.size() ; i++)
+Sample DiagnosticArraySample()
+{
+  diagnostic_msgs::DiagnosticArray msg;
+  for (int i=0; i<10; i++)
+  {
+    diagnostic_msgs::DiagnosticStatus status;
+    status.level = diagnostic_msgs::DiagnosticStatus::OK;
+    status.name = "device_" + std::to_string(i);
+    status.message = "everything is fine";
+    status.hardware_id = "hw_" + std::to_string(i);
+    for (int k=0; k<5; k++)
     {
-        js_msg.header.seq = 100+i;
-        js_msg.header.stamp.sec = 1234;
-        js_msg.header.frame_id = std::string("frame").append(suffix[i]);
-
-        js_msg.name[i] = std::string("child").append(suffix[i]);
-        js_msg.position[i]  = 10 +i;
-        js_msg.velocity[i]  = 20 +i;
-        js_msg.effort[i]    = 30 +i;
+      diagnostic_msgs::KeyValue key_value;
+      key_value.key = "key_" + std::to_string(k);
+      key_value.value = std::to_string(k*i);
+      status.values.push_back( key_value );
     }
+    msg.status.push_back( status );
+  }
+  return CreateSample( "DiagnosticArray_10", msg );
+}
+
+Sample SyntheticSample(const std::string& name, const SyntheticOptions& options)
+{
+  SyntheticMessage msg = SyntheticGenerator::generate( options, name );
+  Sample sample;
+  sample.name = name;
+  sample.datatype = msg.datatype;
+  sample.definition = msg.definition;
+  sample.buffer = msg.buffer;
+  return sample;
+}
+
+// Custom types generated by SyntheticGenerator: deep, wide and with nested arrays.
+void AddSyntheticSamples(std::vector<Sample>* corpus)
+{
+  SyntheticOptions deep;
+  deep.depth = 8;
+  deep.width = 10;
+  deep.array_probability = 0.0;
+  deep.string_probability = 0.0;
+  corpus->push_back( SyntheticSample( "Synthetic_depth8", deep ) );
+
+  SyntheticOptions flat;
+  flat.depth = 1;
+  flat.width = 2000;
+  flat.array_probability = 0.0;
+  flat.string_probability = 0.0;
+  corpus->push_back( SyntheticSample( "Synthetic_flat2000", flat ) );
 
-    std::vector<uint8_t> buffer(64*1024);
+  SyntheticOptions mixed;
+  mixed.depth = 4;
+  mixed.width = 10;
+  mixed.max_array_nesting = 3;
+  mixed.array_probability = 0.3;
+  mixed.max_array_length = 5;
+  mixed.string_probability = 0.3;
+  corpus->push_back( SyntheticSample( "Synthetic_mixed", mixed ) );
+
+  // mostly strings longer than the internal buffer of SString
+  SyntheticOptions strings;
+  strings.depth = 2;
+  strings.width = 50;
+  strings.array_probability = 0.2;
+  strings.string_probability = 0.8;
+  strings.max_string_length = 200;
+  corpus->push_back( SyntheticSample( "Synthetic_long_strings", strings ) );
+}
 
-    auto start = std::chrono::high_resolution_clock::now();
+//-------------------------------------------------------------------
 
-    ros::serialization::OStream stream(buffer.data(), buffer.size());
-    ros::serialization::Serializer<sensor_msgs::JointState>::write(stream, js_msg);
-    ROSType main_type (DataType<sensor_msgs::JointState>::value());
+// Run the function in batches for repetition_ms milliseconds, after a warmup,
+// and return the median time of a single call, in nanoseconds.
+double Measure(const Options& options, const std::function<void()>& function)
+{
+  typedef std::chrono::steady_clock Clock;
 
-    auto rules = Rules();
-    RenamedValues renamed_values;
-    ROSTypeFlat flat_container;
-    for (int i=0; i<100*1000;i++)
+  auto run_for = [&function](int milliseconds) -> double
+  {
+    const auto start = Clock::now();
+    const auto deadline = start + std::chrono::milliseconds(milliseconds);
+    size_t iterations = 0;
+    auto now = start;
+    while( now < deadline )
     {
-        buildRosFlatType(type_map,main_type, "joint_state", buffer.data(), &flat_container, 100);
-        applyNameTransform( rules , flat_container , renamed_values);
+      for (int i=0; i<10; i++) { function(); }
+      iterations += 10;
+      now = Clock::now();
     }
+    return std::chrono::duration<double, std::nano>( now - start ).count() / iterations;
+  };
 
-    auto end = std::chrono::high_resolution_clock::now();
-    auto elapsed = end - start;
+  run_for( options.warmup_ms );
 
-    std::cout << "time elapsed: " << std::chrono::duration_cast< std::chrono::milliseconds>( elapsed ).count()  <<   std::endl;
+  std::vector<double> samples;
+  for (int r=0; r< options.repetitions; r++)
+  {
+    samples.push_back( run_for( options.repetition_ms ) );
+  }
+  std::sort( samples.begin(), samples.end() );
+  return samples[ samples.size()/2 ];
+}
 
-    return 0;
+void PrintResult(const Sample& sample, const char* stage, size_t leaves, double ns_per_message)
+{
+  const double messages_per_sec = 1e9 / ns_per_message;
+  std::cout << sample.name << ","
+            << stage << ","
+            << sample.buffer.size() << ","
+            << leaves << ","
+            << ns_per_message << ","
+            << messages_per_sec << ","
+            << messages_per_sec * sample.buffer.size() << ","
+            << ( leaves > 0 ? ns_per_message / leaves : 0.0 ) << std::endl;
 }
 
+void RunBenchmark(const Options& options, Sample& sample)
+{
+  ROSTypeList type_map = buildROSTypeMapFromDefinition( sample.datatype, sample.definition );
+  ROSType main_type( sample.datatype );
+  ROSTypeFlat flat_container;
+  RenamedValues renamed_values;
+
+  buildRosFlatType( type_map, main_type, sample.name, sample.buffer.data(),
+                    &flat_container, options.max_array_size );
+  const size_t leaves = flat_container.value.size() + flat_container.name.size();
+
+  double ns = Measure( options, [&]()
+  {
+    ROSTypeList list = buildROSTypeMapFromDefinition( sample.datatype, sample.definition );
+  });
+  PrintResult( sample, "buildROSTypeMapFromDefinition", leaves, ns );
+
+  ns = Measure( options, [&]()
+  {
+    buildRosFlatType( type_map, main_type, sample.name, sample.buffer.data(),
+                      &flat_container, options.max_array_size );
+  });
+  PrintResult( sample, "buildRosFlatType", leaves, ns );
+
+  ROSTypeFlat bulk_container;
+  bulk_container.bulk_numeric_arrays = true;
+  ns = Measure( options, [&]()
+  {
+    buildRosFlatType( type_map, main_type, sample.name, sample.buffer.data(),
+                      &bulk_container, options.max_array_size );
+  });
+  PrintResult( sample, "buildRosFlatType(bulk_numeric_arrays)", leaves, ns );
+
+  StringArena arena;
+  ROSTypeFlat arena_container;
+  arena_container.string_memory = &arena;
+  ns = Measure( options, [&]()
+  {
+    arena.release();
+    buildRosFlatType( type_map, main_type, sample.name, sample.buffer.data(),
+                      &arena_container, options.max_array_size );
+  });
+  PrintResult( sample, "buildRosFlatType(StringArena)", leaves, ns );
+
+  ns = Measure( options, [&]()
+  {
+    applyNameTransform( sample.rules, flat_container, renamed_values );
+  });
+  PrintResult( sample, "applyNameTransform", leaves, ns );
+
+  char buffer[1024];
+  ns = Measure( options, [&]()
+  {
+    for (const auto& it: flat_container.value) { it.first.toStr( buffer ); }
+    for (const auto& it: flat_container.name)  { it.first.toStr( buffer ); }
+  });
+  PrintResult( sample, "StringTreeLeaf::toStr", leaves, ns );
+}
+
+int main( int argc, char** argv)
+{
+  Options options;
+
+  for (int i=1; i<argc; i++)
+  {
+    const std::string arg( argv[i] );
+    if( arg == "--repetitions" && i+1 < argc ) {
+      options.repetitions = std::max(1, atoi( argv[++i] ));
+    }
+    else if( arg == "--filter" && i+1 < argc ) {
+      options.filter = argv[++i];
+    }
+    else {
+      std::cerr << "usage: " << argv[0] << " [--repetitions N] [--filter substring]" << std::endl;
+      return 1;
+    }
+  }
+
+  std::vector<Sample> corpus;
+  corpus.push_back( JointStateSample(6) );
+  corpus.push_back( JointStateSample(50) );
+  corpus.push_back( JointStateSample(200) );
+  corpus.push_back( TFMessageSample() );
+  corpus.push_back( ImuSample() );
+  corpus.push_back( LaserScanSample() );
+  corpus.push_back( PointCloudSample() );
+  corpus.push_back( MarkerArraySample() );
+  corpus.push_back( DiagnosticArraySample() );
+  AddSyntheticSamples( &corpus );
+
+  std::cout << "message,stage,bytes,leaves,ns_per_msg,msgs_per_sec,bytes_per_sec,ns_per_leaf" << std::endl;
+
+  for (Sample& sample: corpus)
+  {
+    if( !options.filter.empty() && sample.name.find( options.filter ) == std::string::npos )
+    {
+      continue;
+    }
+    RunBenchmark( options, sample );
+  }
+  return 0;
+}
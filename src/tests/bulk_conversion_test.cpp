@@ -0,0 +1,60 @@
+#include "config.h"
+#include <gtest/gtest.h>
+
+#include <random>
+#include <ros_type_introspection/details/bulk_conversion.hpp>
+
+using namespace RosIntrospection;
+
+namespace {
+
+// Compare the result of convertToDouble with a plain cast, for many lengths
+// (to cover both the vectorized part and the tail).
+template <typename T> void CheckConversion(BuiltinType type, std::vector<T> special_values)
+{
+  std::mt19937 random(42);
+  std::uniform_int_distribution<int> distribution(-1000, 1000);
+
+  for (size_t count=0; count < 40; count++)
+  {
+    std::vector<T> input;
+    for (size_t i=0; i<count; i++)
+    {
+      input.push_back( i < special_values.size() ? special_values[i]
+                                                 : static_cast<T>( distribution(random) ) );
+    }
+    // misaligned, as it usually is in a serialized message
+    std::vector<uint8_t> buffer( 1 + count*sizeof(T) );
+    if( count > 0 ) memcpy( buffer.data() + 1, input.data(), count*sizeof(T) );
+
+    std::vector<double> output( count + 1, -12345.0 );
+    details::convertToDouble( type, buffer.data() + 1, count, output.data() );
+
+    for (size_t i=0; i<count; i++)
+    {
+      EXPECT_EQ( output[i], static_cast<double>(input[i]) ) << toStr(type) << " " << i << "/" << count;
+    }
+    // nothing written after the end
+    EXPECT_EQ( output[count], -12345.0 );
+  }
+}
+
+}
+
+TEST(BulkConversion, AllTypes)
+{
+  CheckConversion<float>( FLOAT32, { 0.5f, -1e30f, std::numeric_limits<float>::max(), 3.25f } );
+  CheckConversion<double>( FLOAT64, { 0.5, -1e300, std::numeric_limits<double>::min() } );
+  CheckConversion<int16_t>( INT16, { -32768, 32767, -1, 0, 1 } );
+  CheckConversion<uint16_t>( UINT16, { 65535, 32768, 0, 1 } );
+  CheckConversion<int32_t>( INT32, { std::numeric_limits<int32_t>::min(), std::numeric_limits<int32_t>::max(), -1 } );
+  CheckConversion<uint32_t>( UINT32, { std::numeric_limits<uint32_t>::max(), 0 } );
+  CheckConversion<int64_t>( INT64, { -(int64_t(1) << 40), 7 } );
+  CheckConversion<uint64_t>( UINT64, { uint64_t(1) << 60, 7 } );
+  CheckConversion<int8_t>( INT8, { -128, 127 } );
+  CheckConversion<uint8_t>( UINT8, { 255, 0 } );
+
+  EXPECT_TRUE( details::isBulkConvertible( FLOAT32 ) );
+  EXPECT_FALSE( details::isBulkConvertible( TIME ) );
+  EXPECT_FALSE( details::isBulkConvertible( STRING ) );
+}
@@ -0,0 +1,194 @@
+#include "config.h"
+#include <gtest/gtest.h>
+#include <fstream>
+#include <sstream>
+
+#include <ros_type_introspection/codegen.hpp>
+#include <ros_type_introspection/schema.hpp>
+
+// created with:
+//   ros_introspection_codegen test_msgs/Generated 0123456789abcdef0123456789abcdef <DEFINITION> generated_decoder.hpp
+#include "generated_decoder.hpp"
+
+using namespace RosIntrospection;
+
+namespace {
+
+const char* MD5SUM = "0123456789abcdef0123456789abcdef";
+
+const char* DEFINITION =
+    "uint8 MODE_A=1\n"
+    "Header header\n"
+    "uint8 mode\n"
+    "string[] names\n"
+    "Point[] points\n"
+    "Point origin\n"
+    "Vector[3] corners\n"
+    "int16[4] gains\n"
+    "float64[] values\n"
+    "duration timeout\n"
+    "================================================================================\n"
+    "MSG: std_msgs/Header\n"
+    "uint32 seq\n"
+    "time stamp\n"
+    "string frame_id\n"
+    "================================================================================\n"
+    "MSG: test_msgs/Point\n"
+    "string label\n"
+    "float64 x\n"
+    "float64 y\n"
+    "================================================================================\n"
+    "MSG: test_msgs/Vector\n"
+    "float32 x\n"
+    "float32 y\n";
+
+struct Writer
+{
+  std::vector<uint8_t> buffer;
+  template <typename T> void add(T value)
+  {
+    buffer.insert( buffer.end(), (const uint8_t*)&value, (const uint8_t*)&value + sizeof(T) );
+  }
+  void add(const std::string& str)
+  {
+    add<uint32_t>( str.size() );
+    buffer.insert( buffer.end(), str.begin(), str.end() );
+  }
+};
+
+std::vector<uint8_t> Serialize(int names, int points, int values)
+{
+  Writer writer;
+  writer.add<uint32_t>( 7 );
+  writer.add<uint32_t>( 10 );
+  writer.add<uint32_t>( 20 );
+  writer.add( std::string("base_link") );
+  writer.add<uint8_t>( 1 );
+  writer.add<uint32_t>( names );
+  for (int i=0; i<names; i++) writer.add( "name_" + std::to_string(i) );
+  writer.add<uint32_t>( points );
+  for (int i=0; i<points; i++)
+  {
+    writer.add( "point_" + std::to_string(i) );
+    writer.add<double>( i );
+    writer.add<double>( 10*i );
+  }
+  writer.add( std::string("origin") );
+  writer.add<double>( -1 );
+  writer.add<double>( -2 );
+  for (int i=0; i<6; i++) writer.add<float>( 0.5f * i );
+  for (int i=0; i<4; i++) writer.add<int16_t>( -i );
+  writer.add<uint32_t>( values );
+  for (int i=0; i<values; i++) writer.add<double>( 100 + i );
+  writer.add<uint32_t>( 30 );
+  writer.add<uint32_t>( 40 );
+  return writer.buffer;
+}
+
+void ExpectEqual(ROSTypeFlat& expected, ROSTypeFlat& actual)
+{
+  ASSERT_EQ( expected.value.size(), actual.value.size() );
+  ASSERT_EQ( expected.name.size(), actual.name.size() );
+  EXPECT_EQ( expected.skipped_arrays, actual.skipped_arrays );
+  for (size_t i=0; i < expected.value.size(); i++)
+  {
+    EXPECT_EQ( expected.value[i].first.toStdString(), actual.value[i].first.toStdString() );
+    EXPECT_EQ( expected.value[i].second.getTypeID(), actual.value[i].second.getTypeID() );
+    EXPECT_EQ( expected.value[i].second.convert<double>(), actual.value[i].second.convert<double>() );
+  }
+  for (size_t i=0; i < expected.name.size(); i++)
+  {
+    EXPECT_EQ( expected.name[i].first.toStdString(), actual.name[i].first.toStdString() );
+    EXPECT_EQ( expected.name[i].second, actual.name[i].second );
+  }
+}
+
+}
+
+TEST(Codegen, SameResultOfGenericDecoder)
+{
+  ROSTypeList type_map = buildROSTypeMapFromDefinition( "test_msgs/Generated", DEFINITION );
+  ROSType main_type( "test_msgs/Generated" );
+
+  ROSTypeFlat generic;
+  ROSTypeFlat generated_flat;
+
+  const int sizes[][3] = { {2, 3, 4}, {0, 0, 0}, {5, 1, 20}, {1, 2, 3} };
+  for (const auto& size: sizes)
+  {
+    std::vector<uint8_t> buffer = Serialize( size[0], size[1], size[2] );
+    for (uint32_t max_array_size: {100, 4, 2})
+    {
+      buildRosFlatType( type_map, main_type, "msg", buffer.data(), &generic, max_array_size );
+      generated::test_msgs_Generated::decode( type_map, "msg", buffer.data(), &generated_flat, max_array_size );
+      ExpectEqual( generic, generated_flat );
+    }
+  }
+
+  // arrays of numbers stored in bulk
+  generic.bulk_numeric_arrays = true;
+  generated_flat.bulk_numeric_arrays = true;
+  std::vector<uint8_t> buffer = Serialize( 2, 3, 20 );
+  buildRosFlatType( type_map, main_type, "msg", buffer.data(), &generic, 100 );
+  generated::test_msgs_Generated::decode( type_map, "msg", buffer.data(), &generated_flat, 100 );
+  ExpectEqual( generic, generated_flat );
+
+  ASSERT_EQ( generated_flat.numeric_arrays.size(), 2 );
+  EXPECT_EQ( generated_flat.array_values, generic.array_values );
+  EXPECT_EQ( generated_flat.array_values.size(), 24 );
+  const NumericArray& gains = generated_flat.numeric_arrays[0];
+  EXPECT_EQ( gains.leafAt(3).toStdString(), "msg/gains.3" );
+  EXPECT_EQ( gains.type, INT16 );
+  EXPECT_EQ( generated_flat.array_values[ gains.first + 3 ], -3 );
+  const NumericArray& values = generated_flat.numeric_arrays[1];
+  EXPECT_EQ( values.leafAt(19).toStdString(), "msg/values.19" );
+  EXPECT_EQ( generated_flat.array_values[ values.first + 19 ], 119 );
+}
+
+TEST(Codegen, DispatchByMD5)
+{
+  EXPECT_TRUE( DecoderRegistry::global().find( MD5SUM, "test_msgs/Generated" ) != nullptr );
+  EXPECT_TRUE( DecoderRegistry::global().find( MD5SUM, "test_msgs/Other" ) == nullptr );
+
+  MessageSchema schema( MD5SUM, "test_msgs/Generated", DEFINITION );
+  MessageSchema other_schema( "fedcba9876543210fedcba9876543210", "test_msgs/Generated", DEFINITION );
+
+  std::vector<uint8_t> buffer = Serialize( 2, 3, 4 );
+  ROSTypeFlat flat_generated, flat_generic;
+
+  // the generated decoder builds the whole tree
+  buildRosFlatType( schema, "msg", buffer.data(), &flat_generated, 100 );
+  EXPECT_TRUE( flat_generated.tree_complete );
+  buildRosFlatType( other_schema, "msg", buffer.data(), &flat_generic, 100 );
+  EXPECT_FALSE( flat_generic.tree_complete );
+  ExpectEqual( flat_generic, flat_generated );
+
+  // the two decoders can be used with the same ROSTypeFlat
+  buildRosFlatType( schema, "msg", buffer.data(), &flat_generic, 100 );
+  EXPECT_TRUE( flat_generic.tree_complete );
+  buildRosFlatType( other_schema, "msg", buffer.data(), &flat_generated, 100 );
+  ExpectEqual( flat_generic, flat_generated );
+}
+
+TEST(Codegen, Generator)
+{
+  ROSTypeList type_map = buildROSTypeMapFromDefinition( "test_msgs/Generated", DEFINITION );
+  std::ostringstream output;
+  generateDecoder( type_map, ROSType("test_msgs/Generated"), MD5SUM, output );
+
+  EXPECT_NE( output.str().find( "namespace test_msgs_Generated" ), std::string::npos );
+  EXPECT_NE( output.str().find( MD5SUM ), std::string::npos );
+
+  // the header used by these tests must be the current output of the generator
+  std::string filename( __FILE__ );
+  filename = filename.substr( 0, filename.find_last_of('/') + 1 ) + "generated_decoder.hpp";
+  std::ifstream file( filename );
+  ASSERT_TRUE( file.good() ) << filename;
+  std::stringstream checked_in;
+  checked_in << file.rdbuf();
+  EXPECT_TRUE( checked_in.str() == output.str() )
+      << filename << " is out of date: create it again with ros_introspection_codegen";
+
+  EXPECT_THROW( generateDecoder( type_map, ROSType("test_msgs/Missing"), MD5SUM, output ),
+                std::runtime_error );
+}
@@ -0,0 +1,204 @@
+#include "config.h"
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <cstring>
+
+#include "ros_type_introspection/columnar_file.hpp"
+
+using namespace RosIntrospection;
+
+TEST(ColumnarFile, WriteAndRead)
+{
+  const std::string filename = "/tmp/ros_introspection_columnar_test.bin";
+
+  ColumnarFileWriter writer;
+
+  for (int i=0; i<100; i++)
+  {
+    RenamedValues values;
+    values.push_back( std::make_pair( std::string("robot/position"), VarNumber( 0.5*i ) ));
+    values.push_back( std::make_pair( std::string("robot/counter"), VarNumber( int32_t(i) ) ));
+    if( i % 2 == 0){
+      values.push_back( std::make_pair( std::string("robot/even"), VarNumber( uint8_t(i) ) ));
+    }
+    writer.append( 1000.0 + i, values );
+  }
+  EXPECT_EQ( writer.columnCount(), 3);
+  writer.save( filename );
+
+  {
+    ColumnarFileReader reader( filename );
+    EXPECT_EQ( reader.columns().size(), 3);
+
+    const ColumnView* position = reader.column("robot/position");
+    ASSERT_TRUE( position != nullptr );
+    EXPECT_EQ( position->type(), FLOAT64 );
+    EXPECT_EQ( position->size(), 100 );
+    EXPECT_EQ( position->timestamps()[10], 1010.0 );
+    EXPECT_EQ( position->values<double>()[10], 5.0 );
+    EXPECT_THROW( position->values<float>(), TypeException );
+
+    const ColumnView* counter = reader.column("robot/counter");
+    ASSERT_TRUE( counter != nullptr );
+    EXPECT_EQ( counter->type(), INT32 );
+    EXPECT_EQ( counter->values<int32_t>()[99], 99 );
+    EXPECT_EQ( counter->value(42).convert<double>(), 42.0 );
+
+    const ColumnView* even = reader.column("robot/even");
+    ASSERT_TRUE( even != nullptr );
+    EXPECT_EQ( even->size(), 50 );
+    EXPECT_EQ( even->timestamps()[1], 1002.0 );
+    EXPECT_EQ( even->values<uint8_t>()[1], 2 );
+
+    EXPECT_TRUE( reader.column("robot/missing") == nullptr );
+  }
+  std::remove( filename.c_str() );
+}
+
+TEST(ColumnarFile, BulkNumericArrays)
+{
+  const std::string filename = "/tmp/ros_introspection_columnar_bulk_test.bin";
+
+  ROSTypeList type_map = buildROSTypeMapFromDefinition( "test_msgs/Gains", "int16[] gains\nuint8 mode\n" );
+  ROSType main_type( "test_msgs/Gains" );
+
+  ColumnarFileWriter writer;
+  ROSTypeFlat flat_container;
+  flat_container.bulk_numeric_arrays = true;
+
+  for (int i=0; i<3; i++)
+  {
+    std::vector<uint8_t> buffer = { 2,0,0,0,  uint8_t(i),0,  uint8_t(10+i),0,  7 };
+    buildRosFlatType( type_map, main_type, "msg", buffer.data(), &flat_container, 100 );
+    ASSERT_EQ( flat_container.numeric_arrays.size(), 1 );
+    writer.append( 100.0 + i, flat_container );
+  }
+  EXPECT_EQ( writer.columnCount(), 3 );
+  writer.save( filename );
+
+  {
+    ColumnarFileReader reader( filename );
+    const ColumnView* gain = reader.column("msg/gains.1");
+    ASSERT_TRUE( gain != nullptr );
+    EXPECT_EQ( gain->type(), FLOAT64 );
+    EXPECT_EQ( gain->size(), 3 );
+    EXPECT_EQ( gain->values<double>()[2], 12.0 );
+
+    const ColumnView* mode = reader.column("msg/mode");
+    ASSERT_TRUE( mode != nullptr );
+    EXPECT_EQ( mode->type(), UINT8 );
+  }
+  std::remove( filename.c_str() );
+}
+
+TEST(ColumnarFile, CharFields)
+{
+  const std::string filename = "/tmp/ros_introspection_columnar_char_test.bin";
+
+  ROSTypeList type_map = buildROSTypeMapFromDefinition( "test_msgs/Letter", "char letter\nbyte level\n" );
+  ROSType main_type( "test_msgs/Letter" );
+
+  ColumnarFileWriter writer;
+  ROSTypeFlat flat_container;
+
+  for (int i=0; i<3; i++)
+  {
+    std::vector<uint8_t> buffer = { uint8_t(200 + i), uint8_t(-1 - i) };
+    buildRosFlatType( type_map, main_type, "msg", buffer.data(), &flat_container, 100 );
+    writer.append( 100.0 + i, flat_container );
+  }
+  EXPECT_EQ( writer.columnCount(), 2 );
+  writer.save( filename );
+
+  {
+    ColumnarFileReader reader( filename );
+    const ColumnView* letter = reader.column("msg/letter");
+    ASSERT_TRUE( letter != nullptr );
+    EXPECT_EQ( letter->type(), CHAR );
+    EXPECT_EQ( letter->size(), 3 );
+    EXPECT_EQ( letter->values<char>()[1], char(201) );
+    EXPECT_EQ( letter->value(2).convert<int>(), 202 );
+
+    const ColumnView* level = reader.column("msg/level");
+    ASSERT_TRUE( level != nullptr );
+    EXPECT_EQ( level->value(2).convert<int>(), -3 );
+  }
+  std::remove( filename.c_str() );
+}
+
+TEST(ColumnarFile, InvalidFile)
+{
+  const std::string filename = "/tmp/ros_introspection_columnar_invalid.bin";
+  {
+    FILE* file = fopen( filename.c_str(), "wb");
+    const char garbage[] = "this is not a columnar file";
+    fwrite( garbage, 1, sizeof(garbage), file);
+    fclose(file);
+  }
+  EXPECT_THROW( ColumnarFileReader reader( filename ), std::runtime_error );
+  std::remove( filename.c_str() );
+}
+
+// A valid file, modified by patch, must be rejected with std::runtime_error.
+template <typename Patch>
+void ExpectCorruptFileRejected(const std::string& filename, Patch patch)
+{
+  ColumnarFileWriter writer;
+  RenamedValues values;
+  values.push_back( std::make_pair( std::string("robot/position"), VarNumber( 1.5 ) ));
+  writer.append( 1000.0, values );
+  writer.save( filename );
+
+  FILE* file = fopen( filename.c_str(), "rb" );
+  std::vector<uint8_t> data( 4096 );
+  data.resize( fread( data.data(), 1, data.size(), file ) );
+  fclose(file);
+
+  patch( data );
+  file = fopen( filename.c_str(), "wb" );
+  fwrite( data.data(), 1, data.size(), file );
+  fclose(file);
+
+  EXPECT_THROW( ColumnarFileReader reader( filename ), std::runtime_error );
+  std::remove( filename.c_str() );
+}
+
+TEST(ColumnarFile, CorruptFile)
+{
+  const std::string filename = "/tmp/ros_introspection_columnar_corrupt.bin";
+  // offsets in the file of FileHeader::column_count and of the first ColumnHeader
+  const size_t COLUMN_COUNT = 12;
+  const size_t COLUMN = 16;
+
+  // too many columns
+  ExpectCorruptFileRejected( filename, [&](std::vector<uint8_t>& data)
+  {
+    const uint32_t count = 0xFFFFFFFF;
+    memcpy( &data[COLUMN_COUNT], &count, sizeof(count) );
+  });
+  // size*sizeof(double) overflows to a small number
+  ExpectCorruptFileRejected( filename, [&](std::vector<uint8_t>& data)
+  {
+    const uint64_t size = uint64_t(1) << 61;
+    memcpy( &data[COLUMN + 8], &size, sizeof(size) );
+  });
+  // offset of the timestamps past the end of the file
+  ExpectCorruptFileRejected( filename, [&](std::vector<uint8_t>& data)
+  {
+    const uint64_t offset = ~uint64_t(0) - 7;
+    memcpy( &data[COLUMN + 16], &offset, sizeof(offset) );
+  });
+  // a type that ColumnView can't return
+  ExpectCorruptFileRejected( filename, [&](std::vector<uint8_t>& data)
+  {
+    data[COLUMN + 4] = STRING;
+  });
+  // misaligned timestamps
+  ExpectCorruptFileRejected( filename, [&](std::vector<uint8_t>& data)
+  {
+    uint64_t offset;
+    memcpy( &offset, &data[COLUMN + 16], sizeof(offset) );
+    offset -= 4;
+    memcpy( &data[COLUMN + 16], &offset, sizeof(offset) );
+  });
+}
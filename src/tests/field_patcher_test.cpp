@@ -0,0 +1,127 @@
+#include "config.h"
+#include <gtest/gtest.h>
+
+#include <ros_type_introspection/field_patcher.hpp>
+
+using namespace RosIntrospection;
+
+namespace {
+
+const char* DEFINITION =
+    "Header header\n"
+    "string[] names\n"
+    "float64 value\n"
+    "================================================================================\n"
+    "MSG: std_msgs/Header\n"
+    "uint32 seq\n"
+    "time stamp\n"
+    "string frame_id\n";
+
+std::vector<uint8_t> Serialize(uint32_t sec, const std::string& frame_id,
+                               const std::vector<std::string>& names, double value)
+{
+  std::vector<uint8_t> buffer;
+  auto append = [&buffer](const void* ptr, size_t size) {
+    buffer.insert( buffer.end(), (const uint8_t*)ptr, (const uint8_t*)ptr + size );
+  };
+  auto append_string = [&](const std::string& str) {
+    uint32_t size = str.size();
+    append( &size, 4 );
+    append( str.data(), str.size() );
+  };
+  const uint32_t seq = 7, nsec = 0, count = names.size();
+  append( &seq, 4 );
+  append( &sec, 4 );
+  append( &nsec, 4 );
+  append_string( frame_id );
+  append( &count, 4 );
+  for (const std::string& name: names) append_string( name );
+  append( &value, 8 );
+  return buffer;
+}
+
+}
+
+TEST(FieldPatcher, PatchBuffer)
+{
+  ROSTypeList type_map = buildROSTypeMapFromDefinition( "test_msgs/Named", DEFINITION );
+  ROSType main_type( "test_msgs/Named" );
+
+  std::vector<uint8_t> buffer = Serialize( 10, "base_link", {"a", "bb"}, 3.5 );
+
+  FieldPatcher stamp( type_map, main_type, "header/stamp" );
+  FieldPatcher frame_id( type_map, main_type, "header/frame_id" );
+  FieldPatcher name( type_map, main_type, "names.1" );
+  FieldPatcher value( type_map, main_type, "value" );
+
+  EXPECT_TRUE( stamp.write( buffer.data(), buffer.size(), ros::Time(20, 0) ) );
+  EXPECT_TRUE( value.write( buffer.data(), buffer.size(), 4.5 ) );
+  EXPECT_EQ( buffer, Serialize( 20, "base_link", {"a", "bb"}, 4.5 ) );
+
+  // longer, shorter and empty strings
+  EXPECT_TRUE( frame_id.writeString( &buffer, "odometry_frame" ) );
+  EXPECT_EQ( buffer, Serialize( 20, "odometry_frame", {"a", "bb"}, 4.5 ) );
+
+  EXPECT_TRUE( name.writeString( &buffer, "c" ) );
+  EXPECT_EQ( buffer, Serialize( 20, "odometry_frame", {"a", "c"}, 4.5 ) );
+
+  EXPECT_TRUE( frame_id.writeString( &buffer, "" ) );
+  EXPECT_EQ( buffer, Serialize( 20, "", {"a", "c"}, 4.5 ) );
+
+  // the array has only two elements
+  FieldPatcher missing( type_map, main_type, "names.2" );
+  EXPECT_FALSE( missing.writeString( &buffer, "d" ) );
+
+  // the type must match exactly
+  EXPECT_THROW( value.write( buffer.data(), buffer.size(), 4.5f ), TypeException );
+  EXPECT_THROW( value.writeString( &buffer, "x" ), TypeException );
+  EXPECT_THROW( stamp.write( buffer.data(), 10, ros::Time(1,0) ), RangeException );
+}
+
+TEST(FieldPatcher, PatchShapeShifter)
+{
+  ROSTypeList type_map = buildROSTypeMapFromDefinition( "test_msgs/Named", DEFINITION );
+  ROSType main_type( "test_msgs/Named" );
+
+  std::vector<uint8_t> original = Serialize( 10, "base_link", {"a"}, 1.0 );
+
+  // the borrowed buffer is copied, not modified
+  boost::shared_ptr<std::vector<uint8_t>> owner( new std::vector<uint8_t>(original) );
+  ShapeShifter msg;
+  msg.borrow( owner, owner->data(), owner->size() );
+
+  FieldPatcher stamp( type_map, main_type, "header/stamp" );
+  FieldPatcher frame_id( type_map, main_type, "header/frame_id" );
+
+  EXPECT_TRUE( stamp.write( &msg, ros::Time(30, 0) ) );
+  EXPECT_FALSE( msg.isBorrowed() );
+  EXPECT_EQ( *owner, original );
+
+  EXPECT_TRUE( frame_id.writeString( &msg, "map" ) );
+
+  std::vector<uint8_t> expected = Serialize( 30, "map", {"a"}, 1.0 );
+  ASSERT_EQ( msg.size(), expected.size() );
+  EXPECT_EQ( memcmp( msg.raw_data(), expected.data(), expected.size() ), 0 );
+}
+
+TEST(FieldPatcher, PatchByteAndChar)
+{
+  ROSTypeList type_map = buildROSTypeMapFromDefinition( "test_msgs/Flags",
+                                                        "byte level\nchar letter\n" );
+  ROSType main_type( "test_msgs/Flags" );
+
+  std::vector<uint8_t> buffer = { 1, 'a' };
+
+  FieldPatcher level( type_map, main_type, "level" );
+  FieldPatcher letter( type_map, main_type, "letter" );
+
+  EXPECT_TRUE( level.write( buffer.data(), buffer.size(), int8_t(-2) ) );
+  EXPECT_TRUE( letter.write( buffer.data(), buffer.size(), uint8_t('b') ) );
+  EXPECT_EQ( buffer, std::vector<uint8_t>({ 0xFE, 'b' }) );
+
+  EXPECT_TRUE( letter.write( buffer.data(), buffer.size(), 'c' ) );
+  EXPECT_EQ( buffer[1], 'c' );
+
+  EXPECT_THROW( level.write( buffer.data(), buffer.size(), uint8_t(2) ), TypeException );
+  EXPECT_THROW( letter.write( buffer.data(), buffer.size(), int16_t(2) ), TypeException );
+}
@@ -0,0 +1,206 @@
+// Decoder of test_msgs/Generated, generated by ros_introspection_codegen.
+// Do not edit: generate it again if the definition of the message changes.
+
+#ifndef ROS_INTROSPECTION_GENERATED_TEST_MSGS_GENERATED_H
+#define ROS_INTROSPECTION_GENERATED_TEST_MSGS_GENERATED_H
+
+#include <ros_type_introspection/decoder_registry.hpp>
+
+namespace RosIntrospection{
+namespace generated{
+namespace test_msgs_Generated{
+
+const char MD5SUM[] = "0123456789abcdef0123456789abcdef";
+const char DATATYPE[] = "test_msgs/Generated";
+
+// skip std_msgs/Header
+inline const uint8_t* skip_1(const uint8_t* ptr)
+{
+  using namespace GeneratedCode;
+  ptr += 12;
+  ptr = skipString( ptr ); // frame_id
+  return ptr;
+}
+
+// skip test_msgs/Point
+inline const uint8_t* skip_2(const uint8_t* ptr)
+{
+  using namespace GeneratedCode;
+  ptr = skipString( ptr ); // label
+  return ptr + 16;
+}
+
+inline void decode(const ROSTypeList& type_list,
+                   SString prefix,
+                   uint8_t* buffer_ptr,
+                   ROSTypeFlat* flat,
+                   const uint32_t max_array_size)
+{
+  using namespace GeneratedCode;
+  static const ROSType type( DATATYPE );
+  buildFlatTree( type_list, type, prefix, flat );
+  flat->name.clear();
+  flat->value.clear();
+  flat->numeric_arrays.clear();
+  flat->array_values.clear();
+  flat->skipped_arrays = 0;
+
+  const uint8_t* ptr = buffer_ptr;
+  StringTreeNode* n = flat->tree.root();
+  StringTreeLeaf leaf0;
+  leaf0.node_ptr = n;
+
+  StringTreeNode* n0 = &n->children()[0]; // header
+  StringTreeNode* n1 = &n0->children()[0]; // seq
+  flat->value.emplace_back( leaf(leaf0, n1), VarNumber( load<uint32_t>( ptr ) ) );
+  StringTreeNode* n2 = &n0->children()[1]; // stamp
+  flat->value.emplace_back( leaf(leaf0, n2), VarNumber( loadTime( ptr + 4 ) ) );
+  StringTreeNode* n3 = &n0->children()[2]; // frame_id
+  ptr += 12;
+  ptr = storeString( ptr, leaf(leaf0, n3), flat );
+  StringTreeNode* n4 = &n->children()[1]; // mode
+  flat->value.emplace_back( leaf(leaf0, n4), VarNumber( load<uint8_t>( ptr ) ) );
+  StringTreeNode* n5 = &n->children()[2]; // names
+  StringTreeNode* e6 = &n5->children()[0];
+  StringTreeLeaf l7 = leaf0;
+  l7.array_size++;
+  ptr += 1;
+  const uint32_t c8 = load<uint32_t>( ptr );
+  ptr += 4;
+  if( c8 <= max_array_size )
+  {
+    for (uint32_t i9=0; i9 < c8; i9++)
+    {
+      l7.index_array[0] = i9;
+      ptr = storeString( ptr, leaf(l7, e6), flat );
+    }
+  }
+  else{
+    flat->skipped_arrays++;
+    for (uint32_t i10=0; i10 < c8; i10++)
+    {
+      ptr = skipString( ptr );
+    }
+  }
+  StringTreeNode* n11 = &n->children()[3]; // points
+  StringTreeNode* e12 = &n11->children()[0];
+  StringTreeLeaf l13 = leaf0;
+  l13.array_size++;
+  const uint32_t c14 = load<uint32_t>( ptr );
+  ptr += 4;
+  if( c14 <= max_array_size )
+  {
+    for (uint32_t i15=0; i15 < c14; i15++)
+    {
+      l13.index_array[0] = i15;
+      StringTreeNode* n16 = &e12->children()[0]; // label
+      ptr = storeString( ptr, leaf(l13, n16), flat );
+      StringTreeNode* n17 = &e12->children()[1]; // x
+      flat->value.emplace_back( leaf(l13, n17), VarNumber( load<double>( ptr ) ) );
+      StringTreeNode* n18 = &e12->children()[2]; // y
+      flat->value.emplace_back( leaf(l13, n18), VarNumber( load<double>( ptr + 8 ) ) );
+      ptr += 16;
+    }
+  }
+  else{
+    flat->skipped_arrays++;
+    for (uint32_t i19=0; i19 < c14; i19++)
+    {
+      ptr = skip_2( ptr );
+    }
+  }
+  StringTreeNode* n20 = &n->children()[4]; // origin
+  StringTreeNode* n21 = &n20->children()[0]; // label
+  ptr = storeString( ptr, leaf(leaf0, n21), flat );
+  StringTreeNode* n22 = &n20->children()[1]; // x
+  flat->value.emplace_back( leaf(leaf0, n22), VarNumber( load<double>( ptr ) ) );
+  StringTreeNode* n23 = &n20->children()[2]; // y
+  flat->value.emplace_back( leaf(leaf0, n23), VarNumber( load<double>( ptr + 8 ) ) );
+  StringTreeNode* n24 = &n->children()[5]; // corners
+  StringTreeNode* e25 = &n24->children()[0];
+  StringTreeLeaf l26 = leaf0;
+  l26.array_size++;
+  if( 3 <= max_array_size )
+  {
+    l26.index_array[0] = 0;
+    StringTreeNode* n27 = &e25->children()[0]; // x
+    flat->value.emplace_back( leaf(l26, n27), VarNumber( load<float>( ptr + 16 ) ) );
+    StringTreeNode* n28 = &e25->children()[1]; // y
+    flat->value.emplace_back( leaf(l26, n28), VarNumber( load<float>( ptr + 20 ) ) );
+    l26.index_array[0] = 1;
+    StringTreeNode* n29 = &e25->children()[0]; // x
+    flat->value.emplace_back( leaf(l26, n29), VarNumber( load<float>( ptr + 24 ) ) );
+    StringTreeNode* n30 = &e25->children()[1]; // y
+    flat->value.emplace_back( leaf(l26, n30), VarNumber( load<float>( ptr + 28 ) ) );
+    l26.index_array[0] = 2;
+    StringTreeNode* n31 = &e25->children()[0]; // x
+    flat->value.emplace_back( leaf(l26, n31), VarNumber( load<float>( ptr + 32 ) ) );
+    StringTreeNode* n32 = &e25->children()[1]; // y
+    flat->value.emplace_back( leaf(l26, n32), VarNumber( load<float>( ptr + 36 ) ) );
+  }
+  else{
+    flat->skipped_arrays++;
+  }
+  StringTreeNode* n33 = &n->children()[6]; // gains
+  StringTreeNode* e34 = &n33->children()[0];
+  StringTreeLeaf l35 = leaf0;
+  l35.array_size++;
+  if( 4 <= max_array_size )
+  {
+    if( flat->bulk_numeric_arrays )
+    {
+      l35.index_array[0] = 0;
+      appendNumericArray( leaf(l35, e34), INT16, 4, ptr + 40, flat );
+    }
+    else{
+      l35.index_array[0] = 0;
+      flat->value.emplace_back( leaf(l35, e34), VarNumber( load<int16_t>( ptr + 40 ) ) );
+      l35.index_array[0] = 1;
+      flat->value.emplace_back( leaf(l35, e34), VarNumber( load<int16_t>( ptr + 42 ) ) );
+      l35.index_array[0] = 2;
+      flat->value.emplace_back( leaf(l35, e34), VarNumber( load<int16_t>( ptr + 44 ) ) );
+      l35.index_array[0] = 3;
+      flat->value.emplace_back( leaf(l35, e34), VarNumber( load<int16_t>( ptr + 46 ) ) );
+    }
+  }
+  else{
+    flat->skipped_arrays++;
+  }
+  StringTreeNode* n36 = &n->children()[7]; // values
+  StringTreeNode* e37 = &n36->children()[0];
+  StringTreeLeaf l38 = leaf0;
+  l38.array_size++;
+  ptr += 48;
+  const uint32_t c39 = load<uint32_t>( ptr );
+  ptr += 4;
+  if( c39 <= max_array_size )
+  {
+    if( flat->bulk_numeric_arrays )
+    {
+      l38.index_array[0] = 0;
+      ptr = appendNumericArray( leaf(l38, e37), FLOAT64, c39, ptr, flat );
+    }
+    else{
+      for (uint32_t i40=0; i40 < c39; i40++)
+      {
+        l38.index_array[0] = i40;
+        flat->value.emplace_back( leaf(l38, e37), VarNumber( load<double>( ptr ) ) );
+        ptr += 8;
+      }
+    }
+  }
+  else{
+    flat->skipped_arrays++;
+    ptr += size_t(c39) * 8;
+  }
+  StringTreeNode* n41 = &n->children()[8]; // timeout
+  flat->value.emplace_back( leaf(leaf0, n41), VarNumber( loadTime( ptr ) ) );
+}
+
+static const DecoderRegistration registration( MD5SUM, DATATYPE, &decode );
+
+} // end namespace test_msgs_Generated
+} // end namespace generated
+} // end namespace RosIntrospection
+
+#endif // ROS_INTROSPECTION_GENERATED_TEST_MSGS_GENERATED_H
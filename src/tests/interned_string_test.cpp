@@ -0,0 +1,107 @@
+#include "config.h"
+#include <gtest/gtest.h>
+
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <ros_type_introspection/renamer.hpp>
+
+using namespace RosIntrospection;
+
+TEST(InternedString, Equality)
+{
+  const size_t initial_size = StringPool::global().size();
+
+  InternedString a( "interned_test_frame" );
+  InternedString b( std::string("interned_test_frame") );
+  InternedString c( SString("interned_test_other") );
+
+  EXPECT_EQ( a, b );
+  EXPECT_EQ( a.data(), b.data() ); // same entry
+  EXPECT_NE( a, c );
+  EXPECT_EQ( a.hash(), b.hash() );
+  EXPECT_EQ( StringPool::global().size(), initial_size + 2 );
+
+  EXPECT_TRUE( a == SString("interned_test_frame") );
+  EXPECT_TRUE( a == "interned_test_frame" );
+  EXPECT_TRUE( a != "interned_test" );
+  EXPECT_EQ( a.toStdString(), "interned_test_frame" );
+
+  InternedString empty;
+  EXPECT_TRUE( empty.empty() );
+  EXPECT_EQ( empty, InternedString("") );
+
+  std::unordered_set<InternedString> set = { a, b, c };
+  EXPECT_EQ( set.size(), 2 );
+}
+
+TEST(InternedString, ConcurrentIntern)
+{
+  std::vector<std::thread> threads;
+  std::vector<std::vector<InternedString>> results(4);
+  for (size_t t=0; t<results.size(); t++)
+  {
+    threads.push_back( std::thread( [t, &results]()
+    {
+      for (int i=0; i<500; i++)
+      {
+        results[t].push_back( InternedString( "concurrent_" + std::to_string(i) ) );
+      }
+    }));
+  }
+  for (auto& thread: threads) thread.join();
+
+  for (size_t t=1; t<results.size(); t++)
+  {
+    EXPECT_EQ( results[t], results[0] );
+  }
+}
+
+TEST(InternedString, FieldNamesAreShared)
+{
+  ROSField field( "float64 interned_position" );
+  ROSField other( "int32 interned_position" );
+  EXPECT_EQ( field.internedName(), other.internedName() );
+  EXPECT_EQ( field.name(), SString("interned_position") );
+
+  SubstitutionRule rule( "interned_position.#", "name.#", "@.pos" );
+  ASSERT_EQ( rule.pattern().size(), 2 );
+  EXPECT_EQ( rule.pattern()[0], field.internedName() );
+  EXPECT_EQ( rule.pattern()[1], arrayNodeName() );
+}
+
+TEST(StringHash, Consistency)
+{
+  // lengths that cover all the branches of hashBytes
+  std::string text;
+  std::unordered_set<size_t> hashes;
+  for (int length=0; length<130; length++)
+  {
+    const SString str( text );
+    const size_t hash = std::hash<SString>()( str );
+    EXPECT_EQ( hash, hashString( text.data(), text.size() ) );
+    EXPECT_EQ( hash, HashedString( str ).hash() );
+    EXPECT_EQ( hash, InternedString( str ).hash() );
+    hashes.insert( hash );
+    text.push_back( static_cast<char>('a' + length % 26) );
+  }
+  EXPECT_EQ( hashes.size(), 130 );
+
+  // a single different character changes the hash
+  EXPECT_NE( std::hash<SString>()( SString("position_x") ),
+             std::hash<SString>()( SString("position_y") ) );
+}
+
+TEST(StringHash, UnorderedMap)
+{
+  std::unordered_map<SString, int> map;
+  map[ SString("frame_id") ] = 1;
+  map[ SString("a_rather_long_name_that_does_not_fit_in_the_small_buffer") ] = 2;
+  EXPECT_EQ( map.at( SString("frame_id") ), 1 );
+  EXPECT_EQ( map.at( SString("a_rather_long_name_that_does_not_fit_in_the_small_buffer") ), 2 );
+
+  std::unordered_map<HashedString, int> hashed;
+  hashed[ "joint_states/position" ] = 3;
+  EXPECT_EQ( hashed.count( HashedString("joint_states/position") ), 1 );
+  EXPECT_EQ( hashed.count( HashedString("joint_states/velocity") ), 0 );
+}
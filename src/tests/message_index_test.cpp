@@ -0,0 +1,224 @@
+#include "config.h"
+#include <gtest/gtest.h>
+
+#include <ros_type_introspection/message_index.hpp>
+#include "synthetic_generator.hpp"
+
+using namespace RosIntrospection;
+
+namespace {
+
+const char* DEFINITION =
+    "Header header\n"
+    "string[] names\n"
+    "float64[] position\n"
+    "================================================================================\n"
+    "MSG: std_msgs/Header\n"
+    "uint32 seq\n"
+    "time stamp\n"
+    "string frame_id\n";
+
+std::vector<uint8_t> Serialize(uint32_t seq, const std::string& frame_id,
+                               const std::vector<std::string>& names,
+                               const std::vector<double>& position)
+{
+  std::vector<uint8_t> buffer;
+  auto append = [&buffer](const void* ptr, size_t size) {
+    buffer.insert( buffer.end(), (const uint8_t*)ptr, (const uint8_t*)ptr + size );
+  };
+  auto append_string = [&](const std::string& str) {
+    uint32_t size = str.size();
+    append( &size, 4 );
+    append( str.data(), str.size() );
+  };
+  const uint32_t sec = 10, nsec = 20;
+  append( &seq, 4 );
+  append( &sec, 4 );
+  append( &nsec, 4 );
+  append_string( frame_id );
+  uint32_t count = names.size();
+  append( &count, 4 );
+  for (const std::string& name: names) append_string( name );
+  count = position.size();
+  append( &count, 4 );
+  for (double value: position) append( &value, 8 );
+  return buffer;
+}
+
+}
+
+TEST(MessageIndex, ReadFields)
+{
+  ROSTypeList type_map = buildROSTypeMapFromDefinition( "test_msgs/Joints", DEFINITION );
+  MessageIndex index( type_map, ROSType("test_msgs/Joints") );
+
+  std::vector<uint8_t> buffer = Serialize( 7, "base_link", {"a", "bb"}, {1.5, 2.5} );
+  index.build( buffer.data(), buffer.size() );
+  EXPECT_EQ( index.messageSize(), buffer.size() );
+
+  VarNumber value;
+  boost::string_ref str;
+  EXPECT_TRUE( index.getValue( "header/seq", &value ) );
+  EXPECT_EQ( value.convert<uint32_t>(), 7 );
+  EXPECT_TRUE( index.getValue( "header/stamp", &value ) );
+  EXPECT_EQ( value.extract<ros::Time>(), ros::Time(10, 20) );
+  EXPECT_TRUE( index.getString( "header/frame_id", &str ) );
+  EXPECT_EQ( str, "base_link" );
+  EXPECT_TRUE( index.getString( "names.1", &str ) );
+  EXPECT_EQ( str, "bb" );
+  EXPECT_TRUE( index.getValue( "position.1", &value ) );
+  EXPECT_EQ( value.convert<double>(), 2.5 );
+
+  EXPECT_EQ( index.getArraySize( "names" ), 2 );
+  EXPECT_EQ( index.getOffset( "header/frame_id" ), 12 );
+  // after the length of the array
+  EXPECT_EQ( index.getOffset( "names" ), 12 + 13 + 4 );
+
+  // index out of range
+  EXPECT_FALSE( index.getValue( "position.2", &value ) );
+  EXPECT_FALSE( index.getString( "names.5", &str ) );
+  EXPECT_EQ( index.getOffset( "names.5" ), -1 );
+  EXPECT_FALSE( index.getValue( "position.123456789012345678901234567890", &value ) );
+
+  EXPECT_THROW( index.getValue( "header/frame", &value ), std::runtime_error );
+  EXPECT_THROW( index.getValue( "position", &value ), TypeException );
+  EXPECT_THROW( index.getValue( "header/frame_id", &value ), TypeException );
+  EXPECT_THROW( index.getString( "header/seq", &str ), TypeException );
+  EXPECT_THROW( index.getValue( "header/seq/x", &value ), std::runtime_error );
+  EXPECT_THROW( index.getValue( "header.1/seq", &value ), std::runtime_error );
+  EXPECT_THROW( index.getValue( "position.1x", &value ), std::runtime_error );
+  EXPECT_THROW( index.getValue( "position.", &value ), std::runtime_error );
+}
+
+TEST(MessageIndex, FixedSizeMessages)
+{
+  const char* definition =
+      "Pose[] poses\n"
+      "Point[2] corners\n"
+      "================================================================================\n"
+      "MSG: test_msgs/Pose\n"
+      "Point position\n"
+      "float64 w\n"
+      "================================================================================\n"
+      "MSG: test_msgs/Point\n"
+      "float32 x\n"
+      "float32 y\n";
+
+  ROSTypeList type_map = buildROSTypeMapFromDefinition( "test_msgs/Poses", definition );
+  MessageIndex index( type_map, ROSType("test_msgs/Poses") );
+
+  std::vector<uint8_t> buffer;
+  auto append = [&buffer](const void* ptr, size_t size) {
+    buffer.insert( buffer.end(), (const uint8_t*)ptr, (const uint8_t*)ptr + size );
+  };
+  const uint32_t count = 3;
+  append( &count, 4 );
+  for (int i=0; i<3; i++)
+  {
+    const float x = i, y = 10 + i;
+    const double w = 100 + i;
+    append( &x, 4 );
+    append( &y, 4 );
+    append( &w, 8 );
+  }
+  for (int i=0; i<2; i++)
+  {
+    const float x = 20 + i, y = 30 + i;
+    append( &x, 4 );
+    append( &y, 4 );
+  }
+  index.build( buffer.data(), buffer.size() );
+  EXPECT_EQ( index.messageSize(), buffer.size() );
+
+  VarNumber value;
+  EXPECT_TRUE( index.getValue( "poses.2/position/y", &value ) );
+  EXPECT_EQ( value.convert<double>(), 12 );
+  EXPECT_TRUE( index.getValue( "poses.1/w", &value ) );
+  EXPECT_EQ( value.convert<double>(), 101 );
+  EXPECT_TRUE( index.getValue( "corners.1/x", &value ) );
+  EXPECT_EQ( value.convert<double>(), 21 );
+
+  EXPECT_EQ( index.getOffset( "poses.1/position/y" ), 4 + 16 + 4 );
+  EXPECT_EQ( index.getOffset( "corners.1" ), 4 + 3*16 + 8 );
+  EXPECT_EQ( index.getArraySize( "poses" ), 3 );
+  EXPECT_EQ( index.getArraySize( "corners" ), 2 );
+
+  EXPECT_FALSE( index.getValue( "poses.3/position/x", &value ) );
+  EXPECT_THROW( index.getValue( "poses.3/position/z", &value ), std::runtime_error );
+}
+
+TEST(MessageIndex, Rebind)
+{
+  ROSTypeList type_map = buildROSTypeMapFromDefinition( "test_msgs/Joints", DEFINITION );
+  MessageIndex index( type_map, ROSType("test_msgs/Joints") );
+
+  std::vector<uint8_t> first = Serialize( 1, "base_link", {"a", "bb"}, {1.5, 2.5} );
+  index.build( first.data(), first.size() );
+
+  // same lengths, different values
+  std::vector<uint8_t> second = Serialize( 2, "odom_link", {"c", "dd"}, {3.5, 4.5} );
+  EXPECT_TRUE( index.rebind( second.data(), second.size() ) );
+
+  VarNumber value;
+  boost::string_ref str;
+  EXPECT_TRUE( index.getValue( "header/seq", &value ) );
+  EXPECT_EQ( value.convert<int>(), 2 );
+  EXPECT_TRUE( index.getString( "names.1", &str ) );
+  EXPECT_EQ( str, "dd" );
+  EXPECT_TRUE( index.getValue( "position.0", &value ) );
+  EXPECT_EQ( value.convert<double>(), 3.5 );
+
+  // a string with a different length: the index still refers to the second message
+  std::vector<uint8_t> third = Serialize( 3, "map", {"c", "dd"}, {3.5, 4.5} );
+  EXPECT_FALSE( index.rebind( third.data(), third.size() ) );
+  // a different number of elements
+  std::vector<uint8_t> fourth = Serialize( 4, "odom_link", {"c", "dd"}, {3.5} );
+  EXPECT_FALSE( index.rebind( fourth.data(), fourth.size() ) );
+
+  EXPECT_TRUE( index.getValue( "header/seq", &value ) );
+  EXPECT_EQ( value.convert<int>(), 2 );
+
+  index.build( third.data(), third.size() );
+  EXPECT_TRUE( index.getString( "header/frame_id", &str ) );
+  EXPECT_EQ( str, "map" );
+
+  // truncated message
+  EXPECT_THROW( index.build( third.data(), third.size() - 1 ), RangeException );
+}
+
+TEST(MessageIndex, SyntheticMessages)
+{
+  for (unsigned seed=0; seed < 20; seed++)
+  {
+    SyntheticOptions options;
+    options.depth = 4;
+    options.max_array_nesting = 3;
+    options.array_probability = 0.3;
+    options.seed = seed;
+    SyntheticMessage msg = SyntheticGenerator::generate( options, "msg" );
+
+    ROSTypeList type_map = buildROSTypeMapFromDefinition( msg.datatype, msg.definition );
+    MessageIndex index( type_map, ROSType(msg.datatype) );
+    index.build( msg.buffer.data(), msg.buffer.size() );
+    EXPECT_EQ( index.messageSize(), msg.buffer.size() );
+
+    for (const auto& expected: msg.values)
+    {
+      VarNumber value;
+      const std::string path = expected.first.substr( 4 ); // skip "msg/"
+      ASSERT_TRUE( index.getValue( path, &value ) ) << path;
+      EXPECT_EQ( value.convert<double>(), expected.second ) << path;
+    }
+    for (const auto& expected: msg.strings)
+    {
+      boost::string_ref str;
+      const std::string path = expected.first.substr( 4 );
+      ASSERT_TRUE( index.getString( path, &str ) ) << path;
+      EXPECT_EQ( str.to_string(), expected.second ) << path;
+    }
+
+    // the same message is always compatible
+    std::vector<uint8_t> copy = msg.buffer;
+    EXPECT_TRUE( index.rebind( copy.data(), copy.size() ) );
+  }
+}
@@ -0,0 +1,163 @@
+#include "config.h"
+#include <gtest/gtest.h>
+
+#include <ros_type_introspection/message_view.hpp>
+#include <ros_type_introspection/schema.hpp>
+#include "synthetic_generator.hpp"
+
+using namespace RosIntrospection;
+
+namespace {
+
+const char* DEFINITION =
+    "Header header\n"
+    "string[] names\n"
+    "Point[] points\n"
+    "Point origin\n"
+    "float64[2] range\n"
+    "================================================================================\n"
+    "MSG: std_msgs/Header\n"
+    "uint32 seq\n"
+    "time stamp\n"
+    "string frame_id\n"
+    "================================================================================\n"
+    "MSG: test_msgs/Point\n"
+    "string label\n"
+    "float64 x\n"
+    "float64 y\n";
+
+struct Writer
+{
+  std::vector<uint8_t> buffer;
+  template <typename T> void add(T value)
+  {
+    buffer.insert( buffer.end(), (const uint8_t*)&value, (const uint8_t*)&value + sizeof(T) );
+  }
+  void add(const std::string& str)
+  {
+    add<uint32_t>( str.size() );
+    buffer.insert( buffer.end(), str.begin(), str.end() );
+  }
+};
+
+std::vector<uint8_t> Serialize()
+{
+  Writer writer;
+  writer.add<uint32_t>( 7 );
+  writer.add<uint32_t>( 10 );
+  writer.add<uint32_t>( 20 );
+  writer.add( std::string("base_link") );
+  writer.add<uint32_t>( 2 );
+  writer.add( std::string("first") );
+  writer.add( std::string("second") );
+  writer.add<uint32_t>( 3 );
+  for (int i=0; i<3; i++)
+  {
+    writer.add( "point_" + std::to_string(i) );
+    writer.add<double>( i );
+    writer.add<double>( 10*i );
+  }
+  writer.add( std::string("origin") );
+  writer.add<double>( -1 );
+  writer.add<double>( -2 );
+  writer.add<double>( 0.5 );
+  writer.add<double>( 1.5 );
+  return writer.buffer;
+}
+
+// Follow a path with the syntax of StringTreeLeaf::toStr, such as "a/b.2/c"
+MessageView::Field Navigate(const MessageView& view, const std::string& path)
+{
+  MessageView::Field field = view.root();
+  size_t start = 0;
+  while( start <= path.size() )
+  {
+    size_t end = path.find('/', start);
+    if( end == std::string::npos ) end = path.size();
+    std::string name = path.substr(start, end - start);
+    start = end + 1;
+
+    const size_t dot = name.find('.');
+    if( dot == std::string::npos ) {
+      field = field[name];
+    }
+    else{
+      field = field[ name.substr(0, dot) ][ std::stoul( name.substr(dot+1) ) ];
+    }
+  }
+  return field;
+}
+
+}
+
+TEST(MessageView, ReadFields)
+{
+  MessageSchema schema( "md5", "test_msgs/Points", DEFINITION );
+  const std::vector<uint8_t> buffer = Serialize();
+  MessageView view( schema, buffer.data(), buffer.size() );
+
+  EXPECT_EQ( view["header"]["seq"].as<int>(), 7 );
+  EXPECT_EQ( view["header"]["stamp"].as<ros::Time>(), ros::Time(10, 20) );
+  EXPECT_EQ( view["header"]["frame_id"].as<std::string>(), "base_link" );
+  EXPECT_EQ( view["names"].size(), 2 );
+  EXPECT_EQ( view["names"][1].as<boost::string_ref>(), "second" );
+  EXPECT_EQ( view["points"].size(), 3 );
+  EXPECT_EQ( view["points"][2]["label"].as<std::string>(), "point_2" );
+  EXPECT_EQ( view["points"][2]["y"].as<double>(), 20 );
+  EXPECT_EQ( view["points"][1]["x"].as<float>(), 1 );
+  EXPECT_EQ( view["origin"]["label"].as<std::string>(), "origin" );
+  EXPECT_EQ( view["origin"]["y"].as<double>(), -2 );
+  EXPECT_EQ( view["range"].size(), 2 );
+  EXPECT_EQ( view["range"][1].as<double>(), 1.5 );
+
+  // the view is read in any order, many times
+  EXPECT_EQ( view["points"][0]["label"].as<std::string>(), "point_0" );
+  EXPECT_EQ( view["header"]["seq"].as<int>(), 7 );
+
+  EXPECT_TRUE( view["points"].isArray() );
+  EXPECT_TRUE( view["points"][0].isMessage() );
+  EXPECT_FALSE( view["points"][0]["x"].isMessage() );
+  EXPECT_EQ( view["header"]["frame_id"].offset(), 12 );
+
+  EXPECT_THROW( view["header"]["missing"], std::runtime_error );
+  EXPECT_THROW( view["names"]["x"], std::runtime_error );
+  EXPECT_THROW( view["names"][2], RangeException );
+  EXPECT_THROW( view["header"]["seq"][0], std::runtime_error );
+  EXPECT_THROW( view["header"]["seq"].as<std::string>(), TypeException );
+  EXPECT_THROW( view["names"][0].as<double>(), TypeException );
+  EXPECT_THROW( view["points"].as<double>(), TypeException );
+
+  // truncated message
+  MessageView truncated( schema, buffer.data(), buffer.size() - 1 );
+  EXPECT_EQ( truncated["points"][0]["x"].as<double>(), 0 );
+  EXPECT_THROW( truncated["range"][1].as<double>(), RangeException );
+}
+
+TEST(MessageView, SyntheticMessages)
+{
+  for (unsigned seed=0; seed < 20; seed++)
+  {
+    SyntheticOptions options;
+    options.depth = 4;
+    options.max_array_nesting = 3;
+    options.array_probability = 0.3;
+    options.seed = seed;
+    SyntheticMessage msg = SyntheticGenerator::generate( options, "msg" );
+
+    ROSTypeList type_map = buildROSTypeMapFromDefinition( msg.datatype, msg.definition );
+    ViewLayout layout( type_map, ROSType(msg.datatype) );
+    MessageView view( layout, msg.buffer.data(), msg.buffer.size() );
+
+    // read the fields backward, to exercise the memoization
+    for (auto it = msg.values.rbegin(); it != msg.values.rend(); ++it)
+    {
+      const std::string path = it->first.substr( 4 ); // skip "msg/"
+      EXPECT_EQ( Navigate( view, path ).as<double>(), it->second ) << path;
+    }
+    for (auto it = msg.strings.rbegin(); it != msg.strings.rend(); ++it)
+    {
+      const std::string path = it->first.substr( 4 );
+      EXPECT_EQ( Navigate( view, path ).as<std::string>(), it->second ) << path;
+    }
+  }
+}
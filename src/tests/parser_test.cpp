@@ -49,6 +49,15 @@ TEST(RosType, builtin_fixedlen_array)
   EXPECT_EQ(f.typeSize(),  8);
 }
 
+TEST(RosType, builtin_single_element_array)
+{
+  ROSType f("int32[1]");
+
+  EXPECT_EQ(f.msgName(),  "int32");
+  EXPECT_EQ(f.isArray(),  true);
+  EXPECT_EQ(f.arraySize(),  1);
+}
+
 
 TEST(RosType, no_builtin_array)
 {
@@ -355,6 +364,210 @@ TEST(buildROSTypeMapFromDefinition,  Int16MultiArrayParsing )
 
 }
 
+TEST(ROSTypeList, FindAndFieldIndex)
+{
+  // many types, some with the same msgName in different packages
+  std::string definition = "Header header\nmsgs_a/Value a\nmsgs_b/Value b\n";
+  const int COUNT = 200;
+  for (int i=0; i<COUNT; i++) {
+    definition += "Type" + std::to_string(i) + " child_" + std::to_string(i) + "\n";
+  }
+  definition += "================================================================================\n"
+                "MSG: std_msgs/Header\nuint32 seq\ntime stamp\nstring frame_id\n"
+                "================================================================================\n"
+                "MSG: msgs_a/Value\nfloat64 x\n"
+                "================================================================================\n"
+                "MSG: msgs_b/Value\nint32 y\n";
+  for (int i=0; i<COUNT; i++) {
+    definition += "================================================================================\n"
+                  "MSG: test_msgs/Type" + std::to_string(i) + "\nint32 VALUE=1\nuint8 value_" + std::to_string(i) + "\n";
+  }
+
+  ROSTypeList type_list = buildROSTypeMapFromDefinition( "test_msgs/Aggregate", definition );
+  ASSERT_EQ( type_list.size(), COUNT + 4 );
+
+  // the package is added by the parser
+  const ROSMessage& root = type_list.front();
+  EXPECT_EQ( root.field(0).type().baseName(), "std_msgs/Header" );
+  EXPECT_EQ( root.field(3 + COUNT - 1).type().baseName(), "test_msgs/Type199" );
+
+  for (const ROSMessage& msg: type_list)
+  {
+    EXPECT_EQ( type_list.find( msg.type() ), &msg );
+  }
+  const ROSMessage* value_b = type_list.find( ROSType("msgs_b/Value") );
+  ASSERT_TRUE( value_b != nullptr );
+  EXPECT_EQ( value_b->field(0).name(), "y" );
+  EXPECT_EQ( type_list.findByMsgName( ROSType("Value") ), &type_list[2] );
+  EXPECT_TRUE( type_list.find( ROSType("msgs_c/Value") ) == nullptr );
+  EXPECT_TRUE( type_list.find( ROSType("test_msgs/Type200") ) == nullptr );
+
+  EXPECT_EQ( root.fieldIndex("child_150"), 153 );
+  EXPECT_EQ( root.field("child_150"), &root.field(153) );
+  EXPECT_TRUE( root.field("child_200") == nullptr );
+  EXPECT_EQ( type_list.find( ROSType("test_msgs/Type7") )->fieldIndex("VALUE"), 0 );
+
+  // after adding elements without buildIndex, it falls back to a linear search
+  ROSTypeList copy = type_list;
+  copy.push_back( ROSMessage("MSG: msgs_c/Value\nint8 z\n") );
+  ASSERT_TRUE( copy.find( ROSType("msgs_c/Value") ) != nullptr );
+  EXPECT_EQ( copy.find( ROSType("msgs_c/Value") ), &copy.back() );
+  copy.buildIndex();
+  EXPECT_EQ( copy.find( ROSType("msgs_c/Value") ), &copy.back() );
+  EXPECT_EQ( copy.find( ROSType("msgs_a/Value") ), &copy[2] );
+}
+
+TEST(ROSTypeList, LinkedFields)
+{
+  const char* definition =
+      "Header header\n"
+      "Point[] points\n"
+      "float64 value\n"
+      "================================================================================\n"
+      "MSG: std_msgs/Header\n"
+      "uint32 seq\n"
+      "time stamp\n"
+      "string frame_id\n"
+      "================================================================================\n"
+      "MSG: test_msgs/Point\n"
+      "float64 x\n";
+
+  ROSTypeList type_list = buildROSTypeMapFromDefinition( "test_msgs/Points", definition );
+  const ROSMessage& root = type_list.front();
+  EXPECT_EQ( root.field(0).messageIndex(), 1 );
+  EXPECT_EQ( root.field(1).messageIndex(), 2 );
+  EXPECT_EQ( root.field(2).messageIndex(), -1 );
+  EXPECT_EQ( type_list.find( root.field(1) ), &type_list[2] );
+  EXPECT_TRUE( type_list.find( root.field(2) ) == nullptr );
+
+  // buildIndex() links the fields again after a change of the list:
+  // a type with the same name, but a different package, replaces the linked one
+  ROSTypeList modified = type_list;
+  modified[2].mutateType( ROSType("other_msgs/Point") );
+  modified.buildIndex();
+  EXPECT_EQ( modified.front().field(1).messageIndex(), -1 );
+  EXPECT_TRUE( modified.find( modified.front().field(1) ) == nullptr );
+
+  modified.push_back( type_list[2] );
+  modified.buildIndex();
+  EXPECT_EQ( modified.front().field(1).messageIndex(), 3 );
+  EXPECT_EQ( modified.find( modified.front().field(1) ), &modified.back() );
+  EXPECT_EQ( modified.find( modified.front().field(0) ), &modified[1] );
+
+  // the missing types are detected by the parser
+  const std::string missing = std::string(definition) +
+      "================================================================================\n"
+      "MSG: test_msgs/Other\n"
+      "test_msgs/Missing value\n";
+  try{
+    buildROSTypeMapFromDefinition( "test_msgs/Points", missing );
+    FAIL() << "the missing type wasn't detected";
+  }
+  catch( std::runtime_error& err )
+  {
+    EXPECT_EQ( std::string(err.what()),
+               "can't deserialize this stuff: test_msgs/Missing\n\n"
+               "Available types are: \n\n"
+               "   test_msgs/Points\n"
+               "   std_msgs/Header\n"
+               "   test_msgs/Point\n"
+               "   test_msgs/Other\n" );
+  }
+}
+
+TEST(ROSMessage, TypedConstants)
+{
+  const char* definition =
+      "byte OK=0\n"
+      "byte WARN=1  # comment\n"
+      "byte ERROR=2\n"
+      "byte level\n"
+      "string name\n"
+      "uint64 BIG=18446744073709551615\n"
+      "int16 NEGATIVE=-300\n"
+      "float32 RATIO=0.5\n"
+      "bool ENABLED=True\n"
+      "string LABEL=not a number # 42\n";
+
+  ROSTypeList type_list = buildROSTypeMapFromDefinition( "test_msgs/Status", definition );
+  const ROSMessage& msg = type_list.front();
+
+  ASSERT_EQ( msg.constants().size(), 8 );
+  EXPECT_EQ( msg.field( msg.constants()[1] ).name(), "WARN" );
+
+  const ROSField* big = msg.field("BIG");
+  EXPECT_EQ( big->numericValue().getTypeID(), UINT64 );
+  EXPECT_EQ( big->numericValue().extract<uint64_t>(), 18446744073709551615ull );
+  EXPECT_EQ( msg.field("NEGATIVE")->numericValue().extract<int16_t>(), -300 );
+  EXPECT_EQ( msg.field("RATIO")->numericValue().extract<float>(), 0.5f );
+  EXPECT_EQ( msg.field("ENABLED")->numericValue().extract<bool>(), true );
+  EXPECT_EQ( msg.field("WARN")->numericValue().getTypeID(), INT8 );
+
+  // strings and fields that aren't constants are not numbers
+  EXPECT_EQ( msg.field("LABEL")->value(), "not a number # 42" );
+  EXPECT_EQ( msg.field("LABEL")->numericValue().getTypeID(), OTHER );
+  EXPECT_EQ( msg.field("level")->numericValue().getTypeID(), OTHER );
+
+  // from a value to the name of the constant, whatever the type of the value
+  EXPECT_EQ( msg.findConstant( VarNumber(int8_t(2)) )->name(), "ERROR" );
+  EXPECT_EQ( msg.findConstant( VarNumber(uint32_t(1)) )->name(), "WARN" );
+  EXPECT_EQ( msg.findConstant( VarNumber(-300.0) )->name(), "NEGATIVE" );
+  EXPECT_EQ( msg.findConstant( VarNumber(uint64_t(18446744073709551615ull)) )->name(), "BIG" );
+  EXPECT_TRUE( msg.findConstant( VarNumber(int8_t(3)) ) == nullptr );
+  EXPECT_TRUE( msg.findConstant( VarNumber(0.25) ) == nullptr );
+}
+
+TEST(ROSMessage, DecodedConstants)
+{
+  const char* definition =
+      "char LOW=65\n"
+      "char HIGH=200\n"
+      "float32 HALF=0.5\n"
+      "char letter\n"
+      "float32 ratio\n";
+
+  ROSTypeList type_list = buildROSTypeMapFromDefinition( "test_msgs/Letter", definition );
+  const ROSMessage& msg = type_list.front();
+
+  // the constants must match the values created by the decoder, not only the ones built by hand
+  std::vector<uint8_t> buffer = { 200, 0, 0, 0, 0 };
+  const float half = 0.5f;
+  memcpy( &buffer[1], &half, sizeof(float) );
+
+  uint8_t* ptr = buffer.data();
+  const VarNumber letter = msg.field("letter")->type().deserializeFromBuffer( &ptr );
+  const VarNumber ratio  = msg.field("ratio")->type().deserializeFromBuffer( &ptr );
+
+  EXPECT_EQ( letter.getTypeID(), msg.field("HIGH")->numericValue().getTypeID() );
+  EXPECT_EQ( letter.convert<int>(), 200 );
+  ASSERT_TRUE( msg.findConstant( letter ) != nullptr );
+  EXPECT_EQ( msg.findConstant( letter )->name(), "HIGH" );
+  ASSERT_TRUE( msg.findConstant( ratio ) != nullptr );
+  EXPECT_EQ( msg.findConstant( ratio )->name(), "HALF" );
+}
+
+TEST(ROSMessage, InvalidConstants)
+{
+  const char* invalid[] = {
+    "int32 X=abc\n",
+    "int32 X=1.5\n",
+    "int32 X=\n",
+    "int8 X=128\n",
+    "uint8 X=-1\n",
+    "uint16 X=65536\n",
+    "float64 X=1.0x\n",
+    "float32 X=1e39\n",
+    "float64 X=1e400\n",
+    "bool X=maybe\n",
+    "time X=1\n"
+  };
+  for (const char* definition: invalid)
+  {
+    EXPECT_THROW( buildROSTypeMapFromDefinition( "test_msgs/Invalid", definition ), std::runtime_error ) << definition;
+  }
+  EXPECT_NO_THROW( buildROSTypeMapFromDefinition( "test_msgs/Valid", "int8 X=-128\nuint8 Y=255\nfloat64 Z=1e-3\n" ) );
+}
+
 // Run all the tests that were declared with TEST()
 int main(int argc, char **argv){
   testing::InitGoogleTest(&argc, argv);
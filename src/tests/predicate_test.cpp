@@ -0,0 +1,170 @@
+#include "config.h"
+#include <gtest/gtest.h>
+
+#include <ros_type_introspection/predicate.hpp>
+#include "synthetic_generator.hpp"
+
+using namespace RosIntrospection;
+
+TEST(FieldLocator, SyntheticMessages)
+{
+  for (unsigned seed = 0; seed < 30; seed++)
+  {
+    SyntheticOptions options;
+    options.seed = seed;
+    options.depth = 1 + seed % 4;
+    options.width = 1 + seed % 6;
+    options.array_probability = 0.3;
+    SyntheticMessage msg = SyntheticGenerator::generate( options, "msg" );
+
+    ROSTypeList type_map = buildROSTypeMapFromDefinition( msg.datatype, msg.definition );
+    ROSType main_type( msg.datatype );
+
+    for (const auto& expected: msg.values)
+    {
+      FieldLocator locator( type_map, main_type, expected.first.substr(4) ); // remove "msg/"
+      VarNumber value;
+      ASSERT_TRUE( locator.extract( msg.buffer.data(), msg.buffer.size(), &value ) ) << expected.first;
+      EXPECT_EQ( value.convert<double>(), expected.second ) << expected.first;
+    }
+    for (const auto& expected: msg.strings)
+    {
+      FieldLocator locator( type_map, main_type, expected.first.substr(4) );
+      boost::string_ref value;
+      ASSERT_TRUE( locator.extract( msg.buffer.data(), msg.buffer.size(), &value ) ) << expected.first;
+      EXPECT_EQ( value.to_string(), expected.second ) << expected.first;
+    }
+  }
+}
+
+const char* STATUS_DEFINITION =
+    "Header header\n"
+    "byte OK=0\n"
+    "byte WARN=1\n"
+    "Status[] status\n"
+    "================================================================================\n"
+    "MSG: std_msgs/Header\n"
+    "uint32 seq\n"
+    "time stamp\n"
+    "string frame_id\n"
+    "================================================================================\n"
+    "MSG: test_msgs/Status\n"
+    "byte level\n"
+    "string name\n";
+
+std::vector<uint8_t> SerializeStatus(const std::string& frame_id,
+                                     const std::vector<std::pair<int8_t, std::string>>& status)
+{
+  std::vector<uint8_t> buffer;
+  auto append_uint32 = [&buffer](uint32_t value) {
+    buffer.insert( buffer.end(), (uint8_t*)&value, (uint8_t*)&value + 4 );
+  };
+  auto append_string = [&](const std::string& str) {
+    append_uint32( str.size() );
+    buffer.insert( buffer.end(), str.begin(), str.end() );
+  };
+  append_uint32( 1 ); // seq
+  append_uint32( 2 ); // stamp.sec
+  append_uint32( 3 ); // stamp.nsec
+  append_string( frame_id );
+  append_uint32( status.size() );
+  for (const auto& it: status)
+  {
+    buffer.push_back( it.first );
+    append_string( it.second );
+  }
+  return buffer;
+}
+
+TEST(MessagePredicate, Evaluate)
+{
+  ROSTypeList type_map = buildROSTypeMapFromDefinition( "test_msgs/StatusArray", STATUS_DEFINITION );
+  ROSType main_type( "test_msgs/StatusArray" );
+
+  std::vector<uint8_t> msg_A = SerializeStatus( "base_link", { {0, "motor"}, {2, "battery"} } );
+  std::vector<uint8_t> msg_B = SerializeStatus( "map", { {1, "motor"} } );
+
+  auto evaluate = [&](const std::string& expression, const std::vector<uint8_t>& buffer)
+  {
+    MessagePredicate predicate( type_map, main_type, expression );
+    return predicate( buffer.data(), buffer.size() );
+  };
+
+  EXPECT_TRUE(  evaluate( "header/frame_id == \"base_link\"", msg_A ) );
+  EXPECT_FALSE( evaluate( "header/frame_id == \"base_link\"", msg_B ) );
+  EXPECT_TRUE(  evaluate( "header/frame_id > \"a\"", msg_B ) );
+  EXPECT_TRUE(  evaluate( "header/seq == 1", msg_A ) );
+
+  EXPECT_TRUE(  evaluate( "status.1/level >= 2", msg_A ) );
+  EXPECT_FALSE( evaluate( "status.0/level >= 2", msg_A ) );
+  // msg_B has a single element
+  EXPECT_FALSE( evaluate( "status.1/level >= 2", msg_B ) );
+  EXPECT_TRUE(  evaluate( "status.1/name == \"battery\"", msg_A ) );
+
+  EXPECT_TRUE(  evaluate( "status.0/level == 1 && status.0/name == \"motor\"", msg_B ) );
+  EXPECT_FALSE( evaluate( "status.0/level == 1 && status.0/name != \"motor\"", msg_B ) );
+  EXPECT_TRUE(  evaluate( "status.0/level == 5 || header/frame_id == \"map\"", msg_B ) );
+  EXPECT_FALSE( evaluate( "status.0/level == 5 || status.1/level == 1 && header/seq == 1", msg_B ) );
+
+  // truncated message
+  MessagePredicate predicate( type_map, main_type, "status.1/name == \"battery\"" );
+  EXPECT_THROW( predicate( msg_A.data(), msg_A.size() - 3 ), RangeException );
+}
+
+TEST(MessagePredicate, InvalidExpressions)
+{
+  ROSTypeList type_map = buildROSTypeMapFromDefinition( "test_msgs/StatusArray", STATUS_DEFINITION );
+  ROSType main_type( "test_msgs/StatusArray" );
+
+  const char* invalid[] = {
+    "header/frame == \"base_link\"",   // no such field
+    "status/level >= 2",               // array without index
+    "header.0/seq == 1",               // index of a non-array
+    "header >= 2",                     // not a builtin
+    "header/seq = 1",                  // invalid operator
+    "header/seq == \"1\"",             // string literal for a number
+    "header/frame_id == 1",            // number for a string
+    "header/seq == 1 &&",              // incomplete
+  };
+  for (const char* expression: invalid)
+  {
+    EXPECT_THROW( MessagePredicate( type_map, main_type, expression ), std::runtime_error ) << expression;
+  }
+}
+
+TEST(MessagePredicate, LargeIntegers)
+{
+  ROSTypeList type_map = buildROSTypeMapFromDefinition( "test_msgs/Counters",
+                                                        "uint64 stamp_ns\nint64 offset\nfloat32 ratio\n" );
+  ROSType main_type( "test_msgs/Counters" );
+
+  std::vector<uint8_t> buffer;
+  auto append = [&buffer](const void* ptr, size_t size) {
+    buffer.insert( buffer.end(), (const uint8_t*)ptr, (const uint8_t*)ptr + size );
+  };
+  const uint64_t stamp = 1500000000123456789ull;  // above 2^53
+  const int64_t offset = -9007199254740993ll;     // -(2^53 + 1)
+  const float ratio = 0.1f;
+  append( &stamp, sizeof(stamp) );
+  append( &offset, sizeof(offset) );
+  append( &ratio, sizeof(ratio) );
+
+  auto evaluate = [&](const std::string& expression) {
+    return MessagePredicate( type_map, main_type, expression )( buffer.data(), buffer.size() );
+  };
+
+  // exact comparisons, that would fail using double
+  EXPECT_TRUE( evaluate( "stamp_ns == 1500000000123456789" ) );
+  EXPECT_FALSE( evaluate( "stamp_ns == 1500000000123456788" ) );
+  EXPECT_TRUE( evaluate( "stamp_ns > 1500000000123456788" ) );
+  EXPECT_TRUE( evaluate( "offset < -9007199254740992" ) );
+  EXPECT_TRUE( evaluate( "stamp_ns > 1.4e18" ) );
+
+  // uint64 larger than any int64
+  buffer[7] = 0xFF;
+  EXPECT_TRUE( evaluate( "stamp_ns > 9223372036854775807" ) );
+  EXPECT_TRUE( evaluate( "stamp_ns != -1" ) );
+
+  // float32 compared with a double literal doesn't throw
+  EXPECT_TRUE( evaluate( "ratio > 0.09 && ratio < 0.11" ) );
+}
@@ -0,0 +1,151 @@
+#include "config.h"
+#include <gtest/gtest.h>
+
+#include <ros_type_introspection/schema_layout.hpp>
+#include <ros_type_introspection/schema.hpp>
+#include "synthetic_generator.hpp"
+
+using namespace RosIntrospection;
+
+namespace {
+
+const char* DEFINITION =
+    "Header header\n"
+    "Point origin\n"
+    "float64[2] range\n"
+    "int32 MAX=10\n"
+    "Point[] points\n"
+    "uint8 flag\n"
+    "================================================================================\n"
+    "MSG: std_msgs/Header\n"
+    "uint32 seq\n"
+    "time stamp\n"
+    "string frame_id\n"
+    "================================================================================\n"
+    "MSG: test_msgs/Point\n"
+    "float64 x\n"
+    "float64 y\n";
+
+} // end namespace
+
+TEST(SchemaLayout, SizesAndOffsets)
+{
+  MessageSchema schema( "md5", "test_msgs/Shape", DEFINITION );
+  const SchemaLayout& layout = schema.layout();
+
+  ASSERT_EQ( layout.messages().size(), 3 );
+  const SchemaLayout::MessageLayout& root = layout.root();
+  EXPECT_EQ( root.definition->type().baseName(), "test_msgs/Shape" );
+  EXPECT_FALSE( root.isFixedSize() );
+  EXPECT_EQ( root.flags, SchemaLayout::HAS_STRINGS | SchemaLayout::HAS_VARIABLE_ARRAYS );
+  // header (16), origin (16), range (16), points (4), flag (1)
+  EXPECT_EQ( root.min_size, 53 );
+
+  // the constant isn't part of the layout
+  ASSERT_EQ( root.fields.size(), 5 );
+
+  const SchemaLayout::FieldLayout& header = root.fields[0];
+  EXPECT_EQ( header.field->name(), "header" );
+  EXPECT_EQ( header.fixed_size, -1 );
+  EXPECT_EQ( header.min_size, 16 );
+  EXPECT_EQ( header.fixed_offset, 0 );
+  EXPECT_EQ( header.flags, SchemaLayout::HAS_STRINGS );
+
+  const SchemaLayout::MessageLayout& header_layout = layout.messages()[header.message_index];
+  EXPECT_EQ( header_layout.fields[2].fixed_offset, 12 );
+  EXPECT_EQ( header_layout.fields[2].min_size, 4 );
+
+  // after the header, the offsets aren't known statically
+  const SchemaLayout::FieldLayout& origin = root.fields[1];
+  EXPECT_EQ( origin.element_size, 16 );
+  EXPECT_EQ( origin.fixed_size, 16 );
+  EXPECT_EQ( origin.fixed_offset, -1 );
+  EXPECT_EQ( origin.min_offset, 16 );
+  EXPECT_EQ( origin.flags, 0 );
+  EXPECT_TRUE( layout.messages()[origin.message_index].isFixedSize() );
+
+  const SchemaLayout::FieldLayout& range = root.fields[2];
+  EXPECT_EQ( range.message_index, -1 );
+  EXPECT_EQ( range.element_size, 8 );
+  EXPECT_EQ( range.fixed_size, 16 );
+  EXPECT_EQ( range.min_offset, 32 );
+
+  const SchemaLayout::FieldLayout& points = root.fields[3];
+  EXPECT_EQ( points.message_index, origin.message_index );
+  EXPECT_EQ( points.element_size, 16 );
+  EXPECT_EQ( points.fixed_size, -1 );
+  EXPECT_EQ( points.min_size, 4 );
+  EXPECT_EQ( points.flags, SchemaLayout::HAS_VARIABLE_ARRAYS );
+
+  EXPECT_EQ( root.fields[4].min_offset, 52 );
+
+  // the nested types come first
+  ASSERT_EQ( layout.postOrder().size(), 3 );
+  EXPECT_EQ( layout.postOrder().back(), 0 );
+  EXPECT_EQ( layout.messageIndex( ROSType("test_msgs/Point") ), origin.message_index );
+  EXPECT_EQ( layout.messageIndex( ROSType("test_msgs/Other") ), -1 );
+}
+
+TEST(SchemaLayout, MissingType)
+{
+  ROSTypeList type_list = buildROSTypeMapFromDefinition( "test_msgs/Shape", DEFINITION );
+  EXPECT_THROW( SchemaLayout( type_list, ROSType("test_msgs/Unknown") ), std::runtime_error );
+}
+
+// the serialized messages are never shorter than min_size, and as long as fixed_size if it is known
+TEST(SchemaLayout, HugeArrays)
+{
+  // 2.4 Gbytes don't fit in an int: the size is variable, the minimum size is still exact
+  ROSTypeList type_list = buildROSTypeMapFromDefinition( "test_msgs/Huge", "float64[300000000] big\nuint8 tail\n" );
+  SchemaLayout layout( type_list, ROSType("test_msgs/Huge") );
+  const SchemaLayout::MessageLayout& root = layout.root();
+
+  EXPECT_EQ( root.fields[0].fixed_size, -1 );
+  EXPECT_EQ( root.fields[0].min_size, 2400000000u );
+  EXPECT_EQ( root.fields[1].fixed_offset, -1 );
+  EXPECT_FALSE( root.isFixedSize() );
+  EXPECT_EQ( root.min_size, 2400000001u );
+
+  // each field fits in an int, but not their sum
+  type_list = buildROSTypeMapFromDefinition( "test_msgs/Pair", "float64[200000000] first\nfloat64[200000000] second\n" );
+  SchemaLayout pair( type_list, ROSType("test_msgs/Pair") );
+  EXPECT_EQ( pair.root().fields[1].fixed_size, 1600000000 );
+  EXPECT_FALSE( pair.root().isFixedSize() );
+
+  // larger than 4 Gbytes: the minimum size saturates
+  type_list = buildROSTypeMapFromDefinition( "test_msgs/Larger", "float64[600000000] big\n" );
+  SchemaLayout larger( type_list, ROSType("test_msgs/Larger") );
+  EXPECT_EQ( larger.root().min_size, std::numeric_limits<uint32_t>::max() );
+}
+
+TEST(SchemaLayout, SyntheticMessages)
+{
+  for (unsigned seed = 0; seed < 50; seed++)
+  {
+    SyntheticOptions options;
+    options.seed = seed;
+    options.string_probability = (seed % 3 == 0) ? 0.0 : 0.2;
+    options.array_probability = (seed % 5 == 0) ? 0.0 : 0.3;
+    SyntheticMessage msg = SyntheticGenerator::generate( options, "msg" );
+
+    ROSTypeList type_list = buildROSTypeMapFromDefinition( msg.datatype, msg.definition );
+    SchemaLayout layout( type_list, ROSType(msg.datatype) );
+    const SchemaLayout::MessageLayout& root = layout.root();
+
+    EXPECT_LE( root.min_size, msg.buffer.size() ) << "seed " << seed;
+    if( root.isFixedSize() )
+    {
+      EXPECT_EQ( root.fixed_size, msg.buffer.size() ) << "seed " << seed;
+      EXPECT_EQ( root.min_size, msg.buffer.size() ) << "seed " << seed;
+    }
+    if( options.string_probability == 0.0 )
+    {
+      EXPECT_EQ( root.flags & SchemaLayout::HAS_STRINGS, 0 ) << "seed " << seed;
+    }
+    if( options.array_probability == 0.0 )
+    {
+      EXPECT_EQ( root.flags & SchemaLayout::HAS_VARIABLE_ARRAYS, 0 ) << "seed " << seed;
+      EXPECT_EQ( root.isFixedSize(), root.flags == 0 ) << "seed " << seed;
+    }
+  }
+}
@@ -0,0 +1,206 @@
+#include "config.h"
+#include <gtest/gtest.h>
+
+#include <ros_type_introspection/serializer.hpp>
+#include <ros_type_introspection/field_locator.hpp>
+#include "synthetic_generator.hpp"
+
+using namespace RosIntrospection;
+
+TEST(MessageSerializer, RoundTripSyntheticMessages)
+{
+  for (unsigned seed = 0; seed < 50; seed++)
+  {
+    SyntheticOptions options;
+    options.seed = seed;
+    options.depth = 1 + seed % 5;
+    options.width = 1 + seed % 7;
+    options.array_probability = 0.3;
+    SyntheticMessage msg = SyntheticGenerator::generate( options, "msg" );
+
+    ROSTypeList type_map = buildROSTypeMapFromDefinition( msg.datatype, msg.definition );
+    ROSType main_type( msg.datatype );
+
+    ROSTypeFlat flat_container;
+    buildRosFlatType( type_map, main_type, "msg", msg.buffer.data(), &flat_container, 10000 );
+
+    MessageSerializer serializer( type_map, main_type, "msg" );
+    FlatContainerSource source( serializer, flat_container );
+
+    std::vector<uint8_t> buffer;
+    serializer.serialize( &source, &buffer );
+    EXPECT_EQ( buffer, msg.buffer ) << "seed " << seed << "\n" << msg.definition;
+  }
+}
+
+TEST(MessageSerializer, ModifyFlatContainer)
+{
+  const char* definition =
+      "string[] names\n"
+      "float64[] values\n"
+      "uint8 level\n";
+
+  ROSTypeList type_map = buildROSTypeMapFromDefinition( "test_msgs/Values", definition );
+  ROSType main_type( "test_msgs/Values" );
+
+  std::vector<uint8_t> original = {
+    1,0,0,0,  1,0,0,0, 'a',          // names = ["a"]
+    0,0,0,0,                         // values = []
+    7 };                             // level = 7
+
+  ROSTypeFlat flat_container;
+  buildRosFlatType( type_map, main_type, "", original.data(), &flat_container, 100 );
+  ASSERT_EQ( flat_container.value.size(), 1 );
+
+  flat_container.name[0].second = SString("longer name");
+  flat_container.value[0].second = VarNumber( 9.0 ); // converted to uint8
+
+  MessageSerializer serializer( type_map, main_type );
+  FlatContainerSource source( serializer, flat_container );
+
+  std::vector<uint8_t> buffer;
+  serializer.serialize( &source, &buffer );
+  EXPECT_EQ( buffer.size(), original.size() + 10 );
+
+  boost::string_ref name;
+  FieldLocator( type_map, main_type, "names.0" ).extract( buffer.data(), buffer.size(), &name );
+  EXPECT_EQ( name, "longer name" );
+
+  VarNumber level;
+  FieldLocator( type_map, main_type, "level" ).extract( buffer.data(), buffer.size(), &level );
+  EXPECT_EQ( level.extract<uint8_t>(), 9 );
+
+  // the buffer is too small
+  EXPECT_THROW( serializer.write( &source, buffer.data(), buffer.size() - 1 ), RangeException );
+}
+
+// Source that writes the index of the element in every field.
+class IndexSource: public SerializationSource
+{
+public:
+  uint32_t arraySize(const StringTreeLeaf& ) override { return 3; }
+
+  VarNumber number(const StringTreeLeaf& leaf, const ROSType& ) override
+  {
+    return VarNumber( int32_t( leaf.array_size > 0 ? leaf.index_array[ leaf.array_size-1 ] : 42 ) );
+  }
+
+  boost::string_ref string(const StringTreeLeaf& ) override { return "abc"; }
+};
+
+TEST(MessageSerializer, CustomSource)
+{
+  const char* definition =
+      "Header header\n"
+      "int16[] values\n"
+      "================================================================================\n"
+      "MSG: std_msgs/Header\n"
+      "uint32 seq\n"
+      "time stamp\n"
+      "string frame_id\n";
+
+  ROSTypeList type_map = buildROSTypeMapFromDefinition( "test_msgs/Values", definition );
+  MessageSerializer serializer( type_map, ROSType("test_msgs/Values") );
+  IndexSource source;
+
+  std::vector<uint8_t> buffer;
+  serializer.serialize( &source, &buffer );
+
+  const std::vector<uint8_t> expected = {
+    42,0,0,0,                 // seq
+    42,0,0,0, 0,0,0,0,        // stamp = 42 seconds
+    3,0,0,0, 'a','b','c',     // frame_id
+    3,0,0,0, 0,0, 1,0, 2,0 }; // values
+  EXPECT_EQ( buffer, expected );
+
+  ShapeShifter shifter;
+  serializer.serialize( &source, &shifter );
+  ASSERT_EQ( shifter.size(), expected.size() );
+  EXPECT_EQ( memcmp( shifter.raw_data(), expected.data(), expected.size() ), 0 );
+}
+
+TEST(MessageSerializer, ConvertValues)
+{
+  const char* definition =
+      "char letter\n"
+      "float32 ratio\n"
+      "int8 small\n";
+
+  ROSTypeList type_map = buildROSTypeMapFromDefinition( "test_msgs/Values", definition );
+  ROSType main_type( "test_msgs/Values" );
+
+  std::vector<uint8_t> original = { 'x',  0,0,0,0,  1 };
+
+  ROSTypeFlat flat_container;
+  buildRosFlatType( type_map, main_type, "", original.data(), &flat_container, 100 );
+  ASSERT_EQ( flat_container.value.size(), 3 );
+
+  // a double is rounded to float32, char is written as it was read
+  flat_container.value[1].second = VarNumber( 0.1 );
+
+  MessageSerializer serializer( type_map, main_type );
+  FlatContainerSource source( serializer, flat_container );
+
+  std::vector<uint8_t> buffer;
+  serializer.serialize( &source, &buffer );
+  ASSERT_EQ( buffer.size(), original.size() );
+  EXPECT_EQ( buffer[0], 'x' );
+  float ratio;
+  memcpy( &ratio, &buffer[1], sizeof(float) );
+  EXPECT_EQ( ratio, 0.1f );
+
+  // integers must fit in the type of the field
+  flat_container.value[2].second = VarNumber( int32_t(300) );
+  EXPECT_THROW( serializer.serialize( &source, &buffer ), RangeException );
+}
+
+TEST(MessageSerializer, IncompleteFlatContainer)
+{
+  const char* definition =
+      "float64[] values\n"
+      "Item[] items\n"
+      "================================================================================\n"
+      "MSG: test_msgs/Item\n"
+      "uint8[] data\n";
+
+  ROSTypeList type_map = buildROSTypeMapFromDefinition( "test_msgs/Values", definition );
+  ROSType main_type( "test_msgs/Values" );
+
+  std::vector<uint8_t> original = {
+    2,0,0,0,  0,0,0,0,0,0,0,0,  0,0,0,0,0,0,0,0,   // values = [0, 0]
+    0,0,0,0 };                                     // items = []
+
+  MessageSerializer serializer( type_map, main_type );
+  EXPECT_TRUE( serializer.hasElementsWithoutLeaves() );
+
+  ROSTypeFlat flat_container;
+  buildRosFlatType( type_map, main_type, "", original.data(), &flat_container, 100 );
+  EXPECT_THROW( FlatContainerSource( serializer, flat_container ), std::runtime_error );
+
+  // the arrays skipped because of max_array_size can't be written again
+  ROSTypeList values_map = buildROSTypeMapFromDefinition( "test_msgs/Values", "float64[] values\n" );
+  MessageSerializer values_serializer( values_map, main_type );
+  EXPECT_FALSE( values_serializer.hasElementsWithoutLeaves() );
+
+  buildRosFlatType( values_map, main_type, "", original.data(), &flat_container, 1 );
+  EXPECT_EQ( flat_container.skipped_arrays, 1 );
+  EXPECT_THROW( FlatContainerSource( values_serializer, flat_container ), std::runtime_error );
+
+  // nor the ones stored in numeric_arrays
+  flat_container.bulk_numeric_arrays = true;
+  buildRosFlatType( values_map, main_type, "", original.data(), &flat_container, 100 );
+  EXPECT_EQ( flat_container.skipped_arrays, 0 );
+  EXPECT_THROW( FlatContainerSource( values_serializer, flat_container ), std::runtime_error );
+
+  flat_container.bulk_numeric_arrays = false;
+  buildRosFlatType( values_map, main_type, "", original.data(), &flat_container, 100 );
+  FlatContainerSource source( values_serializer, flat_container );
+  std::vector<uint8_t> buffer;
+  values_serializer.serialize( &source, &buffer );
+  EXPECT_EQ( buffer, std::vector<uint8_t>( original.begin(), original.begin() + 20 ) );
+
+  // a value was removed
+  flat_container.value.erase( flat_container.value.begin() );
+  FlatContainerSource missing( values_serializer, flat_container );
+  EXPECT_THROW( values_serializer.serialize( &missing, &buffer ), std::runtime_error );
+}
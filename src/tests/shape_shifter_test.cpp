@@ -0,0 +1,245 @@
+#include "config.h"
+#include <gtest/gtest.h>
+
+#include "ros_type_introspection/shape_shifter.hpp"
+
+using namespace RosIntrospection;
+
+TEST(ShapeShifter, ReadCopiesTheBuffer)
+{
+  std::vector<uint8_t> buffer(64);
+  for (size_t i=0; i<buffer.size(); i++) buffer[i] = i;
+
+  ShapeShifter shifter;
+  ros::serialization::IStream stream( buffer.data(), buffer.size() );
+  shifter.read( stream );
+
+  EXPECT_FALSE( shifter.isBorrowed() );
+  EXPECT_EQ( shifter.size(), buffer.size() );
+  EXPECT_NE( shifter.raw_data(), buffer.data() );
+  EXPECT_EQ( memcmp( shifter.raw_data(), buffer.data(), buffer.size()), 0 );
+}
+
+TEST(ShapeShifter, BorrowSerializedMessage)
+{
+  const uint32_t msg_size = 1024;
+  boost::shared_array<uint8_t> buffer( new uint8_t[msg_size + 4] );
+  memcpy( buffer.get(), &msg_size, 4);
+  for (uint32_t i=0; i<msg_size; i++) buffer[i+4] = i % 256;
+
+  ros::SerializedMessage serialized;
+  serialized.buf = buffer;
+  serialized.num_bytes = msg_size + 4;
+  serialized.message_start = buffer.get() + 4;
+
+  ShapeShifter shifter;
+  shifter.borrow( serialized );
+
+  EXPECT_TRUE( shifter.isBorrowed() );
+  EXPECT_EQ( shifter.size(), msg_size );
+  EXPECT_EQ( shifter.raw_data(), buffer.get() + 4 );
+
+  // the ShapeShifter keeps the buffer alive
+  const uint8_t* data = buffer.get();
+  serialized = ros::SerializedMessage();
+  buffer.reset();
+  EXPECT_EQ( shifter.raw_data()[10], 10 );
+
+  // a copy shares the same buffer
+  ShapeShifter copy = shifter;
+  EXPECT_EQ( copy.raw_data(), data + 4 );
+
+  // reading a new message releases the borrowed one
+  std::vector<uint8_t> other(16, 42);
+  ros::serialization::IStream stream( other.data(), other.size() );
+  shifter.read( stream );
+  EXPECT_FALSE( shifter.isBorrowed() );
+  EXPECT_EQ( shifter.size(), 16 );
+  EXPECT_EQ( shifter.raw_data()[0], 42 );
+}
+
+TEST(BufferPool, RecycleBuffers)
+{
+  // buffers larger than 4 Kbytes are not cached
+  BufferPool pool(2, 64*1024*1024, 4096);
+  {
+    PooledBuffer buffer(&pool);
+    buffer.resize(100);
+    EXPECT_EQ( buffer.size(), 100 );
+    EXPECT_EQ( buffer.capacity(), 256 );
+    memset( buffer.data(), 7, buffer.size() );
+
+    // growing preserves the content
+    buffer.resize(1000);
+    EXPECT_EQ( buffer.capacity(), 1024 );
+    EXPECT_EQ( buffer.data()[99], 7 );
+
+    PooledBuffer copy(buffer);
+    EXPECT_NE( copy.data(), buffer.data() );
+    EXPECT_EQ( copy.data()[99], 7 );
+  }
+  BufferPool::Statistics stats = pool.statistics();
+  EXPECT_EQ( stats.hits, 0 );
+  EXPECT_EQ( stats.misses, 3 );
+  EXPECT_EQ( stats.recycled, 3 );
+
+  for (int i=0; i<10; i++)
+  {
+    PooledBuffer buffer(&pool);
+    buffer.resize(1000);
+  }
+  stats = pool.statistics();
+  EXPECT_EQ( stats.hits, 10 );
+  EXPECT_EQ( stats.misses, 3 );
+  EXPECT_GT( stats.hitRate(), 0.75 );
+
+  // too large to be cached
+  {
+    PooledBuffer buffer(&pool);
+    buffer.resize( 5000 );
+    EXPECT_EQ( buffer.capacity(), 5000 );
+  }
+  stats = pool.statistics();
+  EXPECT_EQ( stats.misses, 4 );
+  EXPECT_EQ( stats.discarded, 1 );
+}
+
+TEST(BufferPool, MaxCachedBytes)
+{
+  BufferPool pool(32, 2048);
+  {
+    PooledBuffer first(&pool), second(&pool), third(&pool);
+    first.resize( 1000 );
+    second.resize( 1000 );
+    third.resize( 1000 );
+  }
+  // only two buffers of 1024 bytes fit
+  EXPECT_EQ( pool.cachedBytes(), 2048 );
+  EXPECT_EQ( pool.statistics().recycled, 2 );
+  EXPECT_EQ( pool.statistics().discarded, 1 );
+
+  {
+    PooledBuffer buffer(&pool);
+    buffer.resize( 1000 );
+    EXPECT_EQ( pool.cachedBytes(), 1024 );
+  }
+  pool.clear();
+  EXPECT_EQ( pool.cachedBytes(), 0 );
+
+  // the largest class is 2048 bytes, what max_cached_bytes can hold
+  {
+    PooledBuffer buffer(&pool);
+    buffer.resize( 2000 );
+    EXPECT_EQ( buffer.capacity(), 2048 );
+    buffer.resize( 3000 );
+    EXPECT_EQ( buffer.capacity(), 3000 );
+  }
+  EXPECT_EQ( pool.cachedBytes(), 2048 );
+  EXPECT_EQ( pool.statistics().discarded, 2 );
+}
+
+TEST(ShapeShifter, InvalidDefinition)
+{
+  // the type of the field is missing: the messages are received anyway, without a schema
+  boost::shared_ptr<ros::M_string> header( new ros::M_string );
+  (*header)["md5sum"] = "0123456789abcdef0123456789abcdef";
+  (*header)["type"] = "my_msgs/Broken";
+  (*header)["message_definition"] = "my_msgs/Missing value\n";
+
+  ros::serialization::PreDeserializeParams<ShapeShifter> params;
+  params.message.reset( new ShapeShifter );
+  params.connection_header = header;
+  ASSERT_NO_THROW( ros::serialization::PreDeserialize<ShapeShifter>::notify( params ) );
+
+  const ShapeShifter& shifter = *params.message;
+  EXPECT_EQ( shifter.getDataType(), "my_msgs/Broken" );
+  EXPECT_FALSE( shifter.schema() );
+  EXPECT_FALSE( shifter.info()->schema_error.empty() );
+
+  std::vector<uint8_t> buffer(16, 42);
+  ros::serialization::IStream stream( buffer.data(), buffer.size() );
+  params.message->read( stream );
+  EXPECT_EQ( shifter.size(), 16 );
+
+  // the failure is cached with the connection: the definition isn't parsed again
+  EXPECT_EQ( MessageInfo::fromConnectionHeader( header ), shifter.info() );
+}
+
+TEST(ShapeShifter, SchemaResolvedByMorph)
+{
+  const std::string definition =
+      "Header header\n"
+      "float64 value\n"
+      "================================================================================\n"
+      "MSG: std_msgs/Header\n"
+      "uint32 seq\n"
+      "time stamp\n"
+      "string frame_id\n";
+
+  ShapeShifter first;
+  EXPECT_FALSE( first.schema() );
+
+  first.morph( "0123456789abcdef0123456789abcdef", "my_msgs/Sample", definition );
+  ASSERT_TRUE( first.schema().get() != nullptr );
+  EXPECT_EQ( first.schema()->datatype(), "my_msgs/Sample" );
+  EXPECT_EQ( first.schema()->rootType().baseName(), "my_msgs/Sample" );
+  EXPECT_EQ( first.schema()->typeList().size(), 2 );
+
+  // the same schema is shared by all the instances
+  ShapeShifter second;
+  second.morph( "0123456789abcdef0123456789abcdef", "my_msgs/Sample", definition );
+  EXPECT_EQ( first.schema(), second.schema() );
+
+  // same MD5, different name
+  ShapeShifter third;
+  third.morph( "0123456789abcdef0123456789abcdef", "other_msgs/Sample", definition );
+  EXPECT_NE( first.schema(), third.schema() );
+  EXPECT_EQ( third.schema()->rootType().baseName(), "other_msgs/Sample" );
+
+  // untyped
+  second.morph( "*", "*", "" );
+  EXPECT_FALSE( second.schema() );
+}
+
+TEST(ShapeShifter, ConnectionHeaderCache)
+{
+  boost::shared_ptr<ros::M_string> header( new ros::M_string );
+  (*header)["md5sum"] = "0123456789abcdef0123456789abcdef";
+  (*header)["type"] = "my_msgs/Value";
+  (*header)["message_definition"] = "float64 value\n";
+
+  ros::serialization::PreDeserializeParams<ShapeShifter> params;
+  params.connection_header = header;
+
+  params.message.reset( new ShapeShifter );
+  ros::serialization::PreDeserialize<ShapeShifter>::notify( params );
+  MessageInfo::ConstPtr first_info = params.message->info();
+
+  ASSERT_TRUE( first_info.get() != nullptr );
+  EXPECT_EQ( params.message->getMD5Sum(), "0123456789abcdef0123456789abcdef" );
+  EXPECT_EQ( params.message->getDataType(), "my_msgs/Value" );
+  EXPECT_EQ( params.message->getMessageDefinition(), "float64 value\n" );
+  ASSERT_TRUE( params.message->schema().get() != nullptr );
+  EXPECT_EQ( params.message->schema()->typeList().size(), 1 );
+
+  // another message on the same connection shares the same info
+  params.message.reset( new ShapeShifter );
+  ros::serialization::PreDeserialize<ShapeShifter>::notify( params );
+  EXPECT_EQ( params.message->info(), first_info );
+
+  // a new connection gets its own info, even if the type is the same
+  boost::shared_ptr<ros::M_string> other_header( new ros::M_string(*header) );
+  params.connection_header = other_header;
+  params.message.reset( new ShapeShifter );
+  ros::serialization::PreDeserialize<ShapeShifter>::notify( params );
+  EXPECT_NE( params.message->info(), first_info );
+  EXPECT_EQ( params.message->schema(), first_info->schema );
+}
+
+TEST(ShapeShifter, Untyped)
+{
+  ShapeShifter shifter;
+  EXPECT_EQ( shifter.getMD5Sum(), "" );
+  EXPECT_FALSE( shifter.schema() );
+  EXPECT_THROW( shifter.instantiate<ShapeShifter>(), std::runtime_error );
+}
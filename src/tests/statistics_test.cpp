@@ -0,0 +1,67 @@
+#include "config.h"
+#include <gtest/gtest.h>
+
+#include <ros_type_introspection/renamer.hpp>
+
+using namespace RosIntrospection;
+
+TEST(DecodeStatistics, CountersPerType)
+{
+  const char* definition =
+      "string label\n"
+      "float64[] small\n"
+      "float64[] large\n";
+
+  ROSTypeList type_map = buildROSTypeMapFromDefinition( "test_msgs/Arrays", definition );
+  ROSType main_type( "test_msgs/Arrays" );
+
+  // label = "abc", small = [1,2], large = 10 zeros
+  std::vector<uint8_t> buffer;
+  auto append_uint32 = [&buffer](uint32_t value) {
+    buffer.insert( buffer.end(), (uint8_t*)&value, (uint8_t*)&value + 4 );
+  };
+  append_uint32(3);
+  buffer.insert( buffer.end(), {'a','b','c'} );
+  append_uint32(2);
+  buffer.resize( buffer.size() + 2*sizeof(double) );
+  append_uint32(10);
+  buffer.resize( buffer.size() + 10*sizeof(double) );
+
+  DecodeStatistics& statistics = DecodeStatistics::global();
+  statistics.reset();
+  ROSTypeFlat flat_container;
+  RenamedValues renamed;
+
+  // disabled by default: nothing is counted
+  buildRosFlatType( type_map, main_type, "arrays", buffer.data(), &flat_container, 5 );
+  EXPECT_TRUE( flat_container.statistics == nullptr );
+
+  statistics.setEnabled( true );
+  for (int i=0; i<3; i++)
+  {
+    buildRosFlatType( type_map, main_type, "arrays", buffer.data(), &flat_container, 5 );
+    applyNameTransform( std::vector<SubstitutionRule>(), flat_container, renamed );
+  }
+  statistics.setEnabled( false );
+
+  bool found = false;
+  for (const TypeStatistics& stats: statistics.snapshot())
+  {
+    if( stats.datatype != "test_msgs/Arrays" ) continue;
+    found = true;
+    EXPECT_EQ( stats.messages, 3 );
+    EXPECT_EQ( stats.bytes, 3*buffer.size() );
+    EXPECT_EQ( stats.leaves, 3*3 ); // label + small[0] + small[1]
+    EXPECT_EQ( stats.skipped_arrays, 3 );
+    EXPECT_GT( stats.decode_ns, 0 );
+    EXPECT_GT( stats.rename_ns, 0 );
+  }
+  EXPECT_TRUE( found );
+
+  statistics.reset();
+  for (const TypeStatistics& stats: statistics.snapshot())
+  {
+    EXPECT_EQ( stats.messages, 0 );
+    EXPECT_EQ( stats.decode_ns, 0 );
+  }
+}
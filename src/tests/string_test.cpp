@@ -0,0 +1,85 @@
+#include "config.h"
+#include <gtest/gtest.h>
+
+#include <ros_type_introspection/buffer_pool.hpp>
+#include <ros_type_introspection/parser.hpp>
+
+using namespace RosIntrospection;
+
+namespace {
+
+// memory_resource that counts the bytes in use.
+class CountingResource: public ssoX::memory_resource{
+public:
+  long long in_use = 0;
+  void* allocate(std::size_t bytes) override   { in_use += bytes; return new char[bytes]; }
+  void deallocate(void* ptr, std::size_t bytes) override { in_use -= bytes; delete[] static_cast<char*>(ptr); }
+};
+
+}
+
+TEST(SString, MemoryResource)
+{
+  const std::string long_text( 100, 'x' );
+  CountingResource resource;
+  {
+    SString str( long_text.data(), long_text.size(), &resource );
+    EXPECT_EQ( str.resource(), &resource );
+    EXPECT_GT( resource.in_use, 100 );
+    EXPECT_EQ( str.toStdString(), long_text );
+
+    // growing keeps the same resource
+    str.append( long_text.data(), long_text.size() );
+    EXPECT_EQ( str.resource(), &resource );
+    EXPECT_EQ( str.size(), 200 );
+
+    // copies use the heap, moves keep the resource
+    SString copy( str );
+    EXPECT_EQ( copy.resource(), nullptr );
+    SString moved( std::move(str) );
+    EXPECT_EQ( moved.resource(), &resource );
+    EXPECT_EQ( moved, copy );
+
+    // back to the internal buffer: the memory is given back
+    moved.resize( 10 );
+    EXPECT_EQ( resource.in_use, 0 );
+    EXPECT_EQ( moved.resource(), nullptr );
+
+    SString short_str( "short", 5, &resource );
+    EXPECT_EQ( short_str.resource(), nullptr );
+    EXPECT_EQ( resource.in_use, 0 );
+
+    short_str.assign( long_text.data(), long_text.size(), &resource );
+    EXPECT_EQ( short_str.resource(), &resource );
+    EXPECT_EQ( short_str.toStdString(), long_text );
+  }
+  EXPECT_EQ( resource.in_use, 0 );
+}
+
+TEST(SString, StringArena)
+{
+  StringArena arena( 256 );
+  std::vector<SString> strings;
+  for (int i=0; i<20; i++)
+  {
+    const std::string text = "a string long enough to be allocated in the arena: " + std::to_string(i);
+    strings.push_back( SString( text.data(), text.size(), &arena ) );
+  }
+  for (int i=0; i<20; i++)
+  {
+    EXPECT_EQ( strings[i].toStdString(), "a string long enough to be allocated in the arena: " + std::to_string(i) );
+  }
+  const size_t capacity = arena.capacity();
+  EXPECT_GE( capacity, 20*50 );
+
+  // after release, the same blocks are reused
+  strings.clear();
+  arena.release();
+  for (int i=0; i<20; i++)
+  {
+    const std::string text = "another string long enough for the arena: " + std::to_string(i);
+    strings.push_back( SString( text.data(), text.size(), &arena ) );
+    EXPECT_EQ( strings.back().toStdString(), text );
+  }
+  EXPECT_EQ( arena.capacity(), capacity );
+}
@@ -0,0 +1,293 @@
+#ifndef ROS_INTROSPECTION_TESTS_SYNTHETIC_GENERATOR_H
+#define ROS_INTROSPECTION_TESTS_SYNTHETIC_GENERATOR_H
+
+#include <stdint.h>
+#include <cstring>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+/*
+ * Generator of random, but valid, ROS message definitions, together with a serialized
+ * payload and the values that buildRosFlatType is expected to extract from it.
+ *
+ * The message is a chain of types (Level0 contains one or more Level1, and so on) and each
+ * type has "width" fields, which can be numbers, strings, nested messages or arrays of them.
+ *
+ * The same options and seed always produce the same message.
+ */
+
+struct SyntheticOptions
+{
+  /// number of nested types (1 means that there is a single, flat, type).
+  int depth = 3;
+  /// number of fields of each type.
+  int width = 5;
+  /// maximum number of nested arrays in the path of a field. It can't exceed 7,
+  /// that is the size of StringTreeLeaf::index_array.
+  int max_array_nesting = 2;
+  /// probability that a field is an array.
+  double array_probability = 0.2;
+  /// arrays have between 0 and max_array_length elements (fixed size arrays at least 1).
+  int max_array_length = 3;
+  /// probability that a field (other than nested messages) is a string.
+  double string_probability = 0.2;
+  /// strings have between 0 and max_string_length characters.
+  int max_string_length = 40;
+  /// probability of adding a constant to each type (they are not serialized).
+  double constant_probability = 0.1;
+
+  unsigned seed = 0;
+};
+
+struct SyntheticMessage
+{
+  std::string datatype;
+  std::string definition;
+  std::vector<uint8_t> buffer;
+
+  /// Expected content of ROSTypeFlat::value (name as printed by StringTreeLeaf::toStr).
+  std::vector< std::pair<std::string, double> > values;
+  /// Expected content of ROSTypeFlat::name.
+  std::vector< std::pair<std::string, std::string> > strings;
+};
+
+class SyntheticGenerator
+{
+public:
+
+  /// prefix is the one that will be passed to buildRosFlatType.
+  static SyntheticMessage generate(const SyntheticOptions& options, const std::string& prefix)
+  {
+    SyntheticGenerator generator(options);
+    generator.createTypes();
+
+    SyntheticMessage msg;
+    msg.datatype = "synthetic_msgs/Level0";
+    msg.definition = generator.definition();
+    generator.serialize( 0, prefix, &msg );
+    return msg;
+  }
+
+private:
+
+  enum Kind{ NUMBER, STRING, MESSAGE, CONSTANT };
+
+  struct Field
+  {
+    Kind kind;
+    std::string type;  // ROS name of the builtin, for NUMBER and CONSTANT
+    std::string name;
+    int array_size;    // 0 if not an array, -1 if variable length
+  };
+
+  struct Type
+  {
+    std::vector<Field> fields;
+  };
+
+  explicit SyntheticGenerator(const SyntheticOptions& options):
+    _options(options), _random(options.seed) {}
+
+  bool chance(double probability)
+  {
+    return std::uniform_real_distribution<double>(0.0, 1.0)(_random) < probability;
+  }
+
+  int uniform(int min, int max)
+  {
+    return std::uniform_int_distribution<int>(min, max)(_random);
+  }
+
+  static const std::vector<std::string>& numericTypes()
+  {
+    static const std::vector<std::string> types = {
+      "int8", "uint8", "int16", "uint16", "int32", "uint32",
+      "int64", "uint64", "float32", "float64" };
+    return types;
+  }
+
+  int randomArraySize()
+  {
+    if( chance(0.5) ) return -1;
+    return uniform( 1, std::max(1, _options.max_array_length) );
+  }
+
+  void createTypes()
+  {
+    const int depth = std::max(1, _options.depth);
+    const int width = std::max(1, _options.width);
+    const int max_array_nesting = std::min( 7, std::max(0, _options.max_array_nesting) );
+
+    // number of arrays in the path that reaches each type
+    int nesting = 0;
+
+    _types.resize( depth );
+    for (int level=0; level < depth; level++)
+    {
+      Type& type = _types[level];
+      const bool has_child = (level+1 < depth);
+      // at least one field is the child, to reach the requested depth
+      const int child_index = has_child ? uniform(0, width-1) : -1;
+      bool child_is_array = false;
+
+      for (int i=0; i < width; i++)
+      {
+        Field field;
+        field.array_size = 0;
+
+        if( i == child_index || (has_child && chance(0.2)) )
+        {
+          field.kind = MESSAGE;
+          field.type = "synthetic_msgs/Level" + std::to_string(level+1);
+          field.name = "child_" + std::to_string(i);
+          // leave room for an array of leaves in the nested types
+          if( nesting + 2 <= max_array_nesting && chance(_options.array_probability) )
+          {
+            field.array_size = randomArraySize();
+            child_is_array = true;
+          }
+        }
+        else{
+          if( chance(_options.string_probability) ){
+            field.kind = STRING;
+            field.type = "string";
+            field.name = "label_" + std::to_string(i);
+          }
+          else{
+            field.kind = NUMBER;
+            field.type = numericTypes()[ uniform(0, numericTypes().size()-1) ];
+            field.name = "value_" + std::to_string(i);
+          }
+          if( nesting + 1 <= max_array_nesting && chance(_options.array_probability) )
+          {
+            field.array_size = randomArraySize();
+          }
+        }
+        type.fields.push_back( field );
+
+        if( chance(_options.constant_probability) )
+        {
+          Field constant;
+          constant.kind = CONSTANT;
+          constant.type = "int32";
+          constant.name = "CONSTANT_" + std::to_string(i);
+          constant.array_size = 0;
+          type.fields.push_back( constant );
+        }
+      }
+      if( child_is_array ) nesting++;
+    }
+  }
+
+  std::string definition() const
+  {
+    std::ostringstream os;
+    for (size_t level=0; level < _types.size(); level++)
+    {
+      if( level > 0 )
+      {
+        os << "================================================================================\n"
+           << "MSG: synthetic_msgs/Level" << level << "\n";
+      }
+      os << "# synthetic type, level " << level << "\n";
+
+      for (const Field& field: _types[level].fields)
+      {
+        if( field.kind == CONSTANT )
+        {
+          os << field.type << " " << field.name << "=42\n";
+          continue;
+        }
+        os << field.type;
+        if( field.array_size == -1 ) os << "[]";
+        if( field.array_size > 0 )   os << "[" << field.array_size << "]";
+        os << " " << field.name << "\n";
+      }
+    }
+    return os.str();
+  }
+
+  template <typename T> static void append(std::vector<uint8_t>* buffer, T value)
+  {
+    const uint8_t* ptr = reinterpret_cast<const uint8_t*>(&value);
+    buffer->insert( buffer->end(), ptr, ptr + sizeof(T) );
+  }
+
+  // Small integer values are represented exactly by all the numeric types.
+  void serializeNumber(const std::string& type, const std::string& name, SyntheticMessage* msg)
+  {
+    const int value = uniform(0, 100);
+    std::vector<uint8_t>* buffer = &msg->buffer;
+
+    if( type == "int8" )         append<int8_t>( buffer, value );
+    else if( type == "uint8" )   append<uint8_t>( buffer, value );
+    else if( type == "int16" )   append<int16_t>( buffer, value );
+    else if( type == "uint16" )  append<uint16_t>( buffer, value );
+    else if( type == "int32" )   append<int32_t>( buffer, value );
+    else if( type == "uint32" )  append<uint32_t>( buffer, value );
+    else if( type == "int64" )   append<int64_t>( buffer, value );
+    else if( type == "uint64" )  append<uint64_t>( buffer, value );
+    else if( type == "float32" ) append<float>( buffer, value );
+    else                         append<double>( buffer, value );
+
+    msg->values.push_back( std::make_pair(name, double(value)) );
+  }
+
+  void serializeString(const std::string& name, SyntheticMessage* msg)
+  {
+    const int length = uniform(0, _options.max_string_length);
+    std::string str;
+    for (int i=0; i<length; i++) {
+      str.push_back( static_cast<char>( 'a' + uniform(0, 25) ) );
+    }
+    append<uint32_t>( &msg->buffer, str.size() );
+    msg->buffer.insert( msg->buffer.end(), str.begin(), str.end() );
+    msg->strings.push_back( std::make_pair(name, str) );
+  }
+
+  void serializeElement(const Field& field, const std::string& name, SyntheticMessage* msg)
+  {
+    switch( field.kind )
+    {
+    case NUMBER:  serializeNumber( field.type, name, msg ); break;
+    case STRING:  serializeString( name, msg ); break;
+    case MESSAGE: serialize( std::stoi( field.type.substr( field.type.find("Level") + 5 ) ), name, msg ); break;
+    case CONSTANT: break;
+    }
+  }
+
+  void serialize(int level, const std::string& path, SyntheticMessage* msg)
+  {
+    for (const Field& field: _types[level].fields)
+    {
+      if( field.kind == CONSTANT ) continue;
+
+      const std::string name = path + "/" + field.name;
+      if( field.array_size == 0 )
+      {
+        serializeElement( field, name, msg );
+        continue;
+      }
+
+      int size = field.array_size;
+      if( size == -1 )
+      {
+        size = uniform(0, _options.max_array_length);
+        append<uint32_t>( &msg->buffer, size );
+      }
+      for (int i=0; i<size; i++)
+      {
+        serializeElement( field, name + "." + std::to_string(i), msg );
+      }
+    }
+  }
+
+  SyntheticOptions  _options;
+  std::mt19937      _random;
+  std::vector<Type> _types;
+};
+
+#endif // ROS_INTROSPECTION_TESTS_SYNTHETIC_GENERATOR_H
@@ -0,0 +1,109 @@
+#include "config.h"
+#include <gtest/gtest.h>
+
+#include <ros_type_introspection/renamer.hpp>
+#include "synthetic_generator.hpp"
+
+using namespace RosIntrospection;
+
+// Decode the synthetic message and compare the result with the ground truth.
+void CheckSyntheticMessage(const SyntheticOptions& options)
+{
+  SyntheticMessage msg = SyntheticGenerator::generate( options, "msg" );
+
+  ROSTypeList type_map = buildROSTypeMapFromDefinition( msg.datatype, msg.definition );
+  ROSType main_type( msg.datatype );
+
+  ROSTypeFlat flat_container;
+  buildRosFlatType( type_map, main_type, "msg", msg.buffer.data(), &flat_container, 10000 );
+
+  if( VERBOSE_TEST ){
+    std::cout << msg.definition << std::endl;
+  }
+
+  ASSERT_EQ( flat_container.value.size(), msg.values.size() ) << "seed " << options.seed;
+  for (size_t i=0; i < msg.values.size(); i++)
+  {
+    EXPECT_EQ( flat_container.value[i].first.toStdString(), msg.values[i].first );
+    EXPECT_EQ( flat_container.value[i].second.convert<double>(), msg.values[i].second );
+  }
+
+  ASSERT_EQ( flat_container.name.size(), msg.strings.size() ) << "seed " << options.seed;
+  for (size_t i=0; i < msg.strings.size(); i++)
+  {
+    EXPECT_EQ( flat_container.name[i].first.toStdString(), msg.strings[i].first );
+    EXPECT_EQ( flat_container.name[i].second.toStdString(), msg.strings[i].second );
+  }
+
+  // without rules, the names are not changed
+  RenamedValues renamed;
+  applyNameTransform( std::vector<SubstitutionRule>(), flat_container, renamed );
+  ASSERT_EQ( renamed.size(), msg.values.size() );
+  for (size_t i=0; i < msg.values.size(); i++)
+  {
+    EXPECT_EQ( renamed[i].first, msg.values[i].first );
+  }
+}
+
+TEST(Synthetic, RandomMessages)
+{
+  for (unsigned seed = 0; seed < 50; seed++)
+  {
+    SyntheticOptions options;
+    options.seed = seed;
+    options.depth = 1 + seed % 5;
+    options.width = 1 + seed % 7;
+    options.array_probability = 0.3;
+    CheckSyntheticMessage( options );
+  }
+}
+
+TEST(Synthetic, DeepNesting)
+{
+  SyntheticOptions options;
+  options.depth = 8;
+  options.width = 4;
+  options.array_probability = 0.0;
+  CheckSyntheticMessage( options );
+}
+
+TEST(Synthetic, NestedArrays)
+{
+  // 7 is the maximum number of indexes of a StringTreeLeaf
+  SyntheticOptions options;
+  options.depth = 8;
+  options.width = 2;
+  options.max_array_nesting = 7;
+  options.array_probability = 1.0;
+  options.max_array_length = 2;
+  CheckSyntheticMessage( options );
+}
+
+TEST(Synthetic, WideFlatMessage)
+{
+  SyntheticOptions options;
+  options.depth = 1;
+  options.width = 2000;
+  options.array_probability = 0.0;
+  CheckSyntheticMessage( options );
+}
+
+// A type list created at the same address of the previous one, with a different definition
+// of the same type, must not reuse the tree of the previous one.
+TEST(Synthetic, TreeNotReusedWithNewTypeList)
+{
+  const char* definitions[2] = { "float64 first\n", "float64 second\n" };
+  const double value = 1.5;
+  std::vector<uint8_t> buffer( reinterpret_cast<const uint8_t*>(&value),
+                               reinterpret_cast<const uint8_t*>(&value) + sizeof(value) );
+
+  ROSTypeFlat flat_container;
+  for (int i=0; i<4; i++)
+  {
+    ROSTypeList type_map = buildROSTypeMapFromDefinition( "test_msgs/Changing", definitions[i%2] );
+    buildRosFlatType( type_map, ROSType("test_msgs/Changing"), "msg", buffer.data(), &flat_container, 100 );
+
+    ASSERT_EQ( flat_container.value.size(), 1 );
+    EXPECT_EQ( flat_container.value[0].first.toStdString(), (i%2 == 0) ? "msg/first" : "msg/second" );
+  }
+}
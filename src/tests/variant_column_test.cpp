@@ -0,0 +1,84 @@
+#include "config.h"
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <ros_type_introspection/variant_column.hpp>
+
+using namespace RosIntrospection;
+
+TEST(VarNumberColumn, UniformColumn)
+{
+  std::vector<float> values;
+  for (int i=0; i<11; i++) values.push_back( i * 0.5f - 2.0f );
+
+  VarNumberColumn column;
+  column.append( FLOAT32, reinterpret_cast<const uint8_t*>(values.data()), values.size() );
+  column.push_back( VarNumber( float(100) ) );
+  ASSERT_EQ( column.size(), 12 );
+  EXPECT_TRUE( column.isUniform() );
+  EXPECT_EQ( column[3].getTypeID(), FLOAT32 );
+  EXPECT_EQ( column[3].extract<float>(), -0.5f );
+  EXPECT_THROW( column[3].convert<int32_t>(), RangeException );
+  EXPECT_EQ( column[11].convert<int32_t>(), 100 );
+
+  std::vector<double> output;
+  column.convertToDouble( &output );
+  ASSERT_EQ( output.size(), 12 );
+  for (size_t i=0; i<values.size(); i++)
+  {
+    EXPECT_EQ( output[i], values[i] );
+  }
+  EXPECT_EQ( output[11], 100 );
+
+  column.clear();
+  EXPECT_TRUE( column.empty() );
+  column.push_back( VarNumber( int32_t(-7) ) );
+  EXPECT_TRUE( column.isUniform() );
+  EXPECT_EQ( column[0].getTypeID(), INT32 );
+}
+
+TEST(VarNumberColumn, MixedTypes)
+{
+  std::vector<VarNumber> values = {
+    VarNumber( int8_t(-3) ), VarNumber( uint16_t(60000) ),
+    VarNumber( int32_t(-5) ), VarNumber( int32_t(6) ), VarNumber( int32_t(7) ),
+    VarNumber( int32_t(8) ), VarNumber( int32_t(-9) ),
+    VarNumber( uint64_t(1) << 50 ), VarNumber( double(0.25) ),
+    VarNumber( ros::Time(5, 500000000) ), VarNumber() };
+
+  VarNumberColumn column;
+  for (const VarNumber& value: values) column.push_back( value );
+  EXPECT_FALSE( column.isUniform() );
+
+  std::vector<double> output;
+  column.convertToDouble( &output );
+  ASSERT_EQ( output.size(), values.size() );
+  for (size_t i=0; i+1<values.size(); i++)
+  {
+    EXPECT_EQ( column[i].getTypeID(), values[i].getTypeID() );
+    EXPECT_EQ( output[i], values[i].convert<double>() );
+    EXPECT_EQ( column.get(i).convertLossy<double>(), output[i] );
+  }
+  EXPECT_TRUE( std::isnan( output.back() ) );
+
+  int16_t small = 0;
+  EXPECT_FALSE( column[1].tryConvert( small ) );
+  EXPECT_EQ( column[1].convertLossy<int16_t>(), 32767 );
+}
+
+TEST(VarNumberColumn, Set)
+{
+  std::vector<int16_t> values = { 1, 2, 3 };
+  VarNumberColumn column;
+  column.append( INT16, reinterpret_cast<const uint8_t*>(values.data()), values.size() );
+
+  column.set( 1, VarNumber( int16_t(-20) ) );
+  EXPECT_TRUE( column.isUniform() );
+  column.set( 2, VarNumber( double(1.5) ) );
+  EXPECT_FALSE( column.isUniform() );
+
+  EXPECT_EQ( column[0].convert<double>(), 1 );
+  EXPECT_EQ( column[1].convert<double>(), -20 );
+  EXPECT_EQ( column[2].convert<double>(), 1.5 );
+  EXPECT_THROW( column.append( STRING, nullptr, 1 ), TypeException );
+}
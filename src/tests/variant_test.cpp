@@ -0,0 +1,99 @@
+#include "config.h"
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <ros_type_introspection/variant.hpp>
+
+using namespace RosIntrospection;
+
+TEST(VarNumber, ConvertThrows)
+{
+  EXPECT_EQ( VarNumber( int32_t(100) ).convert<int8_t>(), 100 );
+  EXPECT_THROW( VarNumber( int32_t(1000) ).convert<int8_t>(), RangeException );
+  EXPECT_THROW( VarNumber( int32_t(-1) ).convert<uint32_t>(), RangeException );
+  EXPECT_THROW( VarNumber( uint32_t(4000000000u) ).convert<int32_t>(), RangeException );
+  EXPECT_THROW( VarNumber( double(1.5) ).convert<int32_t>(), RangeException );
+  EXPECT_THROW( VarNumber( double(1e10) ).convert<int32_t>(), RangeException );
+  EXPECT_THROW( VarNumber( double(NAN) ).convert<int32_t>(), RangeException );
+  EXPECT_THROW( VarNumber().convert<double>(), TypeException );
+}
+
+TEST(VarNumber, TryConvert)
+{
+  int8_t i8 = 7;
+  EXPECT_TRUE( VarNumber( int32_t(-100) ).tryConvert( i8 ) );
+  EXPECT_EQ( i8, -100 );
+  EXPECT_FALSE( VarNumber( int32_t(1000) ).tryConvert( i8 ) );
+  EXPECT_EQ( i8, -100 ); // unchanged
+
+  uint32_t u32 = 0;
+  EXPECT_FALSE( VarNumber( int64_t(-1) ).tryConvert( u32 ) );
+  EXPECT_TRUE( VarNumber( int64_t(4000000000ll) ).tryConvert( u32 ) );
+  EXPECT_EQ( u32, 4000000000u );
+
+  int32_t i32 = 0;
+  EXPECT_FALSE( VarNumber( uint32_t(4000000000u) ).tryConvert( i32 ) );
+  EXPECT_FALSE( VarNumber( double(2147483648.0) ).tryConvert( i32 ) );
+  EXPECT_TRUE( VarNumber( double(-2147483648.0) ).tryConvert( i32 ) );
+  EXPECT_EQ( i32, std::numeric_limits<int32_t>::min() );
+  EXPECT_FALSE( VarNumber( float(0.5) ).tryConvert( i32 ) );
+
+  float f = 0;
+  EXPECT_FALSE( VarNumber( double(0.1) ).tryConvert( f ) );
+  EXPECT_TRUE( VarNumber( double(0.5) ).tryConvert( f ) );
+  EXPECT_EQ( f, 0.5f );
+  EXPECT_TRUE( VarNumber( double(NAN) ).tryConvert( f ) );
+  EXPECT_TRUE( std::isnan(f) );
+
+  double d = 0;
+  EXPECT_TRUE( VarNumber( ros::Time(10, 500000000) ).tryConvert( d ) );
+  EXPECT_DOUBLE_EQ( d, 10.5 );
+  EXPECT_FALSE( VarNumber( ros::Time(10, 0) ).tryConvert( f ) );
+  EXPECT_FALSE( VarNumber().tryConvert( d ) );
+}
+
+TEST(VarNumber, ConvertLossy)
+{
+  EXPECT_EQ( VarNumber( int32_t(1000) ).convertLossy<int8_t>(), 127 );
+  EXPECT_EQ( VarNumber( int32_t(-1000) ).convertLossy<int8_t>(), -128 );
+  EXPECT_EQ( VarNumber( int32_t(-5) ).convertLossy<uint16_t>(), 0 );
+  EXPECT_EQ( VarNumber( uint64_t(1) << 40 ).convertLossy<int32_t>(), std::numeric_limits<int32_t>::max() );
+  EXPECT_EQ( VarNumber( uint64_t(-1) ).convertLossy<int64_t>(), std::numeric_limits<int64_t>::max() );
+  EXPECT_EQ( VarNumber( int64_t(-1) ).convertLossy<uint64_t>(), 0u );
+
+  EXPECT_EQ( VarNumber( double(-1.9) ).convertLossy<int32_t>(), -1 );
+  EXPECT_EQ( VarNumber( double(1e30) ).convertLossy<int64_t>(), std::numeric_limits<int64_t>::max() );
+  EXPECT_EQ( VarNumber( double(-1e30) ).convertLossy<int64_t>(), std::numeric_limits<int64_t>::min() );
+  EXPECT_EQ( VarNumber( float(-3.5) ).convertLossy<uint8_t>(), 0 );
+  EXPECT_EQ( VarNumber( double(NAN) ).convertLossy<int16_t>(), 0 );
+
+  EXPECT_EQ( VarNumber( double(0.1) ).convertLossy<float>(), 0.1f );
+  EXPECT_EQ( VarNumber( double(1e300) ).convertLossy<float>(), std::numeric_limits<float>::max() );
+  EXPECT_TRUE( std::isinf( VarNumber( double(INFINITY) ).convertLossy<float>() ) );
+  EXPECT_EQ( VarNumber( uint64_t(-1) ).convertLossy<double>(), 18446744073709551615.0 );
+
+  EXPECT_DOUBLE_EQ( VarNumber( ros::Time(3, 250000000) ).convertLossy<double>(), 3.25 );
+  EXPECT_EQ( VarNumber( ros::Time(3, 250000000) ).convertLossy<int32_t>(), 3 );
+
+  EXPECT_TRUE( std::isnan( VarNumber().convertLossy<double>() ) );
+  EXPECT_EQ( VarNumber().convertLossy<int32_t>(), 0 );
+}
+
+TEST(VarNumber, BulkConversion)
+{
+  std::vector<VarNumber> values = { VarNumber(int8_t(-1)), VarNumber(uint16_t(300)),
+                                    VarNumber(double(2.5)), VarNumber(float(7)),
+                                    VarNumber(int64_t(1) << 40) };
+
+  std::vector<int16_t> output( values.size(), 42 );
+  EXPECT_EQ( tryConvert( values.data(), values.size(), output.data() ), 2 );
+  EXPECT_EQ( output, std::vector<int16_t>({ -1, 300, 42, 7, 42 }) );
+
+  std::vector<uint8_t> saturated( values.size() );
+  convertLossy( values.data(), values.size(), saturated.data() );
+  EXPECT_EQ( saturated, std::vector<uint8_t>({ 0, 255, 2, 7, 255 }) );
+
+  std::vector<double> doubles( values.size() );
+  EXPECT_EQ( tryConvert( values.data(), values.size(), doubles.data() ), 0 );
+  EXPECT_EQ( doubles[4], 1099511627776.0 );
+}
@@ -0,0 +1,61 @@
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <ros_type_introspection/codegen.hpp>
+
+/*
+ * Generate a C++ header with a decoder specialized for a message type (see codegen.hpp).
+ *
+ * usage: ros_introspection_codegen <datatype> <md5sum> <definition_file> [output_file]
+ *
+ * The definition is the full text of the message definition, including the dependencies,
+ * as published in the connection header (for instance, the output of "gendeps --cat").
+ */
+
+int main( int argc, char** argv)
+{
+  if( argc != 4 && argc != 5 )
+  {
+    std::cerr << "usage: " << argv[0] << " <datatype> <md5sum> <definition_file> [output_file]" << std::endl;
+    return 1;
+  }
+  const std::string datatype( argv[1] );
+  const std::string md5sum( argv[2] );
+
+  std::ifstream definition_file( argv[3] );
+  if( !definition_file )
+  {
+    std::cerr << "can't open " << argv[3] << std::endl;
+    return 1;
+  }
+  std::stringstream definition;
+  definition << definition_file.rdbuf();
+
+  try{
+    RosIntrospection::ROSTypeList type_list =
+        RosIntrospection::buildROSTypeMapFromDefinition( datatype, definition.str() );
+
+    std::ostringstream output;
+    RosIntrospection::generateDecoder( type_list, RosIntrospection::ROSType(datatype), md5sum, output );
+
+    if( argc == 5 )
+    {
+      std::ofstream output_file( argv[4] );
+      output_file << output.str();
+      if( !output_file )
+      {
+        std::cerr << "can't write " << argv[4] << std::endl;
+        return 1;
+      }
+    }
+    else{
+      std::cout << output.str();
+    }
+  }
+  catch( std::exception& err )
+  {
+    std::cerr << err.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,240 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright 2016 Davide Faconti
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of Willow Garage, Inc. nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+********************************************************************/
+
+
+#include <algorithm>
+#include <cmath>
+#include "ros_type_introspection/variant_column.hpp"
+#include "ros_type_introspection/details/bulk_conversion.hpp"
+
+namespace RosIntrospection{
+
+namespace {
+
+// number of bytes of the value, 0 if it can't be stored in a VarNumber.
+inline size_t valueSize(BuiltinType type)
+{
+  return ( type < OTHER && BuiltinTypeSize[type] > 0 ) ? BuiltinTypeSize[type] : 0;
+}
+
+template <typename T>
+inline void slotsToDouble(const uint64_t* slots, size_t count, double* output)
+{
+  for (size_t i=0; i<count; i++)
+  {
+    T value;
+    memcpy( &value, &slots[i], sizeof(T) );
+    output[i] = static_cast<double>(value);
+  }
+}
+
+template <typename T>
+inline void timeSlotsToDouble(const uint64_t* slots, size_t count, double* output)
+{
+  for (size_t i=0; i<count; i++)
+  {
+    output[i] = reinterpret_cast<const T*>( &slots[i] )->toSec();
+  }
+}
+
+#if defined(__SSE2__)
+// The 4 bytes values in the lower half of four consecutive slots.
+inline __m128 loadLowHalves(const uint64_t* slots)
+{
+  const __m128 first  = _mm_loadu_ps( reinterpret_cast<const float*>(slots) );
+  const __m128 second = _mm_loadu_ps( reinterpret_cast<const float*>(slots + 2) );
+  return _mm_shuffle_ps( first, second, _MM_SHUFFLE(2,0,2,0) );
+}
+#endif
+
+void float32SlotsToDouble(const uint64_t* slots, size_t count, double* output)
+{
+  size_t i = 0;
+#if defined(__SSE2__)
+  for (; i + 4 <= count; i += 4)
+  {
+    const __m128 values = loadLowHalves( slots + i );
+    _mm_storeu_pd( output + i,     _mm_cvtps_pd(values) );
+    _mm_storeu_pd( output + i + 2, _mm_cvtps_pd( _mm_movehl_ps(values, values) ) );
+  }
+#endif
+  slotsToDouble<float>( slots + i, count - i, output + i );
+}
+
+void int32SlotsToDouble(const uint64_t* slots, size_t count, double* output)
+{
+  size_t i = 0;
+#if defined(__SSE2__)
+  for (; i + 4 <= count; i += 4)
+  {
+    details::storeInt32AsDouble( _mm_castps_si128( loadLowHalves( slots + i ) ), output + i );
+  }
+#endif
+  slotsToDouble<int32_t>( slots + i, count - i, output + i );
+}
+
+void slotsToDouble(BuiltinType type, const uint64_t* slots, size_t count, double* output)
+{
+  switch( type )
+  {
+  case INT8:     slotsToDouble<int8_t>( slots, count, output ); break;
+  case INT16:    slotsToDouble<int16_t>( slots, count, output ); break;
+  case INT32:    int32SlotsToDouble( slots, count, output ); break;
+  case INT64:    slotsToDouble<int64_t>( slots, count, output ); break;
+
+  case BOOL:
+  case BYTE:
+  case CHAR:
+  case UINT8:    slotsToDouble<uint8_t>( slots, count, output ); break;
+  case UINT16:   slotsToDouble<uint16_t>( slots, count, output ); break;
+  case UINT32:   slotsToDouble<uint32_t>( slots, count, output ); break;
+  case UINT64:   slotsToDouble<uint64_t>( slots, count, output ); break;
+
+  case FLOAT32:  float32SlotsToDouble( slots, count, output ); break;
+  case FLOAT64:  memcpy( output, slots, count * sizeof(double) ); break;
+
+  case DURATION: timeSlotsToDouble<ros::Duration>( slots, count, output ); break;
+  case TIME:     timeSlotsToDouble<ros::Time>( slots, count, output ); break;
+
+  default: std::fill( output, output + count, std::numeric_limits<double>::quiet_NaN() ); break;
+  }
+}
+
+} // end anonymous namespace
+
+void VarNumberColumn::clear()
+{
+  _payload.clear();
+  _types.clear();
+  _uniform_type = OTHER;
+}
+
+VarNumber VarNumberColumn::get(size_t index) const
+{
+  VarNumber output;
+  memcpy( output._raw_data, &_payload[index], 8 );
+  output._raw_data[8] = static_cast<uint8_t>( type(index) );
+  return output;
+}
+
+void VarNumberColumn::set(size_t index, const VarNumber& value)
+{
+  const BuiltinType value_type = value.getTypeID();
+  uint64_t slot = 0;
+  memcpy( &slot, value._raw_data, valueSize(value_type) );
+  _payload[index] = slot;
+
+  if( isUniform() )
+  {
+    if( value_type == _uniform_type ) return;
+    if( size() == 1 ){
+      _uniform_type = value_type;
+      return;
+    }
+    _types.assign( size(), static_cast<uint8_t>(_uniform_type) );
+  }
+  _types[index] = static_cast<uint8_t>(value_type);
+}
+
+void VarNumberColumn::pushType(BuiltinType type, size_t count)
+{
+  if( isUniform() )
+  {
+    if( empty() ) _uniform_type = type;
+    if( type == _uniform_type ) return;
+    _types.assign( size(), static_cast<uint8_t>(_uniform_type) );
+  }
+  _types.insert( _types.end(), count, static_cast<uint8_t>(type) );
+}
+
+void VarNumberColumn::push_back(const VarNumber& value)
+{
+  const BuiltinType value_type = value.getTypeID();
+  pushType( value_type, 1 );
+
+  uint64_t slot = 0;
+  memcpy( &slot, value._raw_data, valueSize(value_type) );
+  _payload.push_back( slot );
+}
+
+void VarNumberColumn::append(BuiltinType type, const uint8_t* data, size_t count)
+{
+  const size_t value_size = valueSize(type);
+  if( value_size == 0 )
+  {
+    throw TypeException("VarNumberColumn::append -> type without a fixed size");
+  }
+  if( count == 0 ) return;
+
+  pushType( type, count );
+
+  const size_t offset = _payload.size();
+  _payload.resize( offset + count, 0 );
+  if( value_size == 8 )
+  {
+    memcpy( &_payload[offset], data, count * 8 );
+    return;
+  }
+  for (size_t i=0; i<count; i++)
+  {
+    memcpy( &_payload[offset + i], data + i*value_size, value_size );
+  }
+}
+
+void VarNumberColumn::convertToDouble(double* output) const
+{
+  const size_t count = size();
+  if( isUniform() )
+  {
+    slotsToDouble( _uniform_type, _payload.data(), count, output );
+    return;
+  }
+  // convert each run of values with the same type at once
+  size_t first = 0;
+  while( first < count )
+  {
+    size_t last = first + 1;
+    while( last < count && _types[last] == _types[first] ) last++;
+    slotsToDouble( static_cast<BuiltinType>(_types[first]), &_payload[first], last - first, output + first );
+    first = last;
+  }
+}
+
+void VarNumberColumn::convertToDouble(std::vector<double>* output) const
+{
+  output->resize( size() );
+  convertToDouble( output->data() );
+}
+
+} //end namespace